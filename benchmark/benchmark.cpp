@@ -0,0 +1,164 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "benchmark.hpp"
+
+#include <boost/format.hpp>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+namespace {
+
+/** the benchmarks are single threaded, so a plain counter is enough */
+uint64_t g_alloc_count = 0;
+
+struct BenchmarkEntry
+{
+  const char* name;
+  BenchmarkFunc func;
+};
+
+std::vector<BenchmarkEntry>& get_benchmarks()
+{
+  static std::vector<BenchmarkEntry> benchmarks;
+  return benchmarks;
+}
+
+int64_t get_nsec()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/** minimum time of a run before its result is taken */
+const int64_t kMinTime = 200 * 1000 * 1000;
+
+} // namespace
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+  g_alloc_count += 1;
+  void* p = malloc(size ? size : 1);
+  if (!p)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc)
+{
+  return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+  free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+  free(p);
+}
+
+BenchmarkState::BenchmarkState(int64_t iterations) :
+  m_iterations(iterations),
+  m_count(0),
+  m_start_nsec(0),
+  m_nsec(0),
+  m_start_allocs(0),
+  m_allocs(0),
+  m_skipped(false)
+{
+}
+
+void
+BenchmarkState::start()
+{
+  m_start_allocs = g_alloc_count;
+  m_start_nsec = get_nsec();
+}
+
+void
+BenchmarkState::stop()
+{
+  m_nsec = get_nsec() - m_start_nsec;
+  m_allocs = g_alloc_count - m_start_allocs;
+}
+
+void
+BenchmarkState::skip(const char* reason)
+{
+  m_skipped = true;
+  std::cout << "# skipped: " << reason << std::endl;
+}
+
+int register_benchmark(const char* name, BenchmarkFunc func)
+{
+  BenchmarkEntry entry = { name, func };
+  get_benchmarks().push_back(entry);
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  // optional substring filter on the benchmark names
+  std::string filter = (argc > 1) ? argv[1] : "";
+
+  std::cout << boost::format("%-40s %12s %12s %12s") % "benchmark" % "iterations" % "ns/iter" % "allocs/iter" << std::endl;
+
+  for(std::vector<BenchmarkEntry>::const_iterator i = get_benchmarks().begin(); i != get_benchmarks().end(); ++i)
+  {
+    if (!filter.empty() && std::string(i->name).find(filter) == std::string::npos)
+    {
+      continue;
+    }
+
+    for(int64_t iterations = 1; ; iterations *= 10)
+    {
+      BenchmarkState state(iterations);
+      i->func(state);
+
+      if (state.is_skipped())
+      {
+        break;
+      }
+      else if (state.get_nsec() >= kMinTime || iterations >= 1000000000)
+      {
+        std::cout << boost::format("%-40s %12d %12.1f %12.2f")
+          % i->name
+          % iterations
+          % (static_cast<double>(state.get_nsec()) / static_cast<double>(iterations))
+          % (static_cast<double>(state.get_allocs()) / static_cast<double>(iterations))
+                  << std::endl;
+        break;
+      }
+    }
+  }
+
+  return 0;
+}
+
+/* EOF */
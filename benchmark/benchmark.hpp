@@ -0,0 +1,109 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_BENCHMARK_BENCHMARK_HPP
+#define HEADER_XBOXDRV_BENCHMARK_BENCHMARK_HPP
+
+#include <stdint.h>
+
+/**
+    A minimal harness in the spirit of Google Benchmark, a benchmark
+    is a function that runs its hot loop while keep_running() returns
+    true:
+
+      void BM_something(BenchmarkState& state)
+      {
+        setup();
+        while(state.keep_running())
+        {
+          do_work();
+        }
+      }
+      BENCHMARK(BM_something);
+
+    Setup outside of the loop is neither timed nor counted. The
+    harness raises the iteration count until a run takes long enough
+    and reports ns and heap allocations per iteration.
+ */
+class BenchmarkState
+{
+private:
+  int64_t m_iterations;
+  int64_t m_count;
+
+  int64_t m_start_nsec;
+  int64_t m_nsec;
+
+  uint64_t m_start_allocs;
+  uint64_t m_allocs;
+
+  bool m_skipped;
+
+public:
+  BenchmarkState(int64_t iterations);
+
+  bool keep_running()
+  {
+    if (m_count == 0)
+    {
+      start();
+    }
+
+    if (m_count < m_iterations)
+    {
+      m_count += 1;
+      return true;
+    }
+    else
+    {
+      stop();
+      return false;
+    }
+  }
+
+  /** Mark the benchmark as not runnable in this environment */
+  void skip(const char* reason);
+
+  int64_t get_iterations() const { return m_iterations; }
+  int64_t get_nsec() const { return m_nsec; }
+  uint64_t get_allocs() const { return m_allocs; }
+  bool is_skipped() const { return m_skipped; }
+
+private:
+  void start();
+  void stop();
+};
+
+typedef void (*BenchmarkFunc)(BenchmarkState& state);
+
+int register_benchmark(const char* name, BenchmarkFunc func);
+
+/** Keep the compiler from optimizing away a value that is never used */
+template<typename T>
+inline void benchmark_use(const T& value)
+{
+  __asm__ __volatile__("" : : "g"(&value) : "memory");
+}
+
+#define BENCHMARK(func) \
+  static int func##_registered = register_benchmark(#func, &func)
+
+#endif
+
+/* EOF */
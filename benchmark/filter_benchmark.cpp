@@ -0,0 +1,174 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <string.h>
+
+#include "benchmark.hpp"
+
+#include "axis_filter.hpp"
+#include "button_filter.hpp"
+#include "modifier.hpp"
+#include "modifier/axismap_modifier.hpp"
+#include "modifier/buttonmap_modifier.hpp"
+#include "xboxmsg.hpp"
+
+namespace {
+
+/** frames are benchmarked at 1 kHz */
+const int kUsecDelta = 1000;
+
+void run_axis_filter(BenchmarkState& state, const char* spec)
+{
+  AxisFilterPtr filter = AxisFilter::from_string(spec);
+
+  int64_t usec_time = 0;
+  int step = 0;
+  while(state.keep_running())
+  {
+    // sweep over the whole axis range
+    int value = ((step++ * 977) & 0xffff) - 32768;
+
+    usec_time += kUsecDelta;
+    filter->update(usec_time, kUsecDelta);
+    benchmark_use(filter->filter(value, -32768, 32767));
+  }
+}
+
+void run_button_filter(BenchmarkState& state, const char* spec)
+{
+  ButtonFilterPtr filter = ButtonFilter::from_string(spec);
+
+  int64_t usec_time = 0;
+  int frame = 0;
+  while(state.keep_running())
+  {
+    usec_time += kUsecDelta;
+    filter->update(usec_time, kUsecDelta);
+    benchmark_use(filter->filter((frame++ & 0x10) != 0));
+  }
+}
+
+void run_modifier(BenchmarkState& state, Modifier* modifier_ptr)
+{
+  ModifierPtr modifier(modifier_ptr);
+
+  XboxGenericMsg msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.type = XBOX_MSG_XBOX360;
+
+  int64_t usec_time = 0;
+  int value = 0;
+  while(state.keep_running())
+  {
+    // the modifier works in place, so start from fresh input each frame
+    set_axis(msg, XBOX_AXIS_X1, value);
+    set_axis(msg, XBOX_AXIS_Y1, -value);
+    set_button(msg, XBOX_DPAD_UP, value & 0x100);
+    set_button(msg, XBOX_DPAD_LEFT, value & 0x200);
+    set_button(msg, XBOX_BTN_A, value & 0x400);
+
+    usec_time += kUsecDelta;
+    modifier->update(usec_time, kUsecDelta, msg);
+    benchmark_use(msg);
+
+    value = (value + 331) & 0x7fff;
+  }
+}
+
+void BM_axis_filter_invert(BenchmarkState& state)      { run_axis_filter(state, "invert"); }
+void BM_axis_filter_calibration(BenchmarkState& state) { run_axis_filter(state, "cal:-30000:500:30000"); }
+void BM_axis_filter_sensitivity(BenchmarkState& state) { run_axis_filter(state, "sen:-0.5"); }
+void BM_axis_filter_deadzone(BenchmarkState& state)    { run_axis_filter(state, "dead:4000"); }
+void BM_axis_filter_const(BenchmarkState& state)       { run_axis_filter(state, "const:0"); }
+void BM_axis_filter_relative(BenchmarkState& state)    { run_axis_filter(state, "rel:2000"); }
+void BM_axis_filter_response(BenchmarkState& state)    { run_axis_filter(state, "resp:-32768:-4000:0:4000:32767"); }
+BENCHMARK(BM_axis_filter_invert);
+BENCHMARK(BM_axis_filter_calibration);
+BENCHMARK(BM_axis_filter_sensitivity);
+BENCHMARK(BM_axis_filter_deadzone);
+BENCHMARK(BM_axis_filter_const);
+BENCHMARK(BM_axis_filter_relative);
+BENCHMARK(BM_axis_filter_response);
+
+void BM_button_filter_toggle(BenchmarkState& state)   { run_button_filter(state, "toggle"); }
+void BM_button_filter_invert(BenchmarkState& state)   { run_button_filter(state, "invert"); }
+void BM_button_filter_const(BenchmarkState& state)    { run_button_filter(state, "const:1"); }
+void BM_button_filter_autofire(BenchmarkState& state) { run_button_filter(state, "auto:50"); }
+void BM_button_filter_delay(BenchmarkState& state)    { run_button_filter(state, "delay:100"); }
+void BM_button_filter_click(BenchmarkState& state)    { run_button_filter(state, "click-both"); }
+BENCHMARK(BM_button_filter_toggle);
+BENCHMARK(BM_button_filter_invert);
+BENCHMARK(BM_button_filter_const);
+BENCHMARK(BM_button_filter_autofire);
+BENCHMARK(BM_button_filter_delay);
+BENCHMARK(BM_button_filter_click);
+
+// "stat" is left out, it prints a table whenever it is destroyed
+
+void BM_modifier_dpad_rotation(BenchmarkState& state)
+{
+  run_modifier(state, Modifier::from_string("dpad-rotation", "45"));
+}
+BENCHMARK(BM_modifier_dpad_rotation);
+
+void BM_modifier_four_way_restrictor(BenchmarkState& state)
+{
+  run_modifier(state, Modifier::from_string("four-way-restrictor", "x1:y1"));
+}
+BENCHMARK(BM_modifier_four_way_restrictor);
+
+void BM_modifier_square_axis(BenchmarkState& state)
+{
+  run_modifier(state, Modifier::from_string("square", "x1:y1"));
+}
+BENCHMARK(BM_modifier_square_axis);
+
+void BM_modifier_rotate(BenchmarkState& state)
+{
+  run_modifier(state, Modifier::from_string("rotate", "x1:y1:45"));
+}
+BENCHMARK(BM_modifier_rotate);
+
+void BM_modifier_dpad_restrictor(BenchmarkState& state)
+{
+  run_modifier(state, Modifier::from_string("dpad-restrictor", "fourway"));
+}
+BENCHMARK(BM_modifier_dpad_restrictor);
+
+void BM_modifier_axismap(BenchmarkState& state)
+{
+  AxismapModifier* modifier = new AxismapModifier;
+  modifier->add(AxisMapping::from_string("-y1^dead:4000", "x1"));
+  modifier->add(AxisMapping::from_string("x1", "y1"));
+  run_modifier(state, modifier);
+}
+BENCHMARK(BM_modifier_axismap);
+
+void BM_modifier_buttonmap(BenchmarkState& state)
+{
+  ButtonmapModifier* modifier = new ButtonmapModifier;
+  modifier->add(ButtonMapping::from_string("a^toggle", "b"));
+  modifier->add(ButtonMapping::from_string("du", "a"));
+  run_modifier(state, modifier);
+}
+BENCHMARK(BM_modifier_buttonmap);
+
+} // namespace
+
+/* EOF */
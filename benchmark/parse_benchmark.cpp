@@ -0,0 +1,148 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <string.h>
+
+#include "benchmark.hpp"
+
+#include "playstation3_usb_controller.hpp"
+#include "xbox360_controller.hpp"
+#include "xbox_controller.hpp"
+#include "xboxmsg.hpp"
+
+namespace {
+
+/** a report with all sticks off center and a few buttons held */
+const uint8_t kXbox360Report[20] = {
+  0x00, 0x14, 0x41, 0x30, 0x80, 0x10, 0x34, 0x12, 0xcc, 0xed,
+  0x00, 0x40, 0x00, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const uint8_t kXboxReport[20] = {
+  0x00, 0x14, 0x05, 0x00, 0xff, 0x00, 0x80, 0x00, 0x00, 0x00,
+  0x40, 0x20, 0x34, 0x12, 0xcc, 0xed, 0x00, 0x40, 0x00, 0xc0
+};
+
+void BM_xbox360_parse(BenchmarkState& state)
+{
+  // offline controller, no USB device needed
+  Xbox360Controller controller(0, false, false, false, false, false, "", "", false);
+
+  uint8_t data[sizeof(kXbox360Report)];
+  memcpy(data, kXbox360Report, sizeof(data));
+
+  XboxGenericMsg msg;
+  while(state.keep_running())
+  {
+    controller.parse(data, sizeof(data), &msg);
+    benchmark_use(msg);
+  }
+}
+BENCHMARK(BM_xbox360_parse);
+
+void BM_xbox_parse(BenchmarkState& state)
+{
+  XboxController controller(0, false);
+
+  uint8_t data[sizeof(kXboxReport)];
+  memcpy(data, kXboxReport, sizeof(data));
+
+  XboxGenericMsg msg;
+  while(state.keep_running())
+  {
+    controller.parse(data, sizeof(data), &msg);
+    benchmark_use(msg);
+  }
+}
+BENCHMARK(BM_xbox_parse);
+
+void BM_playstation3_usb_parse(BenchmarkState& state)
+{
+  Playstation3USBController controller(0, false);
+
+  uint8_t data[64];
+  memset(data, 0x5a, sizeof(data));
+
+  XboxGenericMsg msg;
+  while(state.keep_running())
+  {
+    controller.parse(data, sizeof(data), &msg);
+    benchmark_use(msg);
+  }
+}
+BENCHMARK(BM_playstation3_usb_parse);
+
+void BM_get_axis(BenchmarkState& state)
+{
+  XboxGenericMsg msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.type = XBOX_MSG_XBOX360;
+
+  while(state.keep_running())
+  {
+    int sum = 0;
+    for(int axis = XBOX_AXIS_UNKNOWN + 1; axis < XBOX_AXIS_MAX; ++axis)
+    {
+      sum += get_axis(msg, static_cast<XboxAxis>(axis));
+    }
+    benchmark_use(sum);
+  }
+}
+BENCHMARK(BM_get_axis);
+
+void BM_set_axis(BenchmarkState& state)
+{
+  XboxGenericMsg msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.type = XBOX_MSG_XBOX360;
+
+  int value = 0;
+  while(state.keep_running())
+  {
+    for(int axis = XBOX_AXIS_UNKNOWN + 1; axis < XBOX_AXIS_MAX; ++axis)
+    {
+      set_axis(msg, static_cast<XboxAxis>(axis), value);
+    }
+    value = (value + 1) & 0x7f;
+    benchmark_use(msg);
+  }
+}
+BENCHMARK(BM_set_axis);
+
+void BM_get_button(BenchmarkState& state)
+{
+  XboxGenericMsg msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.type = XBOX_MSG_XBOX360;
+
+  while(state.keep_running())
+  {
+    int sum = 0;
+    for(int btn = XBOX_BTN_UNKNOWN + 1; btn < XBOX_BTN_MAX; ++btn)
+    {
+      sum += get_button(msg, static_cast<XboxButton>(btn));
+    }
+    benchmark_use(sum);
+  }
+}
+BENCHMARK(BM_get_button);
+
+} // namespace
+
+/* EOF */
@@ -0,0 +1,185 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <boost/scoped_ptr.hpp>
+#include <exception>
+#include <string.h>
+
+#include "benchmark.hpp"
+
+#include "command_line_options.hpp"
+#include "controller_config.hpp"
+#include "controller_slot_config.hpp"
+#include "options.hpp"
+#include "uinput.hpp"
+#include "uinput_config.hpp"
+#include "uinput_message_processor.hpp"
+#include "xbox360_controller.hpp"
+#include "xboxmsg.hpp"
+
+namespace {
+
+const int kUsecDelta = 1000;
+
+const uint8_t kXbox360Report[20] = {
+  0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+/** Sets up UInput with the configuration of a command line, the
+    config files are relative to the source directory, so run the
+    benchmarks from there. Events go to the null backend, so only
+    the processing is measured and no /dev/uinput is needed. */
+class Pipeline
+{
+public:
+  Options opts;
+  boost::scoped_ptr<UInput> uinput;
+  ControllerSlotConfigPtr config;
+
+  Pipeline() : opts(), uinput(), config() {}
+
+  bool init(BenchmarkState& state, const char* config_file)
+  {
+    try
+    {
+      std::vector<const char*> args;
+      args.push_back("xboxdrv");
+      args.push_back("--silent");
+      args.push_back("--uinput-backend");
+      args.push_back("null");
+      if (config_file)
+      {
+        args.push_back("--config");
+        args.push_back(config_file);
+      }
+
+      CommandLineParser parser;
+      parser.parse_args(static_cast<int>(args.size()), const_cast<char**>(&args[0]), &opts);
+
+      uinput.reset(new UInput(opts.extra_events));
+      uinput->set_backend(opts.uinput_backend);
+      config = ControllerSlotConfig::create(*uinput, 0, opts.extra_devices, opts.get_controller_slot());
+      uinput->finish();
+      return true;
+    }
+    catch(const std::exception& err)
+    {
+      state.skip(err.what());
+      return false;
+    }
+  }
+};
+
+/** Changes sticks, triggers and a few buttons from frame to frame */
+void animate_report(uint8_t* data, int frame)
+{
+  data[2] = static_cast<uint8_t>((frame >> 4) & 0x0f);
+  data[3] = static_cast<uint8_t>((frame >> 3) & 0xf3);
+  data[4] = static_cast<uint8_t>(frame * 7);
+  data[5] = static_cast<uint8_t>(frame * 5);
+  for(int i = 6; i < 14; i += 2)
+  {
+    int16_t value = static_cast<int16_t>(frame * (i * 131));
+    data[i]   = static_cast<uint8_t>(value & 0xff);
+    data[i+1] = static_cast<uint8_t>((value >> 8) & 0xff);
+  }
+}
+
+void run_uinput_config(BenchmarkState& state, const char* config_file)
+{
+  Pipeline pipeline;
+  if (!pipeline.init(state, config_file))
+  {
+    return;
+  }
+
+  Xbox360Controller controller(0, false, false, false, false, false, "", "", false);
+  UInputConfig& uinput_config = pipeline.config->get_config()->get_uinput();
+
+  uint8_t data[sizeof(kXbox360Report)];
+  memcpy(data, kXbox360Report, sizeof(data));
+
+  int frame = 0;
+  XboxGenericMsg msg;
+  while(state.keep_running())
+  {
+    animate_report(data, frame++);
+    controller.parse(data, sizeof(data), &msg);
+    uinput_config.send(msg);
+  }
+}
+
+/** Forwards parsed messages to the processor, as ControllerThread does */
+struct FrameSink
+{
+  UInputMessageProcessor* processor;
+  const int64_t* usec_time;
+
+  void operator()(const XboxGenericMsg& msg) const
+  {
+    processor->send(msg, *usec_time, kUsecDelta);
+  }
+};
+
+void run_frame(BenchmarkState& state, const char* config_file)
+{
+  Pipeline pipeline;
+  if (!pipeline.init(state, config_file))
+  {
+    return;
+  }
+
+  Xbox360Controller controller(0, false, false, false, false, false, "", "", false);
+  UInputMessageProcessor processor(*pipeline.uinput, pipeline.config, 0, pipeline.opts);
+
+  int64_t usec_time = 0;
+  FrameSink sink = { &processor, &usec_time };
+  controller.set_message_cb(sink);
+  controller.set_ready();
+
+  uint8_t data[sizeof(kXbox360Report)];
+  memcpy(data, kXbox360Report, sizeof(data));
+
+  int frame = 0;
+  while(state.keep_running())
+  {
+    animate_report(data, frame++);
+    usec_time += kUsecDelta;
+    controller.inject_report(data, sizeof(data));
+  }
+}
+
+void BM_uinput_config_default(BenchmarkState& state) { run_uinput_config(state, 0); }
+void BM_uinput_config_mouse(BenchmarkState& state)   { run_uinput_config(state, "examples/mouse.xboxdrv"); }
+void BM_uinput_config_warsow(BenchmarkState& state)  { run_uinput_config(state, "examples/warsow.xboxdrv"); }
+BENCHMARK(BM_uinput_config_default);
+BENCHMARK(BM_uinput_config_mouse);
+BENCHMARK(BM_uinput_config_warsow);
+
+void BM_frame_default(BenchmarkState& state) { run_frame(state, 0); }
+void BM_frame_mouse(BenchmarkState& state)   { run_frame(state, "examples/mouse.xboxdrv"); }
+void BM_frame_warsow(BenchmarkState& state)  { run_frame(state, "examples/warsow.xboxdrv"); }
+BENCHMARK(BM_frame_default);
+BENCHMARK(BM_frame_mouse);
+BENCHMARK(BM_frame_warsow);
+
+} // namespace
+
+/* EOF */
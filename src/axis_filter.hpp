@@ -36,7 +36,7 @@ public:
   AxisFilter() {}
   virtual ~AxisFilter() {}
 
-  virtual void update(int msec_delta) {}
+  virtual void update(int64_t usec_time, int usec_delta) {}
   virtual int filter(int value, int min, int max) = 0;
   virtual std::string str() const = 0;
 };
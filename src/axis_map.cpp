@@ -76,7 +76,7 @@ AxisMap::init(UInput& uinput, int slot, bool extra_devices) const
 }
 
 void
-AxisMap::update(UInput& uinput, int msec_delta)
+AxisMap::update(UInput& uinput, int64_t usec_time, int usec_delta)
 {
   for(int shift_code = 0; shift_code < XBOX_BTN_MAX; ++shift_code)
   {
@@ -84,7 +84,7 @@ AxisMap::update(UInput& uinput, int msec_delta)
     {
       if (m_axis_map[shift_code][code])
       {
-        m_axis_map[shift_code][code]->update(uinput, msec_delta);
+        m_axis_map[shift_code][code]->update(uinput, usec_time, usec_delta);
       }
     }
   }
@@ -39,7 +39,7 @@ public:
   void clear();
 
   void init(UInput& uinput, int slot, bool extra_devices) const;
-  void update(UInput& uinput, int msec_delta);
+  void update(UInput& uinput, int64_t usec_time, int usec_delta);
 };
 
 #endif
@@ -92,7 +92,7 @@ AbsAxisEventHandler::send(UInput& uinput, int value)
 }
 
 void
-AbsAxisEventHandler::update(UInput& uinput, int msec_delta)
+AbsAxisEventHandler::update(UInput& uinput, int64_t usec_time, int usec_delta)
 {
 }
 
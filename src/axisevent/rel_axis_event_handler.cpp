@@ -19,7 +19,6 @@
 #include "axisevent/rel_axis_event_handler.hpp"
 
 #include <boost/tokenizer.hpp>
-#include <math.h>
 
 #include "evdev_helper.hpp"
 #include "uinput.hpp"
@@ -67,7 +66,6 @@ RelAxisEventHandler::RelAxisEventHandler() :
   m_value(5),
   m_repeat(10),
   m_stick_value(0.0f),
-  m_rest_value(0.0f),
   m_rel_emitter()
 {
 }
@@ -77,7 +75,6 @@ RelAxisEventHandler::RelAxisEventHandler(int device_id, int code, int repeat, fl
   m_value(value),
   m_repeat(repeat),
   m_stick_value(0.0f),
-  m_rest_value(0.0f),
   m_rel_emitter()
 {
 }
@@ -107,23 +104,18 @@ RelAxisEventHandler::send(UInput& uinput, int value)
     else
       uinput.send_rel_repetitive(m_code, v, m_repeat);
   }
+  else
+  {
+    // new and improved REL style event sending, the device moves
+    // continuously at its own output rate, independent of how often
+    // the controller sends data
+    m_rel_emitter->set_velocity(m_stick_value * m_value);
+  }
 }
 
 void
-RelAxisEventHandler::update(UInput& uinput, int msec_delta)
+RelAxisEventHandler::update(UInput& uinput, int64_t usec_time, int usec_delta)
 {
-  if (m_repeat == -1 && m_stick_value != 0.0f)
-  {
-    // new and improved REL style event sending
-
-    float rel_value = m_stick_value * m_value * static_cast<float>(msec_delta) / 1000.0f;
-
-    // keep track of the rest that we lose when converting to integer
-    rel_value += m_rest_value;
-    m_rest_value = rel_value - truncf(rel_value);
-
-    m_rel_emitter->send(static_cast<int>(rel_value));
-  }
 }
 
 std::string
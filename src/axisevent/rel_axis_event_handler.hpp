@@ -21,7 +21,7 @@
 
 #include "axis_event.hpp"
 
-#include "ui_event_emitter.hpp"
+#include "ui_rel_event_emitter.hpp"
 
 class RelAxisEventHandler : public AxisEventHandler
 {
@@ -34,7 +34,7 @@ public:
 
   void init(UInput& uinput, int slot, bool extra_devices);
   void send(UInput& uinput, int value);
-  void update(UInput& uinput, int msec_delta);
+  void update(UInput& uinput, int64_t usec_time, int usec_delta);
 
   std::string str() const;
 
@@ -44,9 +44,8 @@ private:
   int     m_repeat;
 
   float   m_stick_value;
-  float   m_rest_value;
 
-  UIEventEmitterPtr m_rel_emitter;
+  UIRelEventEmitterPtr m_rel_emitter;
 };
 
 #endif
@@ -85,10 +85,10 @@ RelRepeatAxisEventHandler::send(UInput& uinput, int value)
 }
 
 void
-RelRepeatAxisEventHandler::update(UInput& uinput, int msec_delta)
+RelRepeatAxisEventHandler::update(UInput& uinput, int64_t usec_time, int usec_delta)
 {
   // time ticks slower depending on how fr the stick is moved
-  m_timer += msec_delta * fabsf(m_stick_value);
+  m_timer += static_cast<float>(usec_delta) / 1000.0f * fabsf(m_stick_value);
 
   while(m_timer > m_repeat)
   {
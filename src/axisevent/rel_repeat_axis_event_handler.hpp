@@ -33,7 +33,7 @@ public:
 
   void init(UInput& uinput, int slot, bool extra_devices);
   void send(UInput& uinput, int value);
-  void update(UInput& uinput, int msec_delta);
+  void update(UInput& uinput, int64_t usec_time, int usec_delta);
 
   std::string str() const;
 
@@ -43,7 +43,7 @@ private:
   float   m_repeat;
 
   float   m_stick_value;
-  int     m_timer;
+  float   m_timer;
 
   UIEventEmitterPtr m_rel_emitter;
 };
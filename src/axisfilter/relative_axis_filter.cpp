@@ -52,9 +52,9 @@ RelativeAxisFilter::RelativeAxisFilter(int speed) :
 }
 
 void
-RelativeAxisFilter::update(int msec_delta)
+RelativeAxisFilter::update(int64_t usec_time, int usec_delta)
 {
-  m_state += m_float_speed * m_value * msec_delta / 1000.0f;
+  m_state += m_float_speed * m_value * static_cast<float>(usec_delta) / 1000000.0f;
   m_state = Math::clamp(-1.0f, m_state, 1.0f);
 }
 
@@ -29,7 +29,7 @@ public:
 public:
   RelativeAxisFilter(int speed);
 
-  void update(int msec_delta);
+  void update(int64_t usec_time, int usec_delta);
   int filter(int value, int min, int max);
   std::string str() const;
 
@@ -36,7 +36,7 @@ public:
   virtual ~ButtonFilter() {}
 
   virtual bool filter(bool value) =0;
-  virtual void update(int msec_delta) {}
+  virtual void update(int64_t usec_time, int usec_delta) {}
   virtual std::string str() const = 0;
 };
 
@@ -21,7 +21,6 @@
 #include <boost/tokenizer.hpp>
 #include <stdexcept>
 
-#include "ui_event_sequence.hpp"
 #include "raise_exception.hpp"
 
 std::map<std::string, CycleKeySequencePtr> CycleKeyButtonEventHandler::s_lookup_table;
@@ -76,13 +75,20 @@ CycleKeyButtonEventHandler::from_string_named(const std::string& value, bool wra
     // if name is empty, don't put it in the lookup table
     if (!name.empty())
     {
-      if (lookup(name) != 0)
+      CycleKeySequencePtr existing = lookup(name);
+      if (!existing)
       {
-        raise_exception(std::runtime_error, "duplicate name entry");
+        s_lookup_table.insert(std::pair<std::string, CycleKeySequencePtr>(name, sequence));
+      }
+      else if (existing->get_source() == sequence->get_source())
+      {
+        // the same group defined again, e.g. in the config of another
+        // slot, share the existing one
+        sequence = existing;
       }
       else
       {
-        s_lookup_table.insert(std::pair<std::string, CycleKeySequencePtr>(name, sequence));
+        raise_exception(std::runtime_error, "duplicate name entry: " << name);
       }
     }
 
@@ -137,6 +143,7 @@ CycleKeyButtonEventHandler::CycleKeyButtonEventHandler(CycleKeySequencePtr seque
                                                        Direction direction,
                                                        bool send_press) :
   m_sequence(sequence),
+  m_state(0),
   m_direction(direction),
   m_send_press(send_press)
 {
@@ -145,8 +152,8 @@ CycleKeyButtonEventHandler::CycleKeyButtonEventHandler(CycleKeySequencePtr seque
 void
 CycleKeyButtonEventHandler::init(UInput& uinput, int slot, bool extra_devices)
 {
-  // CycleKeySequence will make sure that init() is only called once
-  m_sequence->init(uinput, slot, extra_devices);
+  // handlers of the same group in the same slot share one state
+  m_state = m_sequence->init(uinput, slot, extra_devices);
 }
 
 void
@@ -154,20 +161,20 @@ CycleKeyButtonEventHandler::send(UInput& uinput, bool value)
 {
   if (value)
   {
-    if (m_send_press && m_sequence->has_current_key())
+    if (m_send_press && m_state->has_current_key())
     {
-      m_sequence->send(uinput, value);
+      m_state->send(value);
     }
     else
     {
       switch(m_direction)
       {
         case kBackward:
-          m_sequence->prev_key();
+          m_state->prev_key();
           break;
 
         case kForward:
-          m_sequence->next_key();
+          m_state->next_key();
           break;
 
         case kNone:
@@ -176,7 +183,7 @@ CycleKeyButtonEventHandler::send(UInput& uinput, bool value)
 
       if (m_send_press)
       {
-        m_sequence->send(uinput, value);
+        m_state->send(value);
       }
     }
   }
@@ -184,13 +191,13 @@ CycleKeyButtonEventHandler::send(UInput& uinput, bool value)
   {
     if (m_send_press)
     {
-      m_sequence->send(uinput, value);
+      m_state->send(value);
     }
   }
 }
 
 void
-CycleKeyButtonEventHandler::update(UInput& uinput, int msec_delta)
+CycleKeyButtonEventHandler::update(UInput& uinput, int64_t usec_time, int usec_delta)
 {
 }
 
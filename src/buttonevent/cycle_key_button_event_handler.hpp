@@ -22,8 +22,6 @@
 #include <map>
 
 #include "button_event.hpp"
-#include "ui_event_sequence.hpp"
-
 #include "buttonevent/cycle_key_sequence.hpp"
 
 class CycleKeyButtonEventHandler : public ButtonEventHandler
@@ -54,6 +52,10 @@ public:
 
 private:
   CycleKeySequencePtr m_sequence;
+
+  /** the per-slot state of m_sequence, resolved in init() */
+  CycleKeyState* m_state;
+
   Direction m_direction;
   bool m_send_press;
 
@@ -63,7 +65,7 @@ private:
 public:
   void init(UInput& uinput, int slot, bool extra_devices);
   void send(UInput& uinput, bool value);
-  void update(UInput& uinput, int msec_delta);
+  void update(UInput& uinput, int64_t usec_time, int usec_delta);
 
   std::string str() const;
 
@@ -18,74 +18,142 @@
 
 #include "buttonevent/cycle_key_sequence.hpp"
 
+#include <assert.h>
+#include <boost/tokenizer.hpp>
 #include <stdexcept>
 
+#include "evdev_helper.hpp"
 #include "raise_exception.hpp"
+#include "uinput.hpp"
 
 CycleKeySequencePtr
 CycleKeySequence::from_range(std::vector<std::string>::const_iterator beg,
                              std::vector<std::string>::const_iterator end,
                              bool wrap_around)
 {
-  Keys keys;
+  typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+
+  std::vector<UIEvent> events;
+  std::vector<int> offsets;
+  std::string source = wrap_around ? "cycle" : "sequence";
 
   for(std::vector<std::string>::const_iterator i = beg; i != end; ++i)
   {
-    keys.push_back(UIEventSequence::from_string(*i));
+    offsets.push_back(static_cast<int>(events.size()));
+
+    tokenizer ev_tokens(*i, boost::char_separator<char>("+", "", boost::keep_empty_tokens));
+    for(tokenizer::iterator m = ev_tokens.begin(); m != ev_tokens.end(); ++m)
+    {
+      events.push_back(str2key_event(*m));
+    }
+
+    source += ":" + *i;
   }
 
-  if (keys.empty())
+  if (offsets.empty())
   {
     raise_exception(std::runtime_error, "no keys found");
   }
   else
   {
-    return CycleKeySequencePtr(new CycleKeySequence(keys, wrap_around));
+    offsets.push_back(static_cast<int>(events.size()));
+    return CycleKeySequencePtr(new CycleKeySequence(events, offsets, wrap_around, source));
   }
 }
 
-CycleKeySequence::CycleKeySequence(const Keys& keys, bool wrap_around) :
-  m_keys(keys),
+CycleKeySequence::CycleKeySequence(const std::vector<UIEvent>& events,
+                                   const std::vector<int>& offsets,
+                                   bool wrap_around,
+                                   const std::string& source) :
+  m_events(events),
+  m_offsets(offsets),
   m_wrap_around(wrap_around),
-  m_inited(false),
-  m_current_key(0),
-  m_last_key(0)
+  m_source(source),
+  m_states()
 {
-  assert(!m_keys.empty());
+  assert(m_offsets.size() >= 2);
 }
 
-void
+CycleKeyState*
 CycleKeySequence::init(UInput& uinput, int slot, bool extra_devices)
 {
-  if (!m_inited)
+  States::iterator it = m_states.find(slot);
+  if (it != m_states.end())
   {
-    for(Keys::iterator i = m_keys.begin(); i != m_keys.end(); ++i)
+    return it->second.get();
+  }
+  else
+  {
+    std::vector<UIEventEmitterPtr> emitters;
+    emitters.reserve(m_events.size());
+
+    for(std::vector<UIEvent>::const_iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
-      i->init(uinput, slot, extra_devices);
+      // resolve a copy, the definition is shared between slots
+      UIEvent ev = *i;
+      ev.resolve_device_id(slot, extra_devices);
+      emitters.push_back(uinput.add_key(ev.get_device_id(), ev.code));
     }
-    m_inited = true;
+
+    CycleKeyStatePtr state(new CycleKeyState(*this, emitters));
+    m_states[slot] = state;
+    return state.get();
+  }
+}
+
+CycleKeyState::CycleKeyState(const CycleKeySequence& sequence,
+                             const std::vector<UIEventEmitterPtr>& emitters) :
+  m_sequence(sequence),
+  m_emitter_refs(emitters),
+  m_emitters(),
+  m_current_key(0),
+  m_last_key(0)
+{
+  m_emitters.reserve(m_emitter_refs.size());
+  for(std::vector<UIEventEmitterPtr>::const_iterator i = m_emitter_refs.begin(); i != m_emitter_refs.end(); ++i)
+  {
+    m_emitters.push_back(i->get());
   }
 }
 
 void
-CycleKeySequence::send(UInput& uinput, bool value)
+CycleKeyState::send(bool value)
 {
   int send_key = has_current_key() ? m_current_key : m_last_key;
 
-  m_keys[send_key].send(uinput, value);
+  const std::vector<int>& offsets = m_sequence.get_offsets();
+  UIEventEmitter* const* beg = &m_emitters[0] + offsets[send_key];
+  UIEventEmitter* const* end = &m_emitters[0] + offsets[send_key+1];
+
+  if (value)
+  {
+    for(UIEventEmitter* const* i = beg; i != end; ++i)
+    {
+      (*i)->send(1);
+    }
+  }
+  else
+  {
+    // on release, send events in reverse order
+    for(UIEventEmitter* const* i = end; i != beg; )
+    {
+      --i;
+      (*i)->send(0);
+    }
+  }
 
   m_last_key = send_key;
   m_current_key = -1;
 }
 
 void
-CycleKeySequence::next_key()
+CycleKeyState::next_key()
 {
   if (has_current_key())
   {
-    if (m_current_key == static_cast<int>(m_keys.size() - 1))
+    if (m_current_key == m_sequence.get_key_count() - 1)
     {
-      if (m_wrap_around)
+      if (m_sequence.get_wrap_around())
       {
         m_current_key = 0;
       }
@@ -103,15 +171,15 @@ CycleKeySequence::next_key()
 }
 
 void
-CycleKeySequence::prev_key()
+CycleKeyState::prev_key()
 {
   if (has_current_key())
   {
     if (m_current_key == 0)
     {
-      if (m_wrap_around)
+      if (m_sequence.get_wrap_around())
       {
-        m_current_key = static_cast<int>(m_keys.size() - 1);
+        m_current_key = m_sequence.get_key_count() - 1;
       }
     }
     else
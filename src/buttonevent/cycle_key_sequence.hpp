@@ -20,14 +20,26 @@
 #define HEADER_XBOXDRV_BUTTONEVENT_CYCLE_KEY_SEQUENCE_HPP
 
 #include <boost/shared_ptr.hpp>
+#include <map>
+#include <string>
 #include <vector>
 
-#include "ui_event_sequence.hpp"
+#include "ui_event.hpp"
+#include "ui_event_emitter.hpp"
 
+class UInput;
 class CycleKeySequence;
+class CycleKeyState;
 
 typedef boost::shared_ptr<CycleKeySequence> CycleKeySequencePtr;
-
+typedef boost::shared_ptr<CycleKeyState> CycleKeyStatePtr;
+
+/**
+    The definition of a cycle-key group, the parsed keys are stored
+    back-to-back in a single array. A named group is shared by all
+    slots that refer to it, each slot gets its own CycleKeyState with
+    its own emitters and cursor.
+ */
 class CycleKeySequence
 {
 public:
@@ -36,13 +48,51 @@ public:
                                         bool wrap_around);
 
 private:
-  typedef std::vector<UIEventSequence> Keys;
-  Keys m_keys;
+  /** all events of all keys, key i covers [m_offsets[i], m_offsets[i+1]) */
+  std::vector<UIEvent> m_events;
+  std::vector<int> m_offsets;
 
   /** If set the sequence wraps around when at the begin/end */
   bool m_wrap_around;
 
-  bool m_inited;
+  /** textual form of the definition, used to detect redefinitions */
+  std::string m_source;
+
+  typedef std::map<int, CycleKeyStatePtr> States;
+  States m_states;
+
+public:
+  CycleKeySequence(const std::vector<UIEvent>& events,
+                   const std::vector<int>& offsets,
+                   bool wrap_around,
+                   const std::string& source);
+
+  int get_key_count() const { return static_cast<int>(m_offsets.size()) - 1; }
+  const std::vector<int>& get_offsets() const { return m_offsets; }
+  bool get_wrap_around() const { return m_wrap_around; }
+  const std::string& get_source() const { return m_source; }
+
+  /** Resolves the emitters for \a slot, repeated calls for the same
+      slot return the same state */
+  CycleKeyState* init(UInput& uinput, int slot, bool extra_devices);
+
+private:
+  CycleKeySequence(const CycleKeySequence&);
+  CycleKeySequence& operator=(const CycleKeySequence&);
+};
+
+/**
+    The per-slot part of a CycleKeySequence, pressing or releasing a
+    key is a loop over a slice of a flat emitter array.
+ */
+class CycleKeyState
+{
+private:
+  const CycleKeySequence& m_sequence;
+
+  /** keeps the emitters alive, m_emitters is what send() walks */
+  std::vector<UIEventEmitterPtr> m_emitter_refs;
+  std::vector<UIEventEmitter*> m_emitters;
 
   /** the position of the cursor in the sequence, if -1, it is unset */
   int m_current_key;
@@ -51,19 +101,19 @@ private:
   int m_last_key;
 
 public:
-  CycleKeySequence(const Keys& keys, bool wrap_around);
+  CycleKeyState(const CycleKeySequence& sequence,
+                const std::vector<UIEventEmitterPtr>& emitters);
 
   bool has_current_key() const { return m_current_key != -1; }
 
   void next_key();
   void prev_key();
 
-  void init(UInput& uinput, int slot, bool extra_devices);
-  void send(UInput& uinput, bool value);
+  void send(bool value);
 
 private:
-  CycleKeySequence(const CycleKeySequence&);
-  CycleKeySequence& operator=(const CycleKeySequence&);
+  CycleKeyState(const CycleKeyState&);
+  CycleKeyState& operator=(const CycleKeyState&);
 };
 
 #endif
@@ -31,12 +31,15 @@ public:
 
   void init(UInput& uinput, int slot, bool extra_devices);
   void send(UInput& uinput, bool value);
-  void update(UInput& uinput, int msec_delta) {}
+  void update(UInput& uinput, int64_t usec_time, int usec_delta) {}
 
   std::string str() const;
 
 private:
   std::vector<std::string> m_args;
+
+  /** m_args encoded for the SpawnService */
+  std::string m_request;
 };
 
 #endif
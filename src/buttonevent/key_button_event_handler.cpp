@@ -113,7 +113,7 @@ KeyButtonEventHandler::send(UInput& uinput, bool value)
     }
     else
     {
-      if (m_hold_counter < m_hold_threshold)
+      if (m_hold_counter < static_cast<int64_t>(m_hold_threshold) * 1000)
       {
         if (m_state)
         {
@@ -148,21 +148,23 @@ KeyButtonEventHandler::send(UInput& uinput, bool value)
 }
 
 void
-KeyButtonEventHandler::update(UInput& uinput, int msec_delta)
+KeyButtonEventHandler::update(UInput& uinput, int64_t usec_time, int usec_delta)
 {
   if (m_state && m_hold_threshold)
   {
-    if (m_hold_counter < m_hold_threshold &&
-        m_hold_counter + msec_delta >= m_hold_threshold)
+    const int64_t hold_threshold = static_cast<int64_t>(m_hold_threshold) * 1000;
+
+    if (m_hold_counter < hold_threshold &&
+        m_hold_counter + usec_delta >= hold_threshold)
     {
       // start sending the secondary events
       m_secondary_codes.send(uinput, true);
       uinput.sync();
     }
 
-    if (m_hold_counter < m_hold_threshold)
+    if (m_hold_counter < hold_threshold)
     {
-      m_hold_counter += msec_delta;
+      m_hold_counter += usec_delta;
     }
   }
 }
@@ -18,12 +18,9 @@
 
 #include "buttonevent/macro_button_event_handler.hpp"
 
-#include <boost/tokenizer.hpp>
-#include <fstream>
+#include <algorithm>
 #include <linux/input.h>
-#include <vector>
 
-#include "evdev_helper.hpp"
 #include "log.hpp"
 #include "raise_exception.hpp"
 #include "uinput.hpp"
@@ -31,244 +28,213 @@
 MacroButtonEventHandler*
 MacroButtonEventHandler::from_string(const std::string& filename)
 {
-  std::vector<MacroEvent> events;
+  return new MacroButtonEventHandler(MacroProgram::from_file(filename));
+}
+
+MacroButtonEventHandler::MacroButtonEventHandler(MacroProgramPtr program) :
+  m_program(program),
+  m_uinput(0),
+  m_emitters(),
+  m_tracks(program->get_tracks().size()),
+  m_loop_counts(program->get_tracks().size() * program->get_max_depth()),
+  m_send_in_progress(false),
+  m_timeout_id(0)
+{
+}
 
-  std::ifstream in(filename.c_str());
-  if (!in)
+MacroButtonEventHandler::~MacroButtonEventHandler()
+{
+  if (m_timeout_id)
   {
-    raise_exception(std::runtime_error, "couldn't open: " << filename);
+    g_source_remove(m_timeout_id);
   }
-  else
+}
+
+void
+MacroButtonEventHandler::init(UInput& uinput, int slot, bool extra_devices)
+{
+  m_uinput = &uinput;
+
+  const std::vector<MacroProgram::Event>& events = m_program->get_events();
+  for(std::vector<MacroProgram::Event>::const_iterator i = events.begin(); i != events.end(); ++i)
   {
-    std::string line;
-    while(std::getline(in, line))
+    UIEvent event = i->event;
+    event.resolve_device_id(slot, extra_devices);
+
+    switch(event.type)
     {
-      MacroEvent ev = macro_event_from_string(line);
-      if (ev.type != MacroEvent::kNull)
-      {
-        events.push_back(ev);
-      }
+      case EV_REL:
+        m_emitters.push_back(uinput.add_rel(event.get_device_id(), event.code));
+        break;
+
+      case EV_KEY:
+        m_emitters.push_back(uinput.add_key(event.get_device_id(), event.code));
+        break;
+
+      case EV_ABS:
+        if (i->has_absinfo)
+        {
+          m_emitters.push_back(uinput.add_abs(event.get_device_id(), event.code,
+                                              i->absinfo.minimum, i->absinfo.maximum,
+                                              i->absinfo.fuzz, i->absinfo.flat));
+        }
+        else
+        {
+          // not doing a add_abs() here, its the users job to use a
+          // init command for that
+          m_emitters.push_back(uinput.get_abs_emitter(event.get_device_id(), event.code));
+        }
+        break;
+
+      default:
+        assert(!"not implemented");
+        break;
     }
-    return new MacroButtonEventHandler(events);
   }
 }
 
-MacroButtonEventHandler::MacroEvent
-MacroButtonEventHandler::macro_event_from_string(const std::string& str)
+void
+MacroButtonEventHandler::send(UInput& uinput, bool value)
 {
-  boost::tokenizer<boost::char_separator<char> > tokens(str, boost::char_separator<char>(" "));
-  std::vector<std::string> args(tokens.begin(), tokens.end());
-
-  if (args.size() >= 1)
+  if (value && !m_send_in_progress && !m_tracks.empty())
   {
-    if (!args[0].empty() && args[0][0] == '#')
-    {
-      // ignore '#' comments
-      MacroEvent event;
-      event.type = MacroEvent::kNull;
-      return event;
-    }
-    else if (args[0] == "init")
-    {
-      // FIXME: generalize this for EV_KEY and EV_REL
-      if (args.size() < 4)
-      {
-        raise_exception(std::runtime_error, "'init' requires at least three arguments: " << str);
-      }
-      else
-      {
-        MacroEvent event;
-        event.type = MacroEvent::kInitOp;
-        event.init.event = UIEvent::from_string(args[1]);
-        event.init.minimum = boost::lexical_cast<int>(args[2]);
-        event.init.maximum = boost::lexical_cast<int>(args[3]);
-        event.init.fuzz = 0;
-        event.init.flat = 0;
-        if (args.size() > 4) event.init.fuzz = boost::lexical_cast<int>(args[4]);
-        if (args.size() > 5) event.init.flat = boost::lexical_cast<int>(args[5]);
+    m_send_in_progress = true;
 
-        return event;
-      }
-    }
-    else if (args[0] == "send")
+    int64_t now = g_get_monotonic_time();
+    for(std::vector<TrackState>::size_type i = 0; i < m_tracks.size(); ++i)
     {
-      if (args.size() != 3)
-      {
-        raise_exception(std::runtime_error, "'send' requires two arguments: " << str);
-      }
-      else
-      {
-        MacroEvent event;
-        event.type  = MacroEvent::kSendOp;
-        event.send.event = UIEvent::from_string(args[1]);
-        event.send.value = boost::lexical_cast<int>(args[2]);
-        return event;
-      }
+      m_tracks[i].pc = m_program->get_tracks()[i].begin;
+      m_tracks[i].deadline = now;
+      m_tracks[i].depth = 0;
     }
-    else if (args[0] == "wait")
+
+    // the ops before the first wait go out with the current frame
+    if (run(now))
     {
-      if (args.size() != 2)
-      {
-        raise_exception(std::runtime_error, "'wait' requires one arguments: " << str);
-      }
-      else
-      {
-        MacroEvent event;
-        event.type = MacroEvent::kWaitOp;
-        event.wait.msec = boost::lexical_cast<int>(args[1]);
-        return event;
-      }
+      schedule(now);
     }
     else
     {
-      raise_exception(std::runtime_error, "unknown macro command: " << str);
+      m_send_in_progress = false;
     }
   }
-  else
-  {
-    // no args, aka an empty line, just ignore it
-    MacroEvent event;
-    event.type = MacroEvent::kNull;
-    return event;
-  }
 }
-
-MacroButtonEventHandler::MacroButtonEventHandler(const std::vector<MacroEvent>& events) :
-  m_events(events),
-  m_send_in_progress(false),
-  m_countdown(0),
-  m_event_counter()
+
+void
+MacroButtonEventHandler::update(UInput& uinput, int64_t usec_time, int usec_delta)
 {
+  // playback is driven by its own timeout, see schedule()
 }
 
-void
-MacroButtonEventHandler::init(UInput& uinput, int slot, bool extra_devices)
+bool
+MacroButtonEventHandler::run(int64_t now)
 {
-  for(std::vector<MacroEvent>::iterator i = m_events.begin(); i != m_events.end(); ++i)
+  bool running = false;
+
+  for(std::vector<TrackState>::size_type i = 0; i < m_tracks.size(); ++i)
   {
-    switch(i->type)
+    run_track(static_cast<int>(i), now);
+
+    if (m_tracks[i].pc < m_program->get_tracks()[i].end)
     {
-      case MacroEvent::kInitOp:
-        switch(i->init.event.type)
-        {
-          case EV_REL:
-            assert(!"not implemented");
-            break;
+      running = true;
+    }
+  }
 
-          case EV_KEY:
-            assert(!"not implemented");
-            break;
+  return running;
+}
 
-          case EV_ABS:
-            i->init.event.resolve_device_id(slot, extra_devices);
-            uinput.add_abs(i->init.event.get_device_id(), i->init.event.code,
-                           i->init.minimum, i->init.maximum,
-                           i->init.fuzz, i->init.flat);
-            break;
+void
+MacroButtonEventHandler::run_track(int track, int64_t now)
+{
+  const std::vector<MacroProgram::Op>& ops = m_program->get_ops();
+  const int end = m_program->get_tracks()[track].end;
+  TrackState& state = m_tracks[track];
+  int* loop_counts = m_loop_counts.empty() ? 0 : &m_loop_counts[track * m_program->get_max_depth()];
 
-          default:
-            assert(!"not implemented");
-        }
-        break;
+  while(state.pc < end && state.deadline <= now)
+  {
+    const MacroProgram::Op& op = ops[state.pc];
 
-      case MacroEvent::kSendOp:
-        switch(i->send.event.type)
+    switch(op.code)
+    {
+      case MacroProgram::Op::kSend:
+        if (m_program->get_events()[op.arg].event.type == EV_KEY)
         {
-          case EV_REL:
-            i->send.event.resolve_device_id(slot, extra_devices),
-            uinput.add_rel(i->send.event.get_device_id(), i->send.event.code);
-            break;
-
-          case EV_KEY:
-            i->send.event.resolve_device_id(slot, extra_devices),
-            uinput.add_key(i->send.event.get_device_id(), i->send.event.code);
-            break;
+          m_emitters[op.arg]->send(op.value ? 1 : 0);
+        }
+        else
+        {
+          m_emitters[op.arg]->send(op.value);
+        }
+        state.pc += 1;
+        break;
 
-          case EV_ABS:
-            i->send.event.resolve_device_id(slot, extra_devices);
-            // not doing a add_abs() here, its the users job to use a
-            // init command for that
-            break;
+      case MacroProgram::Op::kWait:
+        // waits are added to the deadline, not to the current time, so
+        // the delay of the timeout doesn't add up over the macro
+        state.deadline += static_cast<int64_t>(op.arg) * 1000;
+        state.pc += 1;
+        break;
 
-          default:
-            assert(!"not implemented");
-            break;
-        }
+      case MacroProgram::Op::kRepeat:
+        loop_counts[state.depth] = op.arg;
+        state.depth += 1;
+        state.pc += 1;
         break;
 
-      default:
-        // nothing to do
+      case MacroProgram::Op::kEnd:
+        loop_counts[state.depth - 1] -= 1;
+        if (loop_counts[state.depth - 1] > 0)
+        {
+          state.pc = op.arg;
+        }
+        else
+        {
+          state.depth -= 1;
+          state.pc += 1;
+        }
         break;
     }
   }
 }
 
 void
-MacroButtonEventHandler::send(UInput& uinput, bool value)
+MacroButtonEventHandler::schedule(int64_t now)
 {
-  if (value && !m_send_in_progress)
+  int64_t next = G_MAXINT64;
+  for(std::vector<TrackState>::size_type i = 0; i < m_tracks.size(); ++i)
   {
-    m_send_in_progress = true;
-    m_event_counter = 0;
-    m_countdown = 0;
+    if (m_tracks[i].pc < m_program->get_tracks()[i].end)
+    {
+      next = std::min(next, m_tracks[i].deadline);
+    }
   }
+
+  // round up, firing early would only cause another wakeup
+  guint msec = static_cast<guint>((std::max(next - now, static_cast<int64_t>(0)) + 999) / 1000);
+  m_timeout_id = g_timeout_add_full(G_PRIORITY_HIGH, msec, &MacroButtonEventHandler::on_timeout_wrap, this, NULL);
 }
 
-void
-MacroButtonEventHandler::update(UInput& uinput, int msec_delta)
+bool
+MacroButtonEventHandler::on_timeout()
 {
-  if (m_send_in_progress)
-  {
-    m_countdown -= msec_delta;
-    if (m_countdown <= 0)
-    {
-      while(true)
-      {
-        switch(m_events[m_event_counter].type)
-        {
-          case MacroEvent::kInitOp:
-            break;
-
-          case MacroEvent::kSendOp:
-            uinput.send(m_events[m_event_counter].send.event.get_device_id(),
-                        m_events[m_event_counter].send.event.type,
-                        m_events[m_event_counter].send.event.code,
-                        m_events[m_event_counter].send.value);
-            break;
+  m_timeout_id = 0;
 
-          case MacroEvent::kWaitOp:
-            m_countdown = m_events[m_event_counter].wait.msec;
-            if (m_countdown > 0)
-            {
-              m_event_counter += 1;
-              if (m_event_counter >= m_events.size())
-              {
-                m_send_in_progress = false;
-                m_event_counter = 0;
-                m_countdown = 0;
-                return;
-              }
-              return;
-            }
-            break;
+  int64_t now = g_get_monotonic_time();
+  bool running = run(now);
+  m_uinput->sync();
 
-          default:
-            assert(!"never reached");
-            break;
-        }
-
-        m_event_counter += 1;
-
-        if (m_event_counter >= m_events.size())
-        {
-          m_send_in_progress = false;
-          m_event_counter = 0;
-          m_countdown = 0;
-          return;
-        }
-      }
-    }
+  if (running)
+  {
+    schedule(now);
   }
+  else
+  {
+    m_send_in_progress = false;
+  }
+
+  return false; // the next timeout is added by schedule()
 }
 
 std::string
@@ -19,59 +19,72 @@
 #ifndef HEADER_XBOXDRV_BUTTONEVENT_MACRO_BUTTON_EVENT_HANDLER_HPP
 #define HEADER_XBOXDRV_BUTTONEVENT_MACRO_BUTTON_EVENT_HANDLER_HPP
 
+#include <glib.h>
+
 #include "button_event.hpp"
+#include "buttonevent/macro_program.hpp"
+#include "ui_event_emitter.hpp"
 
+/** Plays a MacroProgram when the button is pressed. Each op is run
+    at its scheduled time by a timeout of its own, instead of on the
+    next update() tick, and all state is allocated in init(), so
+    playback doesn't allocate. */
 class MacroButtonEventHandler : public ButtonEventHandler
 {
 public:
-private:
-  struct AbsInfo {
-    UIEvent event;
-    int minimum;
-    int maximum;
-    int fuzz;
-    int flat;
-  };
-
-  struct Event {
-    UIEvent event;
-    int     value;
-  };
+  static MacroButtonEventHandler* from_string(const std::string& filename);
 
-  struct Time {
-    int msec;
-  };
+private:
+  struct TrackState
+  {
+    /** index of the next op in the program */
+    int pc;
 
-  struct MacroEvent {
-    enum { kInitOp, kSendOp, kWaitOp, kNull } type;
+    /** monotonic time in usec at which the next op is due */
+    int64_t deadline;
 
-    union {
-      AbsInfo init;
-      Event send;
-      Time wait;
-    };
+    /** number of open loops, the counters are in m_loop_counts */
+    int depth;
   };
 
 public:
-  static MacroButtonEventHandler* from_string(const std::string& filename);
-
-public:
-  MacroButtonEventHandler(const std::vector<MacroEvent>& events);
+  MacroButtonEventHandler(MacroProgramPtr program);
+  ~MacroButtonEventHandler();
 
   void init(UInput& uinput, int slot, bool extra_devices);
   void send(UInput& uinput, bool value);
-  void update(UInput& uinput, int msec_delta);
+  void update(UInput& uinput, int64_t usec_time, int usec_delta);
 
   std::string str() const;
 
 private:
-  static MacroEvent macro_event_from_string(const std::string& str);
+  /** run all ops that are due at \a now, returns false when all
+      tracks are done */
+  bool run(int64_t now);
+  void run_track(int track, int64_t now);
+  void schedule(int64_t now);
+
+  bool on_timeout();
+  static gboolean on_timeout_wrap(gpointer data) {
+    return static_cast<MacroButtonEventHandler*>(data)->on_timeout();
+  }
 
 private:
-  std::vector<MacroEvent> m_events;
+  MacroProgramPtr m_program;
+  UInput* m_uinput;
+
+  /** one emitter for each of the programs events */
+  std::vector<UIEventEmitterPtr> m_emitters;
+
+  std::vector<TrackState> m_tracks;
+  std::vector<int> m_loop_counts;
+
   bool m_send_in_progress;
-  int m_countdown;
-  std::vector<MacroEvent>::size_type m_event_counter;
+  guint m_timeout_id;
+
+private:
+  MacroButtonEventHandler(const MacroButtonEventHandler&);
+  MacroButtonEventHandler& operator=(const MacroButtonEventHandler&);
 };
 
 #endif
@@ -0,0 +1,244 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "buttonevent/macro_program.hpp"
+
+#include <algorithm>
+#include <boost/tokenizer.hpp>
+#include <boost/weak_ptr.hpp>
+#include <fstream>
+#include <linux/input.h>
+#include <map>
+
+#include "log.hpp"
+#include "raise_exception.hpp"
+
+namespace {
+
+typedef std::map<std::string, boost::weak_ptr<const MacroProgram> > MacroProgramCache;
+MacroProgramCache g_macro_program_cache;
+
+} // namespace
+
+MacroProgramPtr
+MacroProgram::from_file(const std::string& filename)
+{
+  MacroProgramCache::iterator it = g_macro_program_cache.find(filename);
+  if (it != g_macro_program_cache.end())
+  {
+    MacroProgramPtr program = it->second.lock();
+    if (program)
+    {
+      log_debug("using cached macro: " << filename);
+      return program;
+    }
+  }
+
+  std::ifstream in(filename.c_str());
+  if (!in)
+  {
+    raise_exception(std::runtime_error, "couldn't open: " << filename);
+  }
+  else
+  {
+    boost::shared_ptr<MacroProgram> program(new MacroProgram);
+    program->compile(in, filename);
+    g_macro_program_cache[filename] = program;
+    return program;
+  }
+}
+
+MacroProgram::MacroProgram() :
+  m_ops(),
+  m_events(),
+  m_tracks(),
+  m_max_depth(0)
+{
+}
+
+int
+MacroProgram::get_event_index(const UIEvent& event)
+{
+  for(std::vector<Event>::size_type i = 0; i < m_events.size(); ++i)
+  {
+    if (!(m_events[i].event < event) && !(event < m_events[i].event))
+    {
+      return static_cast<int>(i);
+    }
+  }
+
+  Event ev;
+  ev.event = event;
+  ev.has_absinfo = false;
+  ev.absinfo.minimum = 0;
+  ev.absinfo.maximum = 0;
+  ev.absinfo.fuzz = 0;
+  ev.absinfo.flat = 0;
+  m_events.push_back(ev);
+  return static_cast<int>(m_events.size() - 1);
+}
+
+void
+MacroProgram::compile(std::istream& in, const std::string& filename)
+{
+  // op indices of the 'repeat' that are still open
+  std::vector<int> loops;
+
+  Track track;
+  track.begin = 0;
+
+  int line_no = 0;
+  std::string line;
+  while(std::getline(in, line))
+  {
+    line_no += 1;
+
+    boost::tokenizer<boost::char_separator<char> > tokens(line, boost::char_separator<char>(" \t"));
+    std::vector<std::string> args(tokens.begin(), tokens.end());
+
+    if (args.empty() || args[0][0] == '#')
+    {
+      // ignore empty lines and '#' comments
+    }
+    else if (args[0] == "init")
+    {
+      // FIXME: generalize this for EV_KEY and EV_REL
+      if (args.size() < 4 || args.size() > 6)
+      {
+        raise_exception(std::runtime_error, filename << ":" << line_no << ": 'init' requires three to five arguments");
+      }
+      else
+      {
+        int idx = get_event_index(UIEvent::from_string(args[1]));
+        if (m_events[idx].event.type != EV_ABS)
+        {
+          raise_exception(std::runtime_error, filename << ":" << line_no << ": 'init' is only supported for abs events");
+        }
+
+        m_events[idx].has_absinfo = true;
+        m_events[idx].absinfo.minimum = boost::lexical_cast<int>(args[2]);
+        m_events[idx].absinfo.maximum = boost::lexical_cast<int>(args[3]);
+        if (args.size() > 4) m_events[idx].absinfo.fuzz = boost::lexical_cast<int>(args[4]);
+        if (args.size() > 5) m_events[idx].absinfo.flat = boost::lexical_cast<int>(args[5]);
+      }
+    }
+    else if (args[0] == "send")
+    {
+      if (args.size() != 3)
+      {
+        raise_exception(std::runtime_error, filename << ":" << line_no << ": 'send' requires two arguments");
+      }
+      else
+      {
+        Op op;
+        op.code  = Op::kSend;
+        op.arg   = get_event_index(UIEvent::from_string(args[1]));
+        op.value = boost::lexical_cast<int>(args[2]);
+        m_ops.push_back(op);
+      }
+    }
+    else if (args[0] == "wait")
+    {
+      if (args.size() != 2)
+      {
+        raise_exception(std::runtime_error, filename << ":" << line_no << ": 'wait' requires one argument");
+      }
+      else
+      {
+        Op op;
+        op.code  = Op::kWait;
+        op.arg   = std::max(0, boost::lexical_cast<int>(args[1]));
+        op.value = 0;
+        m_ops.push_back(op);
+      }
+    }
+    else if (args[0] == "repeat")
+    {
+      if (args.size() != 2)
+      {
+        raise_exception(std::runtime_error, filename << ":" << line_no << ": 'repeat' requires one argument");
+      }
+      else
+      {
+        Op op;
+        op.code  = Op::kRepeat;
+        op.arg   = boost::lexical_cast<int>(args[1]);
+        op.value = 0;
+
+        if (op.arg < 1)
+        {
+          raise_exception(std::runtime_error, filename << ":" << line_no << ": 'repeat' count must be at least 1");
+        }
+
+        loops.push_back(static_cast<int>(m_ops.size()));
+        m_ops.push_back(op);
+        m_max_depth = std::max(m_max_depth, static_cast<int>(loops.size()));
+      }
+    }
+    else if (args[0] == "end")
+    {
+      if (loops.empty())
+      {
+        raise_exception(std::runtime_error, filename << ":" << line_no << ": 'end' without 'repeat'");
+      }
+      else
+      {
+        Op op;
+        op.code  = Op::kEnd;
+        op.arg   = loops.back() + 1;
+        op.value = 0;
+        m_ops.push_back(op);
+        loops.pop_back();
+      }
+    }
+    else if (args[0] == "track")
+    {
+      if (!loops.empty())
+      {
+        raise_exception(std::runtime_error, filename << ":" << line_no << ": 'track' inside of 'repeat'");
+      }
+      else
+      {
+        track.end = static_cast<int>(m_ops.size());
+        if (track.begin != track.end)
+        {
+          m_tracks.push_back(track);
+        }
+        track.begin = track.end;
+      }
+    }
+    else
+    {
+      raise_exception(std::runtime_error, filename << ":" << line_no << ": unknown macro command: " << args[0]);
+    }
+  }
+
+  if (!loops.empty())
+  {
+    raise_exception(std::runtime_error, filename << ": 'repeat' without 'end'");
+  }
+
+  track.end = static_cast<int>(m_ops.size());
+  if (track.begin != track.end)
+  {
+    m_tracks.push_back(track);
+  }
+}
+
+/* EOF */
@@ -0,0 +1,108 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_BUTTONEVENT_MACRO_PROGRAM_HPP
+#define HEADER_XBOXDRV_BUTTONEVENT_MACRO_PROGRAM_HPP
+
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+#include "ui_event.hpp"
+
+class MacroProgram;
+
+typedef boost::shared_ptr<const MacroProgram> MacroProgramPtr;
+
+/** A macro file compiled into a flat list of ops, split into tracks
+    that are played in parallel. The program is immutable and shared
+    by all buttons and slots that use the same file, the playback
+    state lives in MacroButtonEventHandler. */
+class MacroProgram
+{
+public:
+  /** Loads and compiles \a filename, files that are already loaded
+      are returned from a cache */
+  static MacroProgramPtr from_file(const std::string& filename);
+
+public:
+  struct Op
+  {
+    enum Code { kSend, kWait, kRepeat, kEnd } code;
+
+    /** kSend: index into get_events(), kWait: msec to wait, kRepeat:
+        number of runs, kEnd: index of the first op of the loop */
+    int arg;
+
+    /** kSend: the value to send */
+    int value;
+  };
+
+  struct AbsInfo
+  {
+    int minimum;
+    int maximum;
+    int fuzz;
+    int flat;
+  };
+
+  struct Event
+  {
+    UIEvent event;
+
+    /** abs events declared with 'init' */
+    bool has_absinfo;
+    AbsInfo absinfo;
+  };
+
+  struct Track
+  {
+    /** range of the track in get_ops() */
+    int begin;
+    int end;
+  };
+
+private:
+  std::vector<Op> m_ops;
+  std::vector<Event> m_events;
+  std::vector<Track> m_tracks;
+  int m_max_depth;
+
+public:
+  MacroProgram();
+
+  const std::vector<Op>&    get_ops() const    { return m_ops; }
+  const std::vector<Event>& get_events() const { return m_events; }
+  const std::vector<Track>& get_tracks() const { return m_tracks; }
+
+  /** the deepest nesting of 'repeat' in any track */
+  int get_max_depth() const { return m_max_depth; }
+
+private:
+  void compile(std::istream& in, const std::string& filename);
+  int  get_event_index(const UIEvent& event);
+
+private:
+  MacroProgram(const MacroProgram&);
+  MacroProgram& operator=(const MacroProgram&);
+};
+
+#endif
+
+/* EOF */
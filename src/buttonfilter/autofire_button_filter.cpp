@@ -53,13 +53,13 @@ AutofireButtonFilter::AutofireButtonFilter(int rate, int delay) :
 }
 
 void
-AutofireButtonFilter::update(int msec_delta)
+AutofireButtonFilter::update(int64_t usec_time, int usec_delta)
 {
   if (m_state)
   {
-    m_counter += msec_delta;
+    m_counter += usec_delta;
 
-    if (m_counter > m_delay)
+    if (m_counter > static_cast<int64_t>(m_delay) * 1000)
     {
       m_autofire = true;
     }
@@ -81,9 +81,12 @@ AutofireButtonFilter::filter(bool value)
   { // auto fire
     if (m_autofire)
     {
-      if (m_counter > m_rate)
+      const int64_t rate = static_cast<int64_t>(m_rate) * 1000;
+      if (m_counter > rate)
       {
-        m_counter = 0;
+        // keep the time that went past the shot, so the rate doesn't
+        // drift with the update interval
+        m_counter = (rate > 0) ? m_counter % rate : 0;
         return true;
       }
       else
@@ -29,7 +29,7 @@ public:
 public:
   AutofireButtonFilter(int rate, int delay);
 
-  void update(int msec_delta);
+  void update(int64_t usec_time, int usec_delta);
   bool filter(bool value);
   std::string str() const;
 
@@ -40,7 +40,9 @@ private:
   /** msec between shots */
   int m_rate;
   int m_delay;
-  int m_counter;
+
+  /** usec since the button got pressed or the last shot */
+  int64_t m_counter;
 };
 
 #endif
@@ -29,7 +29,7 @@ public:
 public:
   ConstButtonFilter(bool value);
 
-  void update(int msec_delta) {}
+  void update(int64_t usec_time, int usec_delta) {}
   bool filter(bool value);
   std::string str() const;
 
@@ -37,7 +37,7 @@ DelayButtonFilter::filter(bool value)
 {
   if (value)
   {
-    if (m_time < m_delay)
+    if (m_time < static_cast<int64_t>(m_delay) * 1000)
     {
       return false;
     }
@@ -54,9 +54,13 @@ DelayButtonFilter::filter(bool value)
 }
 
 void
-DelayButtonFilter::update(int msec_delta)
+DelayButtonFilter::update(int64_t usec_time, int usec_delta)
 {
-  m_time += msec_delta;
+  // don't overflow when the button is held down for long
+  if (m_time < static_cast<int64_t>(m_delay) * 1000)
+  {
+    m_time += usec_delta;
+  }
 }
 
 std::string
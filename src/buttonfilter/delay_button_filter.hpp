@@ -33,13 +33,15 @@ public:
   DelayButtonFilter(int delay);
 
   bool filter(bool value);
-  void update(int msec_delta);
+  void update(int64_t usec_time, int usec_delta);
 
   std::string str() const;
 
 private:
   int m_delay;
-  int m_time;
+
+  /** usec the button is held down */
+  int64_t m_time;
 };
 
 #endif
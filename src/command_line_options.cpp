@@ -20,6 +20,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/tokenizer.hpp>
@@ -32,6 +33,7 @@
 #include "path.hpp"
 #include "raise_exception.hpp"
 #include "ui_event.hpp"
+#include "xpad_device.hpp"
 
 #include "axisfilter/relative_axis_filter.hpp"
 #include "axisfilter/calibration_axis_filter.hpp"
@@ -57,12 +59,22 @@ enum {
   OPTION_RUMBLE,
   OPTION_FF_DEVICE,
   OPTION_PRIORITY,
+  OPTION_DEADLINE_RUNTIME,
+  OPTION_DEADLINE_PERIOD,
+  OPTION_CPU_AFFINITY,
+  OPTION_MLOCK,
   OPTION_QUIT,
   OPTION_NO_UINPUT,
   OPTION_MIMIC_XPAD,
   OPTION_MIMIC_XPAD_WIRELESS,
   OPTION_NO_EXTRA_DEVICES,
   OPTION_NO_EXTRA_EVENTS,
+  OPTION_WHEEL_HI_RES,
+  OPTION_REL_RATE,
+  OPTION_UINPUT_BACKEND,
+  OPTION_EXEC_RATE,
+  OPTION_EXEC_DEBOUNCE,
+  OPTION_STATE_SHM,
   OPTION_TYPE,
   OPTION_FORCE_FEEDBACK,
   OPTION_RUMBLE_GAIN,
@@ -94,6 +106,8 @@ enum {
   OPTION_CALIBRARIOTION,
   OPTION_RELATIVE_AXIS,
   OPTION_SQUARE_AXIS,
+  OPTION_AUTO_CALIBRATION,
+  OPTION_CALIBRATION_FILE,
   OPTION_FOUR_WAY_RESTRICTOR,
   OPTION_DPAD_ROTATION,
   OPTION_AXIS_SENSITIVITY,
@@ -101,12 +115,20 @@ enum {
   OPTION_DEVICE_BY_ID,
   OPTION_DEVICE_BY_PATH,
   OPTION_GENERIC_USB_SPEC,
+  OPTION_DEVICE_FILE,
   OPTION_LIST_SUPPORTED_DEVICES,
   OPTION_LIST_SUPPORTED_DEVICES_XPAD,
   OPTION_LIST_CONTROLLER,
   OPTION_MOUSE,
   OPTION_GUITAR,
   OPTION_EVDEV,
+  OPTION_RECORD,
+  OPTION_REPLAY,
+  OPTION_REPLAY_FAST,
+  OPTION_SYNTHETIC,
+  OPTION_SYNTHETIC_COUNT,
+  OPTION_SYNTHETIC_RATE,
+  OPTION_SYNTHETIC_RANDOM,
   OPTION_EVDEV_NO_GRAB,
   OPTION_EVDEV_DEBUG,
   OPTION_EVDEV_ABSMAP,
@@ -134,7 +156,13 @@ enum {
   OPTION_LIST_AXIS,
   OPTION_LIST_BUTTON,
   OPTION_DAEMON_ON_CONNECT,
-  OPTION_DAEMON_ON_DISCONNECT
+  OPTION_DAEMON_ON_DISCONNECT,
+  OPTION_DAEMON_USB_CONTEXTS,
+  OPTION_DAEMON_USB_CONTEXT_BY_BUS,
+  OPTION_DAEMON_ON_LOW_BATTERY,
+  OPTION_DAEMON_LOW_BATTERY,
+  OPTION_DAEMON_LOW_BATTERY_LED,
+  OPTION_DAEMON_LOW_BATTERY_RUMBLE_GAIN
 };
 
 CommandLineParser::CommandLineParser() :
@@ -162,7 +190,11 @@ CommandLineParser::init_argp()
     .add_option(OPTION_SILENT,       's', "silent",  "",  "do not display events on console")
     .add_option(OPTION_QUIET,         0,  "quiet",   "",  "do not display startup text")
     .add_option(OPTION_USB_DEBUG,     0,  "usb-debug", "",  "enable log messages from libusb")
-    .add_option(OPTION_PRIORITY,      0,  "priority", "PRI", "increases process priority (default: normal)")
+    .add_option(OPTION_PRIORITY,      0,  "priority", "PRI", "increases process priority: normal, realtime or deadline (default: normal)")
+    .add_option(OPTION_DEADLINE_RUNTIME, 0, "deadline-runtime", "USEC", "CPU time per period with --priority deadline (default: 200)")
+    .add_option(OPTION_DEADLINE_PERIOD,  0, "deadline-period",  "USEC", "Period with --priority deadline (default: 1000)")
+    .add_option(OPTION_CPU_AFFINITY,  0,  "cpu-affinity", "CPUS", "Run the input handling on the given CPUs, e.g. 2 or 2,4-5")
+    .add_option(OPTION_MLOCK,         0,  "mlock",    "",    "Lock all memory to avoid page faults while handling input")
     .add_newline()
 
     .add_text("List Options: ")
@@ -194,6 +226,12 @@ CommandLineParser::init_argp()
     .add_option(OPTION_DAEMON_DBUS,     0, "dbus",    "MODE", "Set D-Bus mode (auto, system, session, disabled)")
     .add_option(OPTION_DAEMON_ON_CONNECT,    0, "on-connect", "FILE", "Launch EXE when a new controller is connected")
     .add_option(OPTION_DAEMON_ON_DISCONNECT, 0, "on-disconnect", "FILE", "Launch EXE when a controller is disconnected")
+    .add_option(OPTION_DAEMON_ON_LOW_BATTERY, 0, "on-low-battery", "FILE", "Launch EXE when the battery of a wireless controller runs low")
+    .add_option(OPTION_DAEMON_LOW_BATTERY,   0, "low-battery", "PERCENT", "Battery level that counts as low (default: 25)")
+    .add_option(OPTION_DAEMON_LOW_BATTERY_LED, 0, "low-battery-led", "NUM", "Switch the LED to NUM while the battery is low")
+    .add_option(OPTION_DAEMON_LOW_BATTERY_RUMBLE_GAIN, 0, "low-battery-rumble-gain", "NUM", "Scale rumble by NUM while the battery is low (default: 255)")
+    .add_option(OPTION_DAEMON_USB_CONTEXTS,  0, "usb-contexts", "NUM", "Handle USB events in NUM threads (default: 0, in the main loop)")
+    .add_option(OPTION_DAEMON_USB_CONTEXT_BY_BUS, 0, "usb-context-by-bus", "", "Assign controllers to USB threads by bus instead of by device")
     .add_newline()
 
     .add_text("Device Options: ")
@@ -205,6 +243,7 @@ CommandLineParser::init_argp()
     .add_option(OPTION_TYPE,           0, "type",    "TYPE", "Ignore autodetection and enforce controller type (xbox, xbox-mat, xbox360, xbox360-wireless, xbox360-guitar)")
     .add_option(OPTION_DETACH_KERNEL_DRIVER, 'd', "detach-kernel-driver", "", "Detaches the kernel driver currently associated with the device")
     .add_option(OPTION_GENERIC_USB_SPEC, 0, "generic-usb-spec", "SPEC", "Specification for generic USB device")
+    .add_option(OPTION_DEVICE_FILE,      0, "device-file", "FILE", "Read additional supported devices from FILE")
     .add_newline()
 
     .add_text("Evdev Options: ")
@@ -215,6 +254,19 @@ CommandLineParser::init_argp()
     .add_option(OPTION_EVDEV_KEYMAP,   0, "evdev-keymap", "MAP", "Map evdev abs events to Xbox360 axis events")
     .add_newline()
 
+    .add_text("Recording Options: ")
+    .add_option(OPTION_RECORD,         0, "record",      "FILE", "Record the raw USB reports of the controller to FILE")
+    .add_option(OPTION_REPLAY,         0, "replay",      "FILE", "Replay a recording made with --record instead of using a controller")
+    .add_option(OPTION_REPLAY_FAST,    0, "replay-fast", "",     "Replay as fast as possible instead of at the original speed")
+    .add_newline()
+
+    .add_text("Synthetic Controller Options: ")
+    .add_option(OPTION_SYNTHETIC,        0, "synthetic",        "TYPE", "Use a controller of TYPE that generates its own input instead of a real one (xbox360, xbox, playstation3-usb)")
+    .add_option(OPTION_SYNTHETIC_COUNT,  0, "synthetic-count",  "NUM",  "Number of synthetic controllers the daemon creates (default: 1)")
+    .add_option(OPTION_SYNTHETIC_RATE,   0, "synthetic-rate",   "HZ",   "Reports per second a synthetic controller sends (default: 125)")
+    .add_option(OPTION_SYNTHETIC_RANDOM, 0, "synthetic-random", "",     "Generate random input instead of a fixed pattern")
+    .add_newline()
+
     .add_text("Status Options: ")
     .add_option(OPTION_LED,     'l', "led",    "STATUS", "set LED status, see --help-led for possible values")
     .add_option(OPTION_RUMBLE,  'r', "rumble", "L,R", "set the speed for both rumble motors [0-255] (default: 0,0)")
@@ -263,9 +315,11 @@ CommandLineParser::init_argp()
     .add_newline()
 
     .add_text("Modifier Preset Options: ")
+    .add_option(OPTION_AUTO_CALIBRATION,   0, "auto-calibration", "",     "Learn the center, noise and range of the sticks and correct for them")
     .add_option(OPTION_AUTOFIRE,           0, "autofire",         "MAP",  "Cause the given buttons to act as autofire (example: A=250)")
     .add_option(OPTION_AXIS_SENSITIVITY,   0, "axis-sensitivity", "MAP",  "Adjust the axis sensitivity (example: X1=2.0,Y1=1.0)")
     .add_option(OPTION_CALIBRARIOTION,     0, "calibration",      "MAP",  "Changes the calibration for the given axis (example: X2=-32768:0:32767)")
+    .add_option(OPTION_CALIBRATION_FILE,   0, "calibration-file", "FILE", "Store learned calibrations in FILE, implies --auto-calibration")
     .add_option(OPTION_DEADZONE,           0, "deadzone",         "INT",  "Threshold under which axis events are ignored (default: 0)")
     .add_option(OPTION_DEADZONE_TRIGGER,   0, "deadzone-trigger", "INT",  "Threshold under which trigger events are ignored (default: 0)")
     .add_option(OPTION_DPAD_ROTATION,      0, "dpad-rotation",    "DEGREE", "Rotate the dpad by the given DEGREE, must be a multiple of 45")
@@ -289,6 +343,12 @@ CommandLineParser::init_argp()
     .add_option(OPTION_NO_UINPUT,          0, "no-uinput",   "", "do not try to start uinput event dispatching")
     .add_option(OPTION_NO_EXTRA_DEVICES,   0, "no-extra-devices",  "", "Do not create separate virtual keyboard and mouse devices, just use a single virtual device")
     .add_option(OPTION_NO_EXTRA_EVENTS,    0, "no-extra-events",  "", "Do not create dummy events to facilitate device type detection")
+    .add_option(OPTION_WHEEL_HI_RES,       0, "wheel-hi-res",     "", "Send REL_WHEEL and REL_HWHEEL also as smooth high resolution wheel events")
+    .add_option(OPTION_REL_RATE,           0, "rel-rate",         "HZ", "How often per second mouse motion is sent, 60 to 1000 (default: 100)")
+    .add_option(OPTION_UINPUT_BACKEND,     0, "uinput-backend",   "NAME", "Where events go: kernel, null or memory (default: kernel)")
+    .add_option(OPTION_EXEC_RATE,          0, "exec-rate",        "NUM", "Maximum number of programs launched by exec buttons per second, 0 for no limit (default: 10)")
+    .add_option(OPTION_EXEC_DEBOUNCE,      0, "exec-debounce",    "MSEC", "Ignore an exec button that is pressed again within MSEC (default: 0)")
+    .add_option(OPTION_STATE_SHM,          0, "state-shm",        "NAME", "Publish the state of all controller slots in the shared memory segment NAME")
     .add_option(OPTION_DEVICE_NAME,        0, "device-name",     "NAME", "Changes the name prefix used for devices in the current slot")
     .add_option(OPTION_DEVICE_NAMES,       0, "device-names",    "DEVID=NAME,...", "Changes the descriptive name the given devices")
     .add_option(OPTION_DEVICE_USBID,       0, "device-usbid",     "VENDOR:PRODUCT:VERSION", "Changes the USB Id used for devices in the current slot")
@@ -319,6 +379,7 @@ CommandLineParser::init_argp()
     .add_pseudo("  dpad-restrictor=RESTRICTION", "Restrict dpad movment to 'x-axis', 'y-axis' or 'four-way'")
     .add_pseudo("  4wayrest, four-way-restrictor=XAXIS:YAXIS", "Restrict the given stick to four directions")
     .add_pseudo("  square, square-axis=XAXIS:YAXIS", "Convert the circular motion range of the given stick to a square one")
+    .add_pseudo("  autocal, auto-calibration=XAXIS:YAXIS[:FILE]", "Learn and correct the center, noise and range of the given stick")
     .add_pseudo("  rotate=XAXIS:YAXIS:DEGREE[:MIRROR]", "Rotate the given stick by DEGREE, optionally also mirror it")
     .add_newline()
 
@@ -353,20 +414,40 @@ CommandLineParser::init_ini(Options* opts)
     ("evdev", &opts->evdev_device)
     ("evdev-grab", &opts->evdev_grab)
     ("evdev-debug", &opts->evdev_debug)
+    ("record", &opts->record_file)
+    ("replay", &opts->replay_file)
+    ("replay-fast", &opts->replay_fast)
+    ("synthetic", boost::bind(&Options::set_synthetic, opts, _1))
+    ("synthetic-count", &opts->synthetic_count)
+    ("synthetic-rate", &opts->synthetic_rate)
+    ("synthetic-random", &opts->synthetic_random)
     ("config", boost::bind(&CommandLineParser::read_config_file, this, _1))
     ("alt-config", boost::bind(&CommandLineParser::read_alt_config_file, this, _1))
+    ("device-file", boost::bind(&read_xpad_device_file, _1))
     ("timeout", &opts->timeout)
     ("priority", boost::bind(&Options::set_priority, opts, _1))
+    ("deadline-runtime", &opts->deadline_runtime)
+    ("deadline-period", &opts->deadline_period)
+    ("cpu-affinity", boost::bind(&Options::set_cpu_affinity, opts, _1))
+    ("mlock", &opts->mlock)
     ("next", boost::bind(&Options::next_config, opts), boost::function<void ()>())
     ("next-controller", boost::bind(&Options::next_controller, opts), boost::function<void ()>())
     ("extra-devices", &opts->extra_devices)
     ("extra-events", &opts->extra_events)
+    ("wheel-hi-res", &opts->wheel_hi_res)
+    ("rel-rate", &opts->rel_rate)
+    ("uinput-backend", boost::bind(&Options::set_uinput_backend, opts, _1))
+    ("exec-rate", &opts->exec_rate)
+    ("exec-debounce", &opts->exec_debounce)
+    ("state-shm", &opts->state_shm)
     ("toggle", boost::bind(&Options::set_toggle_button, opts, _1))
     ("ff-device", boost::bind(&Options::set_ff_device, opts, _1))
 
     ("deadzone", boost::bind(&CommandLineParser::set_deadzone, this, _1))
     ("deadzone-trigger", boost::bind(&CommandLineParser::set_deadzone_trigger, this, _1))
     ("square-axis", boost::bind(&CommandLineParser::set_square_axis, this), boost::function<void ()>())
+    ("auto-calibration", boost::bind(&CommandLineParser::set_auto_calibration, this), boost::function<void ()>())
+    ("calibration-file", boost::bind(&CommandLineParser::set_calibration_file, this, _1))
     ("four-way-restrictor", boost::bind(&CommandLineParser::set_four_way_restrictor, this), boost::function<void ()>())
     ("dpad-rotation", boost::bind(&CommandLineParser::set_dpad_rotation, this, _1))
 
@@ -402,6 +483,12 @@ CommandLineParser::init_ini(Options* opts)
     ("pid-file",      &opts->pid_file)
     ("on-connect",    &opts->on_connect)
     ("on-disconnect", &opts->on_disconnect)
+    ("on-low-battery", &opts->on_low_battery)
+    ("low-battery",   &opts->low_battery)
+    ("low-battery-led", &opts->low_battery_led)
+    ("low-battery-rumble-gain", &opts->low_battery_rumble_gain)
+    ("usb-contexts",  &opts->usb_contexts)
+    ("usb-context-by-bus", &opts->usb_context_by_bus)
     ;
 
   m_ini.section("modifier",     boost::bind(&CommandLineParser::set_modifier,     this, _1, _2));
@@ -496,6 +583,22 @@ CommandLineParser::parse_args(int argc, char** argv, Options* options)
         opts.set_priority(opt.argument);
         break;
 
+      case OPTION_DEADLINE_RUNTIME:
+        opts.deadline_runtime = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_DEADLINE_PERIOD:
+        opts.deadline_period = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_CPU_AFFINITY:
+        opts.set_cpu_affinity(opt.argument);
+        break;
+
+      case OPTION_MLOCK:
+        opts.mlock = true;
+        break;
+
       case OPTION_DAEMON:
         opts.set_daemon();
         break;
@@ -587,59 +690,19 @@ CommandLineParser::parse_args(int argc, char** argv, Options* options)
         break;
 
       case OPTION_TYPE:
-        if (opt.argument == "xbox")
-        {
-          opts.gamepad_type = GAMEPAD_XBOX;
-        }
-        else if (opt.argument == "xbox-mat")
-        {
-          opts.gamepad_type = GAMEPAD_XBOX_MAT;
-        }
-        else if (opt.argument == "xbox360")
-        {
-          opts.gamepad_type = GAMEPAD_XBOX360;
-        }
-        else if (opt.argument == "xbox360-guitar")
-        {
-          opts.gamepad_type = GAMEPAD_XBOX360_GUITAR;
-        }
-        else if (opt.argument == "xbox360-wireless")
-        {
-          opts.gamepad_type = GAMEPAD_XBOX360_WIRELESS;
-        }
-        else if (opt.argument == "firestorm")
-        {
-          opts.gamepad_type = GAMEPAD_FIRESTORM;
-        }
-        else if (opt.argument == "firestorm-vsb")
-        {
-          opts.gamepad_type = GAMEPAD_FIRESTORM_VSB;
-        }
-        else if (opt.argument == "saitek-p2500")
-        {
-          opts.gamepad_type = GAMEPAD_SAITEK_P2500;
-        }
-        else if (opt.argument == "playstation3-usb")
-        {
-          opts.gamepad_type = GAMEPAD_PLAYSTATION3_USB;
-        }
-        else if (opt.argument == "generic-usb")
-        {
-          opts.gamepad_type = GAMEPAD_GENERIC_USB;
-        }
-        else
+        opts.gamepad_type = gamepadtype_from_string(opt.argument);
+        if (opts.gamepad_type == GAMEPAD_UNKNOWN)
         {
+          std::ostringstream out;
+          const std::vector<std::string> names = gamepadtype_names();
+          for(std::vector<std::string>::const_iterator name = names.begin(); name != names.end(); ++name)
+          {
+            out << " * " << *name << '\n';
+          }
+
           raise_exception(std::runtime_error, "unknown type: " << opt.argument << '\n'
                           << "Possible types are:\n"
-                          << " * xbox\n"
-                          << " * xbox-mat\n"
-                          << " * xbox360\n"
-                          << " * xbox360-guitar\n"
-                          << " * xbox360-wireless\n"
-                          << " * firestorm\n"
-                          << " * firestorm-vsb\n"
-                          << " * saitek-p2500\n"
-                          << " * generic-usb\n");
+                          << out.str());
         }
         break;
 
@@ -754,6 +817,34 @@ CommandLineParser::parse_args(int argc, char** argv, Options* options)
         opts.evdev_device = opt.argument;
         break;
 
+      case OPTION_RECORD:
+        opts.record_file = opt.argument;
+        break;
+
+      case OPTION_REPLAY:
+        opts.replay_file = opt.argument;
+        break;
+
+      case OPTION_REPLAY_FAST:
+        opts.replay_fast = true;
+        break;
+
+      case OPTION_SYNTHETIC:
+        opts.set_synthetic(opt.argument);
+        break;
+
+      case OPTION_SYNTHETIC_COUNT:
+        opts.synthetic_count = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_SYNTHETIC_RATE:
+        opts.synthetic_rate = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_SYNTHETIC_RANDOM:
+        opts.synthetic_random = true;
+        break;
+
       case OPTION_EVDEV_DEBUG:
         opts.evdev_debug = true;
         break;
@@ -801,6 +892,30 @@ CommandLineParser::parse_args(int argc, char** argv, Options* options)
         opts.extra_events = false;
         break;
 
+      case OPTION_WHEEL_HI_RES:
+        opts.wheel_hi_res = true;
+        break;
+
+      case OPTION_REL_RATE:
+        opts.rel_rate = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_UINPUT_BACKEND:
+        opts.set_uinput_backend(opt.argument);
+        break;
+
+      case OPTION_EXEC_RATE:
+        opts.exec_rate = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_EXEC_DEBOUNCE:
+        opts.exec_debounce = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_STATE_SHM:
+        opts.state_shm = opt.argument;
+        break;
+
       case OPTION_DPAD_ONLY:
         opts.set_dpad_only();
         break;
@@ -853,6 +968,14 @@ CommandLineParser::parse_args(int argc, char** argv, Options* options)
         set_square_axis();
         break;
 
+      case OPTION_AUTO_CALIBRATION:
+        set_auto_calibration();
+        break;
+
+      case OPTION_CALIBRATION_FILE:
+        set_calibration_file(opt.argument);
+        break;
+
       case OPTION_HELP_LED:
         opts.mode = Options::PRINT_LED_HELP;
         break;
@@ -877,6 +1000,30 @@ CommandLineParser::parse_args(int argc, char** argv, Options* options)
         opts.set_dbus_mode(opt.argument);
         break;
 
+      case OPTION_DAEMON_ON_LOW_BATTERY:
+        opts.on_low_battery = opt.argument;
+        break;
+
+      case OPTION_DAEMON_LOW_BATTERY:
+        opts.low_battery = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_DAEMON_LOW_BATTERY_LED:
+        opts.low_battery_led = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_DAEMON_LOW_BATTERY_RUMBLE_GAIN:
+        opts.low_battery_rumble_gain = to_number(255, opt.argument);
+        break;
+
+      case OPTION_DAEMON_USB_CONTEXTS:
+        opts.usb_contexts = boost::lexical_cast<int>(opt.argument);
+        break;
+
+      case OPTION_DAEMON_USB_CONTEXT_BY_BUS:
+        opts.usb_context_by_bus = true;
+        break;
+
       case OPTION_DAEMON_NO_DBUS:
         opts.dbus = Options::kDBusDisabled;
         break;
@@ -918,6 +1065,10 @@ CommandLineParser::parse_args(int argc, char** argv, Options* options)
         set_generic_usb_spec(opt.argument);
         break;
 
+      case OPTION_DEVICE_FILE:
+        read_xpad_device_file(opt.argument);
+        break;
+
       case OPTION_LIST_SUPPORTED_DEVICES:
         opts.mode = Options::RUN_LIST_SUPPORTED_DEVICES;
         break;
@@ -1275,6 +1426,19 @@ CommandLineParser::set_square_axis()
   m_options->get_controller_options().square_axis = true;
 }
 
+void
+CommandLineParser::set_auto_calibration()
+{
+  m_options->get_controller_options().auto_calibration = true;
+}
+
+void
+CommandLineParser::set_calibration_file(const std::string& value)
+{
+  m_options->get_controller_options().auto_calibration = true;
+  m_options->get_controller_options().calibration_file = value;
+}
+
 void
 CommandLineParser::set_four_way_restrictor()
 {
@@ -83,6 +83,8 @@ private:
   void set_deadzone(const std::string& value);
   void set_deadzone_trigger(const std::string& value);
   void set_square_axis();
+  void set_auto_calibration();
+  void set_calibration_file(const std::string& value);
   void set_four_way_restrictor();
   void set_dpad_rotation(const std::string& value);
 
@@ -19,6 +19,7 @@
 #include "controller.hpp"
 
 #include <boost/bind.hpp>
+#include <glib.h>
 
 #include "log.hpp"
 #include "message_processor.hpp"
@@ -27,12 +28,15 @@ Controller::Controller() :
   m_msg_cb(),
   m_disconnect_cb(),
   m_activation_cb(),
+  m_battery_cb(),
   m_is_disconnected(false),
   m_is_active(true),
   m_udev_device(),
   m_led_status(0),
   m_rumble_left(0),
-  m_rumble_right(0)
+  m_rumble_right(0),
+  m_rumble_scale(255),
+  m_battery_level(-1)
 {
 }
 
@@ -59,7 +63,23 @@ Controller::set_rumble(uint8_t left, uint8_t right)
     m_rumble_left  = left;
     m_rumble_right = right;
 
-    set_rumble_real(m_rumble_left, m_rumble_right);
+    set_rumble_real(static_cast<uint8_t>(m_rumble_left  * m_rumble_scale / 255),
+                    static_cast<uint8_t>(m_rumble_right * m_rumble_scale / 255));
+  }
+}
+
+void
+Controller::set_rumble_scale(uint8_t scale)
+{
+  if (m_rumble_scale != scale)
+  {
+    m_rumble_scale = scale;
+
+    if (m_rumble_left || m_rumble_right)
+    {
+      set_rumble_real(static_cast<uint8_t>(m_rumble_left  * m_rumble_scale / 255),
+                      static_cast<uint8_t>(m_rumble_right * m_rumble_scale / 255));
+    }
   }
 }
 
@@ -87,6 +107,12 @@ Controller::set_message_cb(const boost::function<void(const XboxGenericMsg&)>& m
   m_msg_cb = msg_cb;
 }
 
+int64_t
+Controller::get_time() const
+{
+  return g_get_monotonic_time();
+}
+
 udev_device*
 Controller::get_udev_device() const
 {
@@ -113,6 +139,25 @@ Controller::set_activation_cb(const boost::function<void ()>& callback)
   m_activation_cb = callback;
 }
 
+void
+Controller::set_battery_level(int level)
+{
+  if (m_battery_level != level)
+  {
+    m_battery_level = level;
+    if (m_battery_cb)
+    {
+      m_battery_cb();
+    }
+  }
+}
+
+void
+Controller::set_battery_cb(const boost::function<void ()>& callback)
+{
+  m_battery_cb = callback;
+}
+
 bool
 Controller::is_disconnected() const
 {
@@ -129,7 +174,13 @@ void
 Controller::send_disconnect()
 {
   m_is_disconnected = true;
-  m_disconnect_cb();
+
+  // the callback is only set once the controller is handed to the
+  // main loop, it might disconnect before that
+  if (m_disconnect_cb)
+  {
+    m_disconnect_cb();
+  }
 }
 
 /* EOF */
@@ -37,6 +37,7 @@ protected:
   boost::function<void (const XboxGenericMsg&)> m_msg_cb;
   boost::function<void ()> m_disconnect_cb;
   boost::function<void ()> m_activation_cb;
+  boost::function<void ()> m_battery_cb;
   bool m_is_disconnected;
   bool m_is_active;
   udev_device* m_udev_device;
@@ -44,6 +45,9 @@ protected:
   uint8_t m_led_status;
   uint8_t m_rumble_left;
   uint8_t m_rumble_right;
+  uint8_t m_rumble_scale;
+
+  int m_battery_level;
 
 public:
   Controller();
@@ -51,6 +55,10 @@ public:
 
   void set_rumble(uint8_t left, uint8_t right);
 
+  /** Scale all rumble by \a scale/255, e.g. to save battery, the
+      current rumble is resent with the new scale */
+  void set_rumble_scale(uint8_t scale);
+
   uint8_t get_led() const { return m_led_status; }
   void set_led(uint8_t status);
 
@@ -71,17 +79,34 @@ public:
   virtual void set_disconnect_cb(const boost::function<void ()>& callback);
   virtual void send_disconnect();
 
+  /** Battery charge in percent, -1 for controllers that don't
+      report it */
+  int get_battery_level() const { return m_battery_level; }
+  void set_battery_cb(const boost::function<void ()>& callback);
+
+  /** Number of reads from the device that failed, a measure of the
+      link quality */
+  virtual int get_error_count() const { return 0; }
+
   virtual std::string get_usbpath() const { return "-1:-1"; }
   virtual std::string get_usbid() const   { return "-1:-1"; }
   virtual std::string get_name() const    { return "<not implemented>"; }
+  virtual std::string get_serial() const  { return std::string(); }
 
   void set_message_cb(const boost::function<void(const XboxGenericMsg&)>& msg_cb);
 
+  /** The clock in usec that the messages of this controller are
+      processed with, a replay substitutes the time of the recording */
+  virtual int64_t get_time() const;
+
   void set_udev_device(udev_device* udev_dev);
   udev_device* get_udev_device() const;
 
   void submit_msg(const XboxGenericMsg& msg);
 
+protected:
+  void set_battery_level(int level);
+
 private:
   Controller (const Controller&);
   Controller& operator= (const Controller&);
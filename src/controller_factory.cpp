@@ -18,6 +18,7 @@
 
 #include "controller_factory.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 #include "firestorm_dual_controller.hpp"
@@ -25,13 +26,60 @@
 #include "playstation3_usb_controller.hpp"
 #include "saitek_p2500_controller.hpp"
 #include "saitek_p3600_controller.hpp"
+#include "synthetic_controller.hpp"
+#include "usb_controller.hpp"
 #include "xbox360_controller.hpp"
 #include "xbox360_wireless_controller.hpp"
+#include "xbox360_wireless_receiver.hpp"
 #include "xbox_controller.hpp"
 
+namespace {
+
+/** USBController ignore input until they are fully constructed, a
+    wireless receiver only once all of its pads are */
+void set_ready(const ControllerPtr& controller)
+{
+  USBController* usb_controller = dynamic_cast<USBController*>(controller.get());
+  if (usb_controller)
+  {
+    usb_controller->set_ready();
+  }
+
+  Xbox360WirelessController* wireless = dynamic_cast<Xbox360WirelessController*>(controller.get());
+  if (wireless && wireless->get_receiver())
+  {
+    wireless->get_receiver()->set_ready();
+  }
+}
+
+/** All pads of a receiver share it, offline pads don't have one */
+boost::shared_ptr<Xbox360WirelessReceiver> create_wireless_receiver(libusb_device* dev, bool try_detach)
+{
+  if (!dev)
+  {
+    return boost::shared_ptr<Xbox360WirelessReceiver>();
+  }
+  else
+  {
+    return boost::shared_ptr<Xbox360WirelessReceiver>(new Xbox360WirelessReceiver(dev, try_detach));
+  }
+}
+
+} // namespace
+
 ControllerPtr
 ControllerFactory::create(const XPadDevice& dev_type, libusb_device* dev, const Options& opts)
 {
+  ControllerPtr controller = create_unready(dev_type, dev, opts);
+  set_ready(controller);
+  return controller;
+}
+
+ControllerPtr
+ControllerFactory::create_unready(const XPadDevice& dev_type, libusb_device* dev, const Options& opts)
+{
+  const bool try_detach = opts.detach_kernel_driver || (dev_type.quirks & XPAD_QUIRK_DETACH_KERNEL_DRIVER);
+
   switch (dev_type.type)
   {
     case GAMEPAD_XBOX360_PLAY_N_CHARGE:
@@ -44,7 +92,7 @@ ControllerFactory::create(const XPadDevice& dev_type, libusb_device* dev, const
 
     case GAMEPAD_XBOX:
     case GAMEPAD_XBOX_MAT:
-      return ControllerPtr(new XboxController(dev, opts.detach_kernel_driver));
+      return ControllerPtr(new XboxController(dev, try_detach));
 
     case GAMEPAD_XBOX360:
     case GAMEPAD_XBOX360_GUITAR:
@@ -54,32 +102,42 @@ ControllerFactory::create(const XPadDevice& dev_type, libusb_device* dev, const
                                                  opts.headset_debug,
                                                  opts.headset_dump,
                                                  opts.headset_play,
-                                                 opts.detach_kernel_driver));
+                                                 try_detach));
       break;
 
     case GAMEPAD_XBOX360_WIRELESS:
-      return ControllerPtr(new Xbox360WirelessController(dev, opts.wireless_id, opts.detach_kernel_driver));
+      return ControllerPtr(new Xbox360WirelessController(create_wireless_receiver(dev, try_detach),
+                                                         opts.wireless_id));
 
     case GAMEPAD_FIRESTORM:
-      return ControllerPtr(new FirestormDualController(dev, false, opts.detach_kernel_driver));
+      return ControllerPtr(new FirestormDualController(dev, false, try_detach));
 
     case GAMEPAD_FIRESTORM_VSB:
-      return ControllerPtr(new FirestormDualController(dev, true, opts.detach_kernel_driver));
+      return ControllerPtr(new FirestormDualController(dev, true, try_detach));
 
     case GAMEPAD_SAITEK_P2500:
-      return ControllerPtr(new SaitekP2500Controller(dev, opts.detach_kernel_driver));
+      return ControllerPtr(new SaitekP2500Controller(dev, try_detach));
 
     case GAMEPAD_SAITEK_P3600:
-      return ControllerPtr(new SaitekP3600Controller(dev, opts.detach_kernel_driver));
+      return ControllerPtr(new SaitekP3600Controller(dev, try_detach));
 
     case GAMEPAD_PLAYSTATION3_USB:
-      return ControllerPtr(new Playstation3USBController(dev, opts.detach_kernel_driver));
+      return ControllerPtr(new Playstation3USBController(dev, try_detach));
 
     case GAMEPAD_GENERIC_USB:
       {
-        Options::GenericUSBSpec spec = opts.find_generic_usb_spec(dev_type.idVendor, dev_type.idProduct);
-        return ControllerPtr(new GenericUSBController(dev, spec.m_interface, spec.m_endpoint,
-                                                      opts.detach_kernel_driver));
+        // the device file can supply interface and endpoint directly
+        if (dev_type.endpoint != 0)
+        {
+          return ControllerPtr(new GenericUSBController(dev, dev_type.interface, dev_type.endpoint,
+                                                        try_detach));
+        }
+        else
+        {
+          Options::GenericUSBSpec spec = opts.find_generic_usb_spec(dev_type.idVendor, dev_type.idProduct);
+          return ControllerPtr(new GenericUSBController(dev, spec.m_interface, spec.m_endpoint,
+                                                        try_detach));
+        }
       }
 
     default:
@@ -87,9 +145,19 @@ ControllerFactory::create(const XPadDevice& dev_type, libusb_device* dev, const
   }
 }
 
+ControllerPtr
+ControllerFactory::create_synthetic(int id, const Options& opts)
+{
+  return ControllerPtr(new SyntheticController(opts.synthetic_type, id,
+                                               opts.synthetic_rate, opts.synthetic_random,
+                                               opts));
+}
+
 std::vector<ControllerPtr>
 ControllerFactory::create_multiple(const XPadDevice& dev_type, libusb_device* dev, const Options& opts)
 {
+  const bool try_detach = opts.detach_kernel_driver || (dev_type.quirks & XPAD_QUIRK_DETACH_KERNEL_DRIVER);
+
   std::vector<ControllerPtr> lst;
 
   switch (dev_type.type)
@@ -104,7 +172,7 @@ ControllerFactory::create_multiple(const XPadDevice& dev_type, libusb_device* de
 
     case GAMEPAD_XBOX:
     case GAMEPAD_XBOX_MAT:
-      lst.push_back(ControllerPtr(new XboxController(dev, opts.detach_kernel_driver)));
+      lst.push_back(ControllerPtr(new XboxController(dev, try_detach)));
       break;
 
     case GAMEPAD_XBOX360:
@@ -115,41 +183,52 @@ ControllerFactory::create_multiple(const XPadDevice& dev_type, libusb_device* de
                                                         opts.headset_debug,
                                                         opts.headset_dump,
                                                         opts.headset_play,
-                                                        opts.detach_kernel_driver)));
+                                                        try_detach)));
       break;
 
     case GAMEPAD_XBOX360_WIRELESS:
-      for(int wireless_id = 0; wireless_id < 4; ++wireless_id)
       {
-        lst.push_back(ControllerPtr(new Xbox360WirelessController(dev, wireless_id, opts.detach_kernel_driver)));
+        boost::shared_ptr<Xbox360WirelessReceiver> receiver = create_wireless_receiver(dev, try_detach);
+        for(int wireless_id = 0; wireless_id < Xbox360WirelessReceiver::kMaxPads; ++wireless_id)
+        {
+          lst.push_back(ControllerPtr(new Xbox360WirelessController(receiver, wireless_id)));
+        }
       }
       break;
 
     case GAMEPAD_FIRESTORM:
-      lst.push_back(ControllerPtr(new FirestormDualController(dev, false, opts.detach_kernel_driver)));
+      lst.push_back(ControllerPtr(new FirestormDualController(dev, false, try_detach)));
       break;
 
     case GAMEPAD_FIRESTORM_VSB:
-      lst.push_back(ControllerPtr(new FirestormDualController(dev, true, opts.detach_kernel_driver)));
+      lst.push_back(ControllerPtr(new FirestormDualController(dev, true, try_detach)));
       break;
 
     case GAMEPAD_SAITEK_P2500:
-      lst.push_back(ControllerPtr(new SaitekP2500Controller(dev, opts.detach_kernel_driver)));
+      lst.push_back(ControllerPtr(new SaitekP2500Controller(dev, try_detach)));
       break;
     
     case GAMEPAD_SAITEK_P3600:
-      lst.push_back(ControllerPtr(new SaitekP3600Controller(dev, opts.detach_kernel_driver)));
+      lst.push_back(ControllerPtr(new SaitekP3600Controller(dev, try_detach)));
       break;
 
     case GAMEPAD_PLAYSTATION3_USB:
-      lst.push_back(ControllerPtr(new Playstation3USBController(dev, opts.detach_kernel_driver)));
+      lst.push_back(ControllerPtr(new Playstation3USBController(dev, try_detach)));
       break;
 
     case GAMEPAD_GENERIC_USB:
       {
-        Options::GenericUSBSpec spec = opts.find_generic_usb_spec(dev_type.idVendor, dev_type.idProduct);
-        lst.push_back(ControllerPtr(new GenericUSBController(dev, spec.m_interface, spec.m_endpoint,
-                                                             opts.detach_kernel_driver)));
+        if (dev_type.endpoint != 0)
+        {
+          lst.push_back(ControllerPtr(new GenericUSBController(dev, dev_type.interface, dev_type.endpoint,
+                                                               try_detach)));
+        }
+        else
+        {
+          Options::GenericUSBSpec spec = opts.find_generic_usb_spec(dev_type.idVendor, dev_type.idProduct);
+          lst.push_back(ControllerPtr(new GenericUSBController(dev, spec.m_interface, spec.m_endpoint,
+                                                               try_detach)));
+        }
       }
       break;
 
@@ -157,6 +236,8 @@ ControllerFactory::create_multiple(const XPadDevice& dev_type, libusb_device* de
       assert(!"unknown gamepad type");
   }
 
+  std::for_each(lst.begin(), lst.end(), set_ready);
+
   return lst;
 }
 
@@ -34,6 +34,16 @@ public:
   static std::vector<ControllerPtr> create_multiple(const XPadDevice& dev_type,
                                                     libusb_device* dev, const Options& opts);
 
+  /** Create a controller without hardware that generates its own
+      input as configured by --synthetic, \a id tells multiple ones
+      apart */
+  static ControllerPtr create_synthetic(int id, const Options& opts);
+
+private:
+  static ControllerPtr create_unready(const XPadDevice& dev_type,
+                                      libusb_device* dev,
+                                      const Options& opts);
+
 private:
   ControllerFactory(const ControllerFactory&);
   ControllerFactory& operator=(const ControllerFactory&);
@@ -0,0 +1,181 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "controller_match_index.hpp"
+
+#include <algorithm>
+
+namespace {
+
+uint32_t make_usbid_key(int vendor, int product)
+{
+  return (static_cast<uint32_t>(vendor) << 16) | (static_cast<uint32_t>(product) & 0xffff);
+}
+
+uint32_t make_usbpath_key(int busnum, int devnum)
+{
+  return (static_cast<uint32_t>(busnum) << 16) | (static_cast<uint32_t>(devnum) & 0xffff);
+}
+
+} // namespace
+
+ControllerMatchIndex::ControllerMatchIndex() :
+  m_usbid(),
+  m_usbpath(),
+  m_serial(),
+  m_unindexed(),
+  m_match_all()
+{
+}
+
+void
+ControllerMatchIndex::clear()
+{
+  m_usbid.clear();
+  m_usbpath.clear();
+  m_serial.clear();
+  m_unindexed.clear();
+  m_match_all.clear();
+}
+
+void
+ControllerMatchIndex::add_slot(int slot, const std::vector<ControllerMatchRulePtr>& rules)
+{
+  if (rules.empty())
+  {
+    m_match_all.push_back(slot);
+  }
+  else
+  {
+    for(std::vector<ControllerMatchRulePtr>::const_iterator rule = rules.begin(); rule != rules.end(); ++rule)
+    {
+      Entry entry(slot, *rule);
+
+      if (add_key(entry, rule->get()))
+      {
+        // rule is indexed by its own key
+      }
+      else if (const ControllerMatchRuleGroup* group = dynamic_cast<const ControllerMatchRuleGroup*>(rule->get()))
+      {
+        // a group can only match when all its rules match, so it is
+        // enough to index it by the first indexable rule in it
+        bool indexed = false;
+        for(std::vector<ControllerMatchRulePtr>::const_iterator i = group->get_rules().begin();
+            i != group->get_rules().end() && !indexed; ++i)
+        {
+          indexed = add_key(entry, i->get());
+        }
+
+        if (!indexed)
+        {
+          m_unindexed.push_back(entry);
+        }
+      }
+      else
+      {
+        m_unindexed.push_back(entry);
+      }
+    }
+  }
+
+  std::sort(m_match_all.begin(), m_match_all.end());
+}
+
+bool
+ControllerMatchIndex::add_key(const Entry& entry, const ControllerMatchRule* rule)
+{
+  if (const ControllerMatchRuleUSBId* usbid = dynamic_cast<const ControllerMatchRuleUSBId*>(rule))
+  {
+    if (usbid->get_vendor() != -1 && usbid->get_product() != -1)
+    {
+      m_usbid.insert(std::make_pair(make_usbid_key(usbid->get_vendor(), usbid->get_product()), entry));
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  else if (const ControllerMatchRuleUSBPath* usbpath = dynamic_cast<const ControllerMatchRuleUSBPath*>(rule))
+  {
+    m_usbpath.insert(std::make_pair(make_usbpath_key(usbpath->get_busnum(), usbpath->get_devnum()), entry));
+    return true;
+  }
+  else if (const ControllerMatchRuleUSBSerial* serial = dynamic_cast<const ControllerMatchRuleUSBSerial*>(rule))
+  {
+    m_serial.insert(std::make_pair(serial->get_serial(), entry));
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+template<typename Map, typename Key>
+void
+ControllerMatchIndex::find_in(const Map& map, const Key& key, const ControllerMatchInfo& info,
+                              std::vector<int>& slots) const
+{
+  std::pair<typename Map::const_iterator, typename Map::const_iterator> range = map.equal_range(key);
+  for(typename Map::const_iterator i = range.first; i != range.second; ++i)
+  {
+    // the key only narrows down the candidates, the rule itself
+    // still has to match, as a group may contain further rules
+    if (i->second.rule->match(info))
+    {
+      slots.push_back(i->second.slot);
+    }
+  }
+}
+
+std::vector<int>
+ControllerMatchIndex::find(const ControllerMatchInfo& info) const
+{
+  std::vector<int> slots;
+
+  if (info.has_usbid)
+  {
+    find_in(m_usbid, make_usbid_key(info.vendor, info.product), info, slots);
+  }
+
+  if (info.has_usbpath)
+  {
+    find_in(m_usbpath, make_usbpath_key(info.busnum, info.devnum), info, slots);
+  }
+
+  if (info.has_serial)
+  {
+    find_in(m_serial, info.serial, info, slots);
+  }
+
+  for(std::vector<Entry>::const_iterator i = m_unindexed.begin(); i != m_unindexed.end(); ++i)
+  {
+    if (i->rule->match(info))
+    {
+      slots.push_back(i->slot);
+    }
+  }
+
+  std::sort(slots.begin(), slots.end());
+  slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+  return slots;
+}
+
+/* EOF */
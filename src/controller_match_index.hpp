@@ -0,0 +1,87 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_XBOXDRV_CONTROLLER_MATCH_INDEX_HPP
+#define HEADER_XBOXDRV_CONTROLLER_MATCH_INDEX_HPP
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "controller_match_rule.hpp"
+
+/** Maps a device to the slots whose match rules accept it. Rules that
+    name a usbid, usbpath or usbserial (directly or as part of a group)
+    are stored in maps keyed by that value, so a hotplug event only
+    evaluates the few rules that can possibly match, all other rules
+    are evaluated one by one. */
+class ControllerMatchIndex
+{
+private:
+  struct Entry
+  {
+    Entry(int slot_, ControllerMatchRulePtr rule_) :
+      slot(slot_),
+      rule(rule_)
+    {}
+
+    int slot;
+    ControllerMatchRulePtr rule;
+  };
+
+  typedef std::multimap<uint32_t, Entry> IdMap;
+  typedef std::multimap<std::string, Entry> SerialMap;
+
+  IdMap m_usbid;
+  IdMap m_usbpath;
+  SerialMap m_serial;
+  std::vector<Entry> m_unindexed;
+  std::vector<int> m_match_all;
+
+public:
+  ControllerMatchIndex();
+
+  void clear();
+
+  /** Add the rules of slot \a slot, a slot without rules matches
+      every device */
+  void add_slot(int slot, const std::vector<ControllerMatchRulePtr>& rules);
+
+  /** Returns the slots that have a rule matching \a info, sorted by
+      slot id */
+  std::vector<int> find(const ControllerMatchInfo& info) const;
+
+  /** Returns the slots that don't have any rules, sorted by slot id */
+  const std::vector<int>& get_match_all() const { return m_match_all; }
+
+private:
+  bool add_key(const Entry& entry, const ControllerMatchRule* rule);
+
+  template<typename Map, typename Key>
+  void find_in(const Map& map, const Key& key, const ControllerMatchInfo& info,
+               std::vector<int>& slots) const;
+
+private:
+  ControllerMatchIndex(const ControllerMatchIndex&);
+  ControllerMatchIndex& operator=(const ControllerMatchIndex&);
+};
+
+#endif
+
+/* EOF */
@@ -18,11 +18,71 @@
 
 #include "controller_match_rule.hpp"
 
-#include <assert.h>
+#include <boost/lexical_cast.hpp>
 #include <boost/tokenizer.hpp>
+#include <stdlib.h>
 
+#include "helper.hpp"
 #include "raise_exception.hpp"
+
+namespace {
+
+bool get_int_property(udev_device* device, const char* name, int base, int* value)
+{
+  const char* str = udev_device_get_property_value(device, name);
+  if (!str)
+  {
+    return false;
+  }
+  else
+  {
+    char* end;
+    *value = static_cast<int>(strtol(str, &end, base));
+    return (*str != '\0' && *end == '\0');
+  }
+}
+
+} // namespace
+
+ControllerMatchInfo::ControllerMatchInfo(udev_device* device_) :
+  device(device_),
+  has_usbid(false),
+  vendor(0),
+  product(0),
+  has_usbpath(false),
+  busnum(0),
+  devnum(0),
+  has_serial(false),
+  serial()
+{
+  has_usbid = (get_int_property(device, "ID_VENDOR_ID", 16, &vendor) &&
+               get_int_property(device, "ID_MODEL_ID",  16, &product));
+
+  // busnum:devnum are decimal, not hex
+  has_usbpath = (get_int_property(device, "BUSNUM", 10, &busnum) &&
+                 get_int_property(device, "DEVNUM", 10, &devnum));
+
+  const char* serial_str = udev_device_get_property_value(device, "ID_SERIAL_SHORT");
+  if (serial_str)
+  {
+    has_serial = true;
+    serial = serial_str;
+  }
+}
 
+ControllerMatchInfo::ControllerMatchInfo(const ControllerMatchInfo& other) :
+  device(other.device),
+  has_usbid(other.has_usbid),
+  vendor(other.vendor),
+  product(other.product),
+  has_usbpath(other.has_usbpath),
+  busnum(other.busnum),
+  devnum(other.devnum),
+  has_serial(other.has_serial),
+  serial(other.serial)
+{
+}
+
 class ControllerMatchRuleProperty : public ControllerMatchRule
 {
 private:
@@ -36,9 +96,9 @@ public:
     m_value(value)
   {}
 
-  bool match(udev_device* device) const
+  bool match(const ControllerMatchInfo& info) const
   {
-    const char* str = udev_device_get_property_value(device, m_name.c_str());
+    const char* str = udev_device_get_property_value(info.device, m_name.c_str());
 
     log_debug("matching property '" << m_name << "' with value '" << (str?str:"(null)") <<
               "' against '" << m_value);
@@ -71,12 +131,12 @@ ControllerMatchRuleGroup::add_rule_from_string(const std::string& lhs, const std
 }
 
 bool
-ControllerMatchRuleGroup::match(udev_device* device) const
+ControllerMatchRuleGroup::match(const ControllerMatchInfo& info) const
 {
   log_debug("matching group rule");
   for(Rules::const_iterator i = m_rules.begin(); i != m_rules.end(); ++i)
   {
-    if (!(*i)->match(device))
+    if (!(*i)->match(info))
     {
       return false;
     }
@@ -84,38 +144,40 @@ ControllerMatchRuleGroup::match(udev_device* device) const
   return true;
 }
 
+ControllerMatchRuleUSBId::ControllerMatchRuleUSBId(int vendor, int product) :
+  m_vendor(vendor),
+  m_product(product)
+{}
+
 bool
-ControllerMatchRule::match(udev_device* device) const
+ControllerMatchRuleUSBId::match(const ControllerMatchInfo& info) const
 {
-  assert(!"implement me");
-  return false;
-#if 0
-        const char* serial = udev_device_get_property_value(device, "ID_SERIAL_SHORT");
-
-
-  switch(m_type)
-  {
-    case kMatchEverything:
-      return true;
-
-    case kMatchUSBId:
-      return (vendor == m_vendor && product == m_product);
+  return (info.has_usbid &&
+          (m_vendor  == -1 || m_vendor  == info.vendor) &&
+          (m_product == -1 || m_product == info.product));
+}
 
-    case kMatchUSBPath:
-      return (bus == m_bus && dev == m_dev);
+ControllerMatchRuleUSBPath::ControllerMatchRuleUSBPath(int busnum, int devnum) :
+  m_busnum(busnum),
+  m_devnum(devnum)
+{}
 
-    case kMatchUSBSerial:
-      return serial && (m_serial == serial);
+bool
+ControllerMatchRuleUSBPath::match(const ControllerMatchInfo& info) const
+{
+  return (info.has_usbpath &&
+          m_busnum == info.busnum &&
+          m_devnum == info.devnum);
+}
 
-    case kMatchEvdevPath:
-      assert(!"not implemented");
-      return false;
+ControllerMatchRuleUSBSerial::ControllerMatchRuleUSBSerial(const std::string& serial) :
+  m_serial(serial)
+{}
 
-    default:
-      assert(!"never reached");
-      return false;
-  }
-#endif
+bool
+ControllerMatchRuleUSBSerial::match(const ControllerMatchInfo& info) const
+{
+  return (info.has_serial && m_serial == info.serial);
 }
 
 ControllerMatchRulePtr
@@ -134,12 +196,7 @@ ControllerMatchRule::from_string(const std::string& lhs,
     }
     else
     {
-      boost::shared_ptr<ControllerMatchRuleGroup> group(new ControllerMatchRuleGroup);
-
-      group->add_rule(ControllerMatchRulePtr(new ControllerMatchRuleProperty("ID_VENDOR_ID", args[0])));
-      group->add_rule(ControllerMatchRulePtr(new ControllerMatchRuleProperty("ID_MODEL_ID", args[1])));
-
-      return group;
+      return ControllerMatchRulePtr(new ControllerMatchRuleUSBId(hexstr2int(args[0]), hexstr2int(args[1])));
     }
   }
   else if (lhs == "vendor")
@@ -150,7 +207,7 @@ ControllerMatchRule::from_string(const std::string& lhs,
     }
     else
     {
-      return ControllerMatchRulePtr(new ControllerMatchRuleProperty("ID_VENDOR_ID", args[0]));
+      return ControllerMatchRulePtr(new ControllerMatchRuleUSBId(hexstr2int(args[0]), -1));
     }
   }
   else if (lhs == "product")
@@ -161,7 +218,7 @@ ControllerMatchRule::from_string(const std::string& lhs,
     }
     else
     {
-      return ControllerMatchRulePtr(new ControllerMatchRuleProperty("ID_MODEL_ID", args[0]));
+      return ControllerMatchRulePtr(new ControllerMatchRuleUSBId(-1, hexstr2int(args[0])));
     }
   }
   else if (lhs == "property")
@@ -183,12 +240,8 @@ ControllerMatchRule::from_string(const std::string& lhs,
     }
     else
     {
-      boost::shared_ptr<ControllerMatchRuleGroup> group(new ControllerMatchRuleGroup);
-
-      group->add_rule(ControllerMatchRulePtr(new ControllerMatchRuleProperty("BUSNUM", args[0])));
-      group->add_rule(ControllerMatchRulePtr(new ControllerMatchRuleProperty("DEVNUM", args[1])));
-
-      return group;
+      return ControllerMatchRulePtr(new ControllerMatchRuleUSBPath(boost::lexical_cast<int>(args[0]),
+                                                                   boost::lexical_cast<int>(args[1])));
     }
   }
   else if (lhs == "usbserial")
@@ -199,7 +252,7 @@ ControllerMatchRule::from_string(const std::string& lhs,
     }
     else
     {
-      return ControllerMatchRulePtr(new ControllerMatchRuleProperty("ID_SERIAL_SHORT", args[0]));
+      return ControllerMatchRulePtr(new ControllerMatchRuleUSBSerial(args[0]));
     }
   }
   else if (lhs == "evdev")
@@ -30,6 +30,34 @@ struct udev_device;
 class ControllerMatchRule;
 typedef boost::shared_ptr<ControllerMatchRule> ControllerMatchRulePtr;
 
+/** The device attributes the match rules look at, extracted from the
+    udev_device once per hotplug event, so that evaluating the rules
+    doesn't need to query udev and parse strings again for every rule */
+struct ControllerMatchInfo
+{
+  ControllerMatchInfo(udev_device* device_);
+
+  /** A shallow copy, the copy doesn't hold its own reference to
+      \a device */
+  ControllerMatchInfo(const ControllerMatchInfo& other);
+
+  udev_device* device;
+
+  bool has_usbid;
+  int  vendor;
+  int  product;
+
+  bool has_usbpath;
+  int  busnum;
+  int  devnum;
+
+  bool has_serial;
+  std::string serial;
+
+private:
+  ControllerMatchInfo& operator=(const ControllerMatchInfo&);
+};
+
 class ControllerMatchRule
 {
 public:
@@ -40,7 +68,7 @@ public:
   ControllerMatchRule() {}
   virtual ~ControllerMatchRule() {}
 
-  virtual bool match(udev_device* device) const =0;
+  virtual bool match(const ControllerMatchInfo& info) const =0;
 };
 
 class ControllerMatchRuleGroup : public ControllerMatchRule
@@ -54,9 +82,55 @@ public:
 
   void add_rule(ControllerMatchRulePtr rule);
   void add_rule_from_string(const std::string& lhs, const std::string& rhs);
-  bool match(udev_device* device) const;
+  bool match(const ControllerMatchInfo& info) const;
+
+  const std::vector<ControllerMatchRulePtr>& get_rules() const { return m_rules; }
 };
 
+/** Matches vendor and product id, -1 matches any value */
+class ControllerMatchRuleUSBId : public ControllerMatchRule
+{
+private:
+  int m_vendor;
+  int m_product;
+
+public:
+  ControllerMatchRuleUSBId(int vendor, int product);
+
+  bool match(const ControllerMatchInfo& info) const;
+
+  int get_vendor() const { return m_vendor; }
+  int get_product() const { return m_product; }
+};
+
+class ControllerMatchRuleUSBPath : public ControllerMatchRule
+{
+private:
+  int m_busnum;
+  int m_devnum;
+
+public:
+  ControllerMatchRuleUSBPath(int busnum, int devnum);
+
+  bool match(const ControllerMatchInfo& info) const;
+
+  int get_busnum() const { return m_busnum; }
+  int get_devnum() const { return m_devnum; }
+};
+
+class ControllerMatchRuleUSBSerial : public ControllerMatchRule
+{
+private:
+  std::string m_serial;
+
+public:
+  ControllerMatchRuleUSBSerial(const std::string& serial);
+
+  bool match(const ControllerMatchInfo& info) const;
+
+  const std::string& get_serial() const { return m_serial; }
+};
+
 #endif
 
 /* EOF */
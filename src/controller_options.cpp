@@ -27,6 +27,8 @@ ControllerOptions::ControllerOptions() :
   deadzone_trigger(0),
   square_axis(false),
   four_way_restrictor(0),
+  auto_calibration(false),
+  calibration_file(),
   dpad_rotation(0),
 
   calibration_map(),
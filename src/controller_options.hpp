@@ -43,6 +43,8 @@ public:
   int  deadzone_trigger;
   bool square_axis;
   bool four_way_restrictor;
+  bool auto_calibration;
+  std::string calibration_file;
   int  dpad_rotation;
 
   std::map<XboxAxis, AxisFilterPtr> calibration_map;
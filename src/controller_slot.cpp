@@ -18,10 +18,18 @@
 
 #include "controller_slot.hpp"
 
+#include <algorithm>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
+#include <sstream>
 
+#include "controller.hpp"
+#include "log.hpp"
+#include "options.hpp"
+#include "spawn_service.hpp"
 #include "uinput_message_processor.hpp"
 #include "dummy_message_processor.hpp"
+#include "state_publisher.hpp"
 
 ControllerSlot::ControllerSlot(int id_,
                                ControllerSlotConfigPtr config_,
@@ -35,7 +43,10 @@ ControllerSlot::ControllerSlot(int id_,
   m_led_status(led_status_),
   m_thread(),
   m_opts(opts),
-  m_uinput(uinput)
+  m_uinput(uinput),
+  m_status(),
+  m_status_cb(),
+  m_normal_led(-1)
 {}
 
 void
@@ -46,13 +57,27 @@ ControllerSlot::connect(ControllerPtr controller)
   std::auto_ptr<MessageProcessor> message_proc;
   if (m_uinput)
   {
-    message_proc.reset(new UInputMessageProcessor(*m_uinput, m_config, m_opts));
+    message_proc.reset(new UInputMessageProcessor(*m_uinput, m_config, m_id, m_opts));
   }
   else
   {
     message_proc.reset(new DummyMessageProcessor());
   }
-  m_thread.reset(new ControllerThread(controller, message_proc, m_opts));
+  if (m_config)
+  {
+    m_config->connect(*controller);
+  }
+  m_thread.reset(new ControllerThread(controller, message_proc, m_opts, &m_status));
+
+  g_state_publisher.set_connected(m_id, true);
+
+  m_status.connect(controller->get_time(), controller->get_error_count());
+  send_status(PadStatus::kConnected);
+
+  // the battery might have been reported before the controller got
+  // its slot
+  controller->set_battery_cb(boost::bind(&ControllerSlot::on_battery, this));
+  on_battery();
 }
 
 ControllerPtr
@@ -62,6 +87,30 @@ ControllerSlot::disconnect()
 
   ControllerPtr controller = m_thread->get_controller();
   m_thread.reset();
+  if (m_config)
+  {
+    // relative motion keeps going until its velocity is set back to
+    // zero, so release everything that was still held when the
+    // controller went away
+    if (!m_config->empty())
+    {
+      m_config->get_config()->get_uinput().reset_all_outputs();
+    }
+    m_config->disconnect();
+  }
+
+  g_state_publisher.set_connected(m_id, false);
+
+  controller->set_battery_cb(boost::function<void ()>());
+  if (m_status.is_low_battery() && !controller->is_disconnected())
+  {
+    set_power_saving(controller, false);
+  }
+  m_normal_led = -1;
+
+  m_status.update(controller->get_time(), controller->get_error_count());
+  m_status.disconnect();
+  send_status(PadStatus::kDisconnected);
 
   return controller;
 }
@@ -72,4 +121,113 @@ ControllerSlot::is_connected() const
   return m_thread;
 }
 
+void
+ControllerSlot::update_status()
+{
+  ControllerPtr controller = get_controller();
+  if (controller)
+  {
+    m_status.update(controller->get_time(), controller->get_error_count());
+  }
+}
+
+std::string
+ControllerSlot::get_status_str()
+{
+  update_status();
+  return m_status.str();
+}
+
+void
+ControllerSlot::on_battery()
+{
+  ControllerPtr controller = get_controller();
+  assert(controller);
+
+  int level = controller->get_battery_level();
+  if (m_status.set_battery_level(level))
+  {
+    send_status(PadStatus::kBatteryChanged);
+
+    bool low = (level >= 0 && level <= m_opts.low_battery);
+    if (low != m_status.is_low_battery())
+    {
+      set_low_battery(low);
+    }
+  }
+}
+
+void
+ControllerSlot::set_low_battery(bool low)
+{
+  ControllerPtr controller = get_controller();
+
+  m_status.set_low_battery(low);
+  set_power_saving(controller, low);
+
+  if (low)
+  {
+    log_warn("slot " << m_id << ": battery low: " << m_status.get_battery_level() << "%");
+
+    if (!m_opts.on_low_battery.empty())
+    {
+      log_info("launching low battery script: " << m_opts.on_low_battery);
+
+      std::vector<std::string> args;
+      args.push_back(m_opts.on_low_battery);
+      args.push_back(controller->get_usbpath());
+      args.push_back(controller->get_usbid());
+      args.push_back(controller->get_name());
+      args.push_back((boost::format("%d") % m_status.get_battery_level()).str());
+      g_spawn_service.spawn(SpawnService::encode(args));
+    }
+
+    send_status(PadStatus::kLowBattery);
+  }
+  else
+  {
+    log_info("slot " << m_id << ": battery ok: " << m_status.get_battery_level() << "%");
+  }
+}
+
+void
+ControllerSlot::set_power_saving(ControllerPtr controller, bool enable)
+{
+  // called from the input path, a failed write must not escape
+  try
+  {
+    if (enable)
+    {
+      if (m_opts.low_battery_led != -1)
+      {
+        m_normal_led = controller->get_led();
+        controller->set_led(static_cast<uint8_t>(m_opts.low_battery_led));
+      }
+      controller->set_rumble_scale(static_cast<uint8_t>(std::max(0, std::min(m_opts.low_battery_rumble_gain, 255))));
+    }
+    else
+    {
+      if (m_normal_led != -1)
+      {
+        controller->set_led(static_cast<uint8_t>(m_normal_led));
+        m_normal_led = -1;
+      }
+      controller->set_rumble_scale(255);
+    }
+  }
+  catch(const std::exception& err)
+  {
+    log_error("failed to change power saving: " << err.what());
+  }
+}
+
+void
+ControllerSlot::send_status(PadStatus::Event event)
+{
+  if (m_status_cb)
+  {
+    m_status_cb(event);
+  }
+}
+
 /* EOF */
@@ -19,10 +19,12 @@
 #ifndef HEADER_XBOXDRV_CONTROLLER_SLOT_HPP
 #define HEADER_XBOXDRV_CONTROLLER_SLOT_HPP
 
+#include <boost/function.hpp>
 #include <vector>
 
 #include "controller_slot_config.hpp"
 #include "controller_thread.hpp"
+#include "pad_status.hpp"
 
 class ControllerSlot
 {
@@ -36,6 +38,12 @@ private:
   const Options& m_opts;
   UInput* m_uinput;
 
+  PadStatus m_status;
+  boost::function<void (PadStatus::Event)> m_status_cb;
+  /** the LED the controller had before it was switched to the
+      low battery one */
+  int m_normal_led;
+
 public:
   ControllerSlot(int id_,
                  ControllerSlotConfigPtr config_,
@@ -56,6 +64,22 @@ public:
   ControllerThreadPtr get_thread() const { return m_thread; }
   ControllerPtr get_controller() const { return m_thread ? m_thread->get_controller() : ControllerPtr(); }
 
+  const PadStatus& get_status() const { return m_status; }
+  std::string get_status_str();
+
+  /** Updates the report rate and the read errors of the status, they
+      otherwise only change when a report comes in */
+  void update_status();
+
+  /** Called on connection and battery changes */
+  void set_status_cb(const boost::function<void (PadStatus::Event)>& callback) { m_status_cb = callback; }
+
+private:
+  void on_battery();
+  void set_low_battery(bool low);
+  void set_power_saving(ControllerPtr controller, bool enable);
+  void send_status(PadStatus::Event event);
+
 private:
   ControllerSlot(const ControllerSlot&);
   ControllerSlot& operator=(const ControllerSlot&);
@@ -23,6 +23,7 @@
 #include "raise_exception.hpp"
 #include "uinput.hpp"
 
+#include "modifier/auto_calibration_modifier.hpp"
 #include "modifier/dpad_rotation_modifier.hpp"
 #include "modifier/four_way_restrictor_modifier.hpp"
 #include "modifier/square_axis_modifier.hpp"
@@ -108,6 +109,14 @@ ControllerSlotConfig::create(UInput& uinput, int slot, bool extra_devices, const
 void
 ControllerSlotConfig::create_modifier(const ControllerOptions& opts, std::vector<ModifierPtr>* modifier)
 {
+  // auto calibration comes first, as it has to see the raw values
+  // coming from the controller
+  if (opts.auto_calibration)
+  {
+    modifier->push_back(ModifierPtr(new AutoCalibrationModifier(XBOX_AXIS_X1, XBOX_AXIS_Y1, opts.calibration_file)));
+    modifier->push_back(ModifierPtr(new AutoCalibrationModifier(XBOX_AXIS_X2, XBOX_AXIS_Y2, opts.calibration_file)));
+  }
+
   if (!opts.calibration_map.empty())
   {
     boost::shared_ptr<AxismapModifier> axismap(new AxismapModifier);
@@ -302,6 +311,32 @@ ControllerSlotConfig::add_config(ControllerConfigPtr config)
   m_config.push_back(config);
 }
 
+void
+ControllerSlotConfig::connect(const Controller& controller)
+{
+  for(std::vector<ControllerConfigPtr>::iterator i = m_config.begin(); i != m_config.end(); ++i)
+  {
+    std::vector<ModifierPtr>& modifier = (*i)->get_modifier();
+    for(std::vector<ModifierPtr>::iterator mod = modifier.begin(); mod != modifier.end(); ++mod)
+    {
+      (*mod)->connect(controller);
+    }
+  }
+}
+
+void
+ControllerSlotConfig::disconnect()
+{
+  for(std::vector<ControllerConfigPtr>::iterator i = m_config.begin(); i != m_config.end(); ++i)
+  {
+    std::vector<ModifierPtr>& modifier = (*i)->get_modifier();
+    for(std::vector<ModifierPtr>::iterator mod = modifier.begin(); mod != modifier.end(); ++mod)
+    {
+      (*mod)->disconnect();
+    }
+  }
+}
+
 void
 ControllerSlotConfig::set_rumble(uint8_t strong, uint8_t weak)
 {
@@ -24,6 +24,7 @@
 #include "controller_config.hpp"
 #include "options.hpp"
 
+class Controller;
 class Options;
 class UInput;
 class ControllerSlotConfig;
@@ -61,6 +62,12 @@ public:
 
   bool empty() const { return m_config.empty(); }
 
+  /** Lets the modifier of all configs know which controller they
+      are working on, must not be called while messages are being
+      processed */
+  void connect(const Controller& controller);
+  void disconnect();
+
   void set_rumble(uint8_t strong, uint8_t weak);
   void set_ff_callback(const boost::function<void (uint8_t, uint8_t)>& callback);
 
@@ -26,19 +26,22 @@
 #include "log.hpp"
 #include "controller.hpp"
 #include "message_processor.hpp"
+#include "pad_status.hpp"
 
 extern bool global_exit_xboxdrv;
 
 ControllerThread::ControllerThread(ControllerPtr controller,
                                    std::auto_ptr<MessageProcessor> processor,
-                                   const Options& opts) :
+                                   const Options& opts,
+                                   PadStatus* status) :
   m_controller(controller),
   m_processor(processor),
   m_oldrealmsg(),
   m_timeout(opts.timeout),
   m_print_messages(!opts.silent),
   m_timeout_id(),
-  m_timer(g_timer_new())
+  m_last_update(controller->get_time()),
+  m_status(status)
 {
   memset(&m_oldrealmsg, 0, sizeof(m_oldrealmsg));
   m_timeout_id = g_timeout_add(m_timeout, &ControllerThread::on_timeout_wrap, this);
@@ -49,7 +52,6 @@ ControllerThread::ControllerThread(ControllerPtr controller,
 ControllerThread::~ControllerThread()
 {
   g_source_remove(m_timeout_id);
-  g_timer_destroy(m_timer);
 }
 
 bool
@@ -57,10 +59,11 @@ ControllerThread::on_timeout()
 {
   if (m_processor.get())
   {
-    int msec_delta = static_cast<int>(g_timer_elapsed(m_timer, NULL) * 1000.0f);
-    g_timer_reset(m_timer);
+    gint64 now = m_controller->get_time();
+    int usec_delta = static_cast<int>(now - m_last_update);
+    m_last_update = now;
 
-    m_processor->send(m_oldrealmsg, msec_delta);
+    m_processor->send(m_oldrealmsg, now, usec_delta);
   }
 
   return true; // do not remove the callback
@@ -76,12 +79,18 @@ ControllerThread::on_message(const XboxGenericMsg& msg)
 
   m_oldrealmsg = msg;
 
-  int msec_delta = static_cast<int>(g_timer_elapsed(m_timer, NULL) * 1000.0f);
-  g_timer_reset(m_timer);
+  gint64 now = m_controller->get_time();
+  int usec_delta = static_cast<int>(now - m_last_update);
+  m_last_update = now;
+
+  if (m_status)
+  {
+    m_status->report(now);
+  }
 
   if (m_processor.get())
   {
-    m_processor->send(msg, msec_delta);
+    m_processor->send(msg, now, usec_delta);
   }
 }
 
@@ -29,6 +29,7 @@
 class Options;
 class MessageProcessor;
 class ControllerThread;
+class PadStatus;
 
 typedef boost::shared_ptr<ControllerThread> ControllerThreadPtr;
 
@@ -45,11 +46,14 @@ private:
   int  m_timeout;
   bool m_print_messages;
   guint m_timeout_id;
-  GTimer* m_timer;
+  /** monotonic time of the last update in usec */
+  gint64 m_last_update;
+  PadStatus* m_status;
 
 public:
+  /** \a status, if given, counts the reports of the controller */
   ControllerThread(ControllerPtr controller, std::auto_ptr<MessageProcessor> processor,
-                   const Options& opts);
+                   const Options& opts, PadStatus* status = 0);
   ~ControllerThread();
 
   MessageProcessor* get_message_proc() const { return m_processor.get(); }
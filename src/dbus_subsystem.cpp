@@ -18,6 +18,7 @@
 
 #include "dbus_subsystem.hpp"
 
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <dbus/dbus-glib-lowlevel.h>
 //#include <dbus/dbus-glib-binding.h>
@@ -25,6 +26,7 @@
 #include <sstream>
 #include <stdexcept>
 
+#include "controller_slot.hpp"
 #include "raise_exception.hpp"
 #include "xboxdrv_g_controller.hpp"
 #include "xboxdrv_g_daemon.hpp"
@@ -95,6 +97,7 @@ DBusSubsystem::register_controller_slots(const std::vector<ControllerSlotPtr>& s
   for(std::vector<ControllerSlotPtr>::const_iterator i = slots.begin(); i != slots.end(); ++i)
   {
     XboxdrvGController* controller = xboxdrv_g_controller_new(i->get());
+    (*i)->set_status_cb(boost::bind(&xboxdrv_g_controller_send_status, controller, _1));
     dbus_g_object_type_install_info(XBOXDRV_TYPE_G_CONTROLLER, &dbus_glib_xboxdrv_controller_object_info);
     dbus_g_connection_register_g_object(m_connection,
                                         (boost::format("/org/seul/Xboxdrv/ControllerSlots/%d")
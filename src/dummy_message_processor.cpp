@@ -23,7 +23,7 @@ DummyMessageProcessor::DummyMessageProcessor()
 }
 
 void
-DummyMessageProcessor::send(const XboxGenericMsg& msg, int msec_delta)
+DummyMessageProcessor::send(const XboxGenericMsg& msg, int64_t usec_time, int usec_delta)
 {
   // do nothing as the XboxdrvThread is already doing the printing
 }
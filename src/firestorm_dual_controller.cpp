@@ -23,64 +23,29 @@
 
 #include "helper.hpp"
 #include "log.hpp"
+#include "unpack.hpp"
 #include "usb_helper.hpp"
 
-// 044f:b312
-struct Firestorm_vsb_Msg
-{
-  unsigned int a   :1;
-  unsigned int x   :1;
-  unsigned int b   :1;
-  unsigned int y   :1;
-
-  unsigned int lb  :1;
-  unsigned int lt  :1;
-  unsigned int rb  :1;
-  unsigned int rt  :1;
-
-  unsigned int back  :1;
-  unsigned int start :1;
-
-  unsigned int thumb_l :1;
-  unsigned int thumb_r :1;
-
-  unsigned int dpad :4; // 0xf == center, 0x00 == up, clockwise + 1 each
-
-  int x1 :8;
-  int y1 :8;
-  int x2 :8;
-  unsigned int y2 :8;
-} __attribute__((__packed__));
-
-// 044f:b304
-struct FirestormMsg
-{
-  unsigned int a   :1;
-  unsigned int x   :1;
-  unsigned int b   :1;
-  unsigned int y   :1;
-
-  unsigned int lb  :1;
-  unsigned int lt  :1;
-  unsigned int rb  :1;
-  unsigned int rt  :1;
+namespace {
 
-  unsigned int back  :1;
-  unsigned int start :1;
-
-  unsigned int thumb_l :1;
-  unsigned int thumb_r :1;
-
-  unsigned int dummy :4;
+/*
+   044f:b312 (VSB)
+   data[0]    a, x, b, y, lb, lt, rb, rt, from the lowest bit up
+   data[1]    back, start, thumb_l, thumb_r, dpad :4
+              (0xf == center, 0x0 == up, clockwise + 1 each)
+   data[2..5] x1, y1, x2 signed, y2 unsigned
+
+   044f:b304
+   data[0]    a, x, b, y, lb, lt, rb, rt, from the lowest bit up
+   data[1]    back, start, thumb_l, thumb_r
+   data[2]    dpad (0xf0 == center, 0x00 == up, clockwise + 0x10 each)
+   data[3..6] x1, y1, x2 signed, y2 unsigned
+*/
+const int kVSBReportSize     = 6;
+const int kDefaultReportSize = 7;
 
-  unsigned int dpad :8; // 0xf0 == center, 0x00 == up, clockwise + 10 each
+} // namespace
 
-  int x1 :8;
-  int y1 :8;
-  int x2 :8;
-  unsigned int y2 :8;
-} __attribute__((__packed__));
-
 FirestormDualController::FirestormDualController(libusb_device* dev, bool is_vsb_, bool try_detach) :
   USBController(dev),
   is_vsb(is_vsb_)
@@ -89,11 +54,11 @@ FirestormDualController::FirestormDualController(libusb_device* dev, bool is_vsb
 
   if (is_vsb)
   {
-    usb_submit_read(1, sizeof(Firestorm_vsb_Msg));
+    usb_submit_read(1, kVSBReportSize);
   }
   else
   {
-    usb_submit_read(1, sizeof(FirestormMsg));
+    usb_submit_read(1, kDefaultReportSize);
   }
 }
 
@@ -122,58 +87,57 @@ FirestormDualController::set_led_real(uint8_t status)
 }
 
 bool
-FirestormDualController::parse_vsb(uint8_t* data_in, int len, XboxGenericMsg* msg_out)
+FirestormDualController::parse_vsb(uint8_t* data, int len, XboxGenericMsg* msg_out)
 {
-  Firestorm_vsb_Msg data;
-
-  if (len == sizeof(data))
+  if (len == kVSBReportSize)
   {
     XboxGenericMsg& msg = *msg_out;
 
-    memcpy(&data, data_in, sizeof(data));
     memset(&msg, 0, sizeof(msg));
     msg.type    = XBOX_MSG_XBOX360;
 
-    msg.xbox360.a = data.a;
-    msg.xbox360.b = data.b;
-    msg.xbox360.x = data.x;
-    msg.xbox360.y = data.y;
+    msg.xbox360.a = unpack::bit(data+0, 0);
+    msg.xbox360.b = unpack::bit(data+0, 2);
+    msg.xbox360.x = unpack::bit(data+0, 1);
+    msg.xbox360.y = unpack::bit(data+0, 3);
 
-    msg.xbox360.lb = data.lb;
-    msg.xbox360.rb = data.rb;
+    msg.xbox360.lb = unpack::bit(data+0, 4);
+    msg.xbox360.rb = unpack::bit(data+0, 6);
 
-    msg.xbox360.lt = static_cast<unsigned char>(data.lt * 255);
-    msg.xbox360.rt = static_cast<unsigned char>(data.rt * 255);
+    msg.xbox360.lt = static_cast<unsigned char>(unpack::bit(data+0, 5) * 255);
+    msg.xbox360.rt = static_cast<unsigned char>(unpack::bit(data+0, 7) * 255);
 
-    msg.xbox360.start = data.start;
-    msg.xbox360.back  = data.back;
+    msg.xbox360.start = unpack::bit(data+1, 1);
+    msg.xbox360.back  = unpack::bit(data+1, 0);
 
-    msg.xbox360.thumb_l = data.thumb_l;
-    msg.xbox360.thumb_r = data.thumb_r;
+    msg.xbox360.thumb_l = unpack::bit(data+1, 2);
+    msg.xbox360.thumb_r = unpack::bit(data+1, 3);
 
-    msg.xbox360.x1 = scale_8to16(data.x1);
-    msg.xbox360.y1 = scale_8to16(data.y1);
+    msg.xbox360.x1 = scale_8to16(static_cast<int8_t>(data[2]));
+    msg.xbox360.y1 = scale_8to16(static_cast<int8_t>(data[3]));
 
-    msg.xbox360.x2 = scale_8to16(data.x2);
-    msg.xbox360.y2 = scale_8to16(data.y2 - 128);
+    msg.xbox360.x2 = scale_8to16(static_cast<int8_t>(data[4]));
+    msg.xbox360.y2 = scale_8to16(static_cast<int8_t>(data[5] - 128));
 
     // Invert the axis
     msg.xbox360.y1 = s16_invert(msg.xbox360.y1);
     msg.xbox360.y2 = s16_invert(msg.xbox360.y2);
 
-    // data.dpad == 0xf0 -> dpad centered
-    // data.dpad == 0xe0 -> dpad-only mode is enabled
+    const int dpad = data[1] >> 4;
+
+    // dpad == 0xf0 -> dpad centered
+    // dpad == 0xe0 -> dpad-only mode is enabled
 
-    if (data.dpad == 0x0 || data.dpad == 0x7 || data.dpad == 0x1)
+    if (dpad == 0x0 || dpad == 0x7 || dpad == 0x1)
       msg.xbox360.dpad_up   = 1;
 
-    if (data.dpad == 0x1 || data.dpad == 0x2 || data.dpad == 0x3)
+    if (dpad == 0x1 || dpad == 0x2 || dpad == 0x3)
       msg.xbox360.dpad_right = 1;
 
-    if (data.dpad == 0x3 || data.dpad == 0x4 || data.dpad == 0x5)
+    if (dpad == 0x3 || dpad == 0x4 || dpad == 0x5)
       msg.xbox360.dpad_down = 1;
 
-    if (data.dpad == 0x5 || data.dpad == 0x6 || data.dpad == 0x7)
+    if (dpad == 0x5 || dpad == 0x6 || dpad == 0x7)
       msg.xbox360.dpad_left  = 1;
 
     return true;
@@ -185,58 +149,57 @@ FirestormDualController::parse_vsb(uint8_t* data_in, int len, XboxGenericMsg* ms
 }
 
 bool
-FirestormDualController::parse_default(uint8_t* data_in, int len, XboxGenericMsg* msg_out)
+FirestormDualController::parse_default(uint8_t* data, int len, XboxGenericMsg* msg_out)
 {
-  FirestormMsg data;
-
-  if (len == sizeof(data))
+  if (len == kDefaultReportSize)
   {
     XboxGenericMsg& msg = *msg_out;
 
-    memcpy(&data, data_in, sizeof(data));
     memset(&msg, 0, sizeof(msg));
     msg.type    = XBOX_MSG_XBOX360;
 
-    msg.xbox360.a = data.a;
-    msg.xbox360.b = data.b;
-    msg.xbox360.x = data.x;
-    msg.xbox360.y = data.y;
+    msg.xbox360.a = unpack::bit(data+0, 0);
+    msg.xbox360.b = unpack::bit(data+0, 2);
+    msg.xbox360.x = unpack::bit(data+0, 1);
+    msg.xbox360.y = unpack::bit(data+0, 3);
 
-    msg.xbox360.lb = data.lb;
-    msg.xbox360.rb = data.rb;
+    msg.xbox360.lb = unpack::bit(data+0, 4);
+    msg.xbox360.rb = unpack::bit(data+0, 6);
 
-    msg.xbox360.lt = data.lt * 255;
-    msg.xbox360.rt = data.rt * 255;
+    msg.xbox360.lt = unpack::bit(data+0, 5) * 255;
+    msg.xbox360.rt = unpack::bit(data+0, 7) * 255;
 
-    msg.xbox360.start = data.start;
-    msg.xbox360.back  = data.back;
+    msg.xbox360.start = unpack::bit(data+1, 1);
+    msg.xbox360.back  = unpack::bit(data+1, 0);
 
-    msg.xbox360.thumb_l = data.thumb_l;
-    msg.xbox360.thumb_r = data.thumb_r;
+    msg.xbox360.thumb_l = unpack::bit(data+1, 2);
+    msg.xbox360.thumb_r = unpack::bit(data+1, 3);
 
-    msg.xbox360.x1 = scale_8to16(data.x1);
-    msg.xbox360.y1 = scale_8to16(data.y1);
+    msg.xbox360.x1 = scale_8to16(static_cast<int8_t>(data[3]));
+    msg.xbox360.y1 = scale_8to16(static_cast<int8_t>(data[4]));
 
-    msg.xbox360.x2 = scale_8to16(data.x2);
-    msg.xbox360.y2 = scale_8to16(data.y2 - 128);
+    msg.xbox360.x2 = scale_8to16(static_cast<int8_t>(data[5]));
+    msg.xbox360.y2 = scale_8to16(static_cast<int8_t>(data[6] - 128));
 
     // Invert the axis
     msg.xbox360.y1 = s16_invert(msg.xbox360.y1);
     msg.xbox360.y2 = s16_invert(msg.xbox360.y2);
 
-    // data.dpad == 0xf0 -> dpad centered
-    // data.dpad == 0xe0 -> dpad-only mode is enabled
+    const int dpad = data[2];
+
+    // dpad == 0xf0 -> dpad centered
+    // dpad == 0xe0 -> dpad-only mode is enabled
 
-    if (data.dpad == 0x00 || data.dpad == 0x70 || data.dpad == 0x10)
+    if (dpad == 0x00 || dpad == 0x70 || dpad == 0x10)
       msg.xbox360.dpad_up   = 1;
 
-    if (data.dpad == 0x10 || data.dpad == 0x20 || data.dpad == 0x30)
+    if (dpad == 0x10 || dpad == 0x20 || dpad == 0x30)
       msg.xbox360.dpad_right = 1;
 
-    if (data.dpad == 0x30 || data.dpad == 0x40 || data.dpad == 0x50)
+    if (dpad == 0x30 || dpad == 0x40 || dpad == 0x50)
       msg.xbox360.dpad_down = 1;
 
-    if (data.dpad == 0x50 || data.dpad == 0x60 || data.dpad == 0x70)
+    if (dpad == 0x50 || dpad == 0x60 || dpad == 0x70)
       msg.xbox360.dpad_left  = 1;
 
     return true;
@@ -18,6 +18,11 @@
 
 #include "force_feedback_handler.hpp"
 
+#include <algorithm>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
 #include "log.hpp"
 #include "options.hpp"
 
@@ -108,35 +113,84 @@ std::ostream& operator<<(std::ostream& out, const struct ff_effect& effect)
   return out;
 }
 
+namespace {
+
+int clamp(int lhs, int rhs, int v)
+{
+  return std::max(lhs, std::min(v, rhs));
+}
+
+/** Linear interpolation between \a start and \a end, \a len of 0
+    means the effect is infinite and thus stays at \a start */
+int get_pos(int start, int end, int pos, int len)
+{
+  if (len == 0)
+  {
+    return start;
+  }
+  else
+  {
+    int rel = end - start;
+    return start + (rel * pos / len);
+  }
+}
+
+/** One period of a sine wave in 256 steps, scaled to [-0x7fff,0x7fff] */
+const int16_t* get_sine_table()
+{
+  static int16_t table[256];
+  static bool initialized = false;
+
+  if (!initialized)
+  {
+    for(int i = 0; i < 256; ++i)
+    {
+      table[i] = static_cast<int16_t>(0x7fff * sin(2.0 * M_PI * i / 256.0));
+    }
+    initialized = true;
+  }
+
+  return table;
+}
+
+} // namespace
+
 ForceFeedbackEffect::ForceFeedbackEffect() :
+  type(0),
   delay(),
   length(),
   start_strong_magnitude(),
   start_weak_magnitude(),
   end_strong_magnitude(),
   end_weak_magnitude(),
+  waveform(0),
+  period(0),
+  offset(0),
+  phase(0),
   envelope(),
   playing(false),
+  repeat(0),
   count(0),
   weak_magnitude(0),
   strong_magnitude(0)
 {
 }
 
-static int clamp(int lhs, int rhs, int v)
-{
-  return std::max(lhs, std::min(v, rhs));
-}
-
 ForceFeedbackEffect::ForceFeedbackEffect(const struct ff_effect& effect) :
+  type(effect.type),
   delay(),
   length(),
   start_strong_magnitude(),
   start_weak_magnitude(),
   end_strong_magnitude(),
   end_weak_magnitude(),
+  waveform(0),
+  period(0),
+  offset(0),
+  phase(0),
   envelope(),
   playing(false),
+  repeat(0),
   count(0),
   weak_magnitude(0),
   strong_magnitude(0)
@@ -172,6 +226,11 @@ ForceFeedbackEffect::ForceFeedbackEffect(const struct ff_effect& effect) :
       end_weak_magnitude     = clamp(0, 0x7fff, abs(effect.u.periodic.magnitude));
       end_strong_magnitude   = clamp(0, 0x7fff, abs(effect.u.periodic.magnitude));
 
+      waveform = effect.u.periodic.waveform;
+      period   = effect.u.periodic.period;
+      offset   = effect.u.periodic.offset;
+      phase    = effect.u.periodic.phase;
+
       envelope = effect.u.periodic.envelope;
       break;
 
@@ -206,88 +265,157 @@ ForceFeedbackEffect::ForceFeedbackEffect(const struct ff_effect& effect) :
   }
 }
 
-static int get_pos(int start, int end, int pos, int len)
+int
+ForceFeedbackEffect::apply_envelope(int level, int t) const
 {
-  int rel = end - start;
-  return start + (rel * pos / len);
+  if (envelope.attack_length && t < envelope.attack_length)
+  { // attack, go from attack_level to level
+    return envelope.attack_level + (level - envelope.attack_level) * t / envelope.attack_length;
+  }
+  else if (envelope.fade_length && length && t >= length - envelope.fade_length)
+  { // fade, go from level to fade_level
+    int dt = t - (length - envelope.fade_length);
+    return level + (envelope.fade_level - level) * dt / envelope.fade_length;
+  }
+  else
+  { // sustain
+    return level;
+  }
+}
+
+int
+ForceFeedbackEffect::apply_waveform(int level, int t) const
+{
+  if (type != FF_PERIODIC || period <= 0)
+  {
+    return level;
+  }
+  else
+  {
+    // position within the period in the range [0,0xffff]
+    int pos = static_cast<int>(((static_cast<uint32_t>(t % period) * 0x10000u / period) + phase) & 0xffff);
+
+    int wave;
+    switch(waveform)
+    {
+      case FF_SQUARE:
+        wave = (pos < 0x8000) ? 0x7fff : -0x7fff;
+        break;
+
+      case FF_TRIANGLE:
+        if (pos < 0x4000)
+          wave = pos * 2;
+        else if (pos < 0xc000)
+          wave = 0x7fff - (pos - 0x4000) * 2;
+        else
+          wave = (pos - 0xc000) * 2 - 0x7fff;
+        break;
+
+      case FF_SINE:
+        wave = get_sine_table()[pos >> 8];
+        break;
+
+      case FF_SAW_UP:
+        wave = pos - 0x8000;
+        break;
+
+      case FF_SAW_DOWN:
+        wave = 0x7fff - pos;
+        break;
+
+      default:
+        // FF_CUSTOM is not supported, play it as constant effect
+        return level;
+    }
+
+    return clamp(0, 0x7fff, abs(offset + level * wave / 0x7fff));
+  }
 }
 
 void
-ForceFeedbackEffect::update(int msec_delta)
+ForceFeedbackEffect::update(int usec_delta)
 {
   if (playing)
   {
-    count += msec_delta;
+    count += usec_delta;
 
-    if (count > delay)
+    const int64_t delay_usec = static_cast<int64_t>(delay) * 1000;
+    if (count > delay_usec)
     {
-      int t = count - delay;
-      if (t < envelope.attack_length)
-      { // attack
-        strong_magnitude = get_pos(start_strong_magnitude, end_strong_magnitude, t, length);
-        weak_magnitude   = get_pos(start_weak_magnitude,   end_weak_magnitude,   t, length);
-
-        // apply envelope
-        strong_magnitude = ((envelope.attack_level * t) + strong_magnitude * (envelope.attack_length - t)) / envelope.attack_length;
-        weak_magnitude   = ((envelope.attack_level * t) + weak_magnitude   * (envelope.attack_length - t)) / envelope.attack_length;
-      }
-      else if  (t < length - envelope.fade_length)
-      { // sustain
-        strong_magnitude = get_pos(start_strong_magnitude, end_strong_magnitude, t, length);
-        weak_magnitude   = get_pos(start_weak_magnitude,   end_weak_magnitude,   t, length);
+      // msec into the effect, an infinite effect stops advancing
+      // after 24 days instead of overflowing
+      int t = static_cast<int>(std::min<int64_t>((count - delay_usec) / 1000, INT_MAX));
+      if (length != 0 && t >= length)
+      { // effect ended
+        repeat -= 1;
+        if (repeat > 0)
+        {
+          // restart the effect, including the delay, keeping the time
+          // that went past its end
+          count -= delay_usec + static_cast<int64_t>(length) * 1000;
+        }
+        else
+        {
+          stop();
+        }
       }
-      else if (t < length)
-      { // fade
+      else
+      {
         strong_magnitude = get_pos(start_strong_magnitude, end_strong_magnitude, t, length);
         weak_magnitude   = get_pos(start_weak_magnitude,   end_weak_magnitude,   t, length);
 
-        // apply envelope
-        int dt = t - (length - envelope.fade_length);
-        strong_magnitude = ((envelope.fade_level * dt) + strong_magnitude * (envelope.fade_length - dt)) / envelope.fade_length;
-        weak_magnitude   = ((envelope.fade_level * dt) + weak_magnitude   * (envelope.fade_length - dt)) / envelope.fade_length;
-      }
-      else
-      { // effect ended
-        stop();
+        strong_magnitude = apply_waveform(apply_envelope(strong_magnitude, t), t);
+        weak_magnitude   = apply_waveform(apply_envelope(weak_magnitude,   t), t);
       }
     }
   }
 }
 
 void
-ForceFeedbackEffect::play()
+ForceFeedbackEffect::play(int repeat_count)
 {
   playing = true;
+  repeat  = repeat_count;
+  count   = 0;
 }
 
 void
 ForceFeedbackEffect::stop()
 {
   playing = false;
+  repeat = 0;
   count = 0;
   weak_magnitude   = 0;
   strong_magnitude = 0;
 }
 
 ForceFeedbackHandler::ForceFeedbackHandler() :
-  gain(0xFFFF),
-  max_effects(16),
-  effects(),
-  weak_magnitude(0),
-  strong_magnitude(0)
+  m_gain(0xFFFF),
+  m_effects(),
+  m_used(),
+  m_playing(0),
+  m_weak_magnitude(0),
+  m_strong_magnitude(0),
+  m_last_weak_magnitude(0),
+  m_last_strong_magnitude(0)
 {
-
+  std::fill_n(m_used, static_cast<int>(kMaxEffects), false);
 }
 
 ForceFeedbackHandler::~ForceFeedbackHandler()
 {
-
 }
 
 int
 ForceFeedbackHandler::get_max_effects()
 {
-  return max_effects;
+  return kMaxEffects;
+}
+
+bool
+ForceFeedbackHandler::is_valid_id(int id) const
+{
+  return 0 <= id && id < kMaxEffects;
 }
 
 void
@@ -299,24 +427,29 @@ ForceFeedbackHandler::upload(const struct ff_effect& effect)
             << ",\n          "  << effect
             << ")");
 
-  std::map<int, ForceFeedbackEffect>::iterator i = effects.find(effect.id);
-  if (i == effects.end())
+  if (!is_valid_id(effect.id))
   {
-    effects[effect.id] = ForceFeedbackEffect(effect);
+    log_warn("effect id out of range: " << effect.id);
   }
   else
   {
-    ForceFeedbackEffect old_effect = i->second;
     ForceFeedbackEffect new_effect(effect);
 
-    // We the copy state variables of the effect , so we can update
-    // the effect while it is playing
-    new_effect.playing          = old_effect.playing;
-    new_effect.count            = old_effect.count;
-    new_effect.weak_magnitude   = old_effect.weak_magnitude;
-    new_effect.strong_magnitude = old_effect.strong_magnitude;
+    if (m_used[effect.id])
+    {
+      // We the copy state variables of the effect , so we can update
+      // the effect while it is playing
+      const ForceFeedbackEffect& old_effect = m_effects[effect.id];
+
+      new_effect.playing          = old_effect.playing;
+      new_effect.repeat           = old_effect.repeat;
+      new_effect.count            = old_effect.count;
+      new_effect.weak_magnitude   = old_effect.weak_magnitude;
+      new_effect.strong_magnitude = old_effect.strong_magnitude;
+    }
 
-    effects[effect.id] = effect;
+    m_effects[effect.id] = new_effect;
+    m_used[effect.id] = true;
   }
 }
 
@@ -325,10 +458,11 @@ ForceFeedbackHandler::erase(int id)
 {
   log_debug("FF_ERASE(effect_id:" << id << ")");
 
-  std::map<int, ForceFeedbackEffect>::iterator i = effects.find(id);
-  if (i != effects.end())
+  if (is_valid_id(id) && m_used[id])
   {
-    effects.erase(i);
+    m_effects[id] = ForceFeedbackEffect();
+    m_used[id] = false;
+    m_playing &= ~(1u << id);
   }
   else
   {
@@ -337,14 +471,14 @@ ForceFeedbackHandler::erase(int id)
 }
 
 void
-ForceFeedbackHandler::play(int id)
+ForceFeedbackHandler::play(int id, int repeat_count)
 {
-  log_debug("FFPlay(effect_id:" << id << ")");
+  log_debug("FFPlay(effect_id:" << id << ", count:" << repeat_count << ")");
 
-  std::map<int, ForceFeedbackEffect>::iterator i = effects.find(id);
-  if (i != effects.end())
+  if (is_valid_id(id) && m_used[id])
   {
-    i->second.play();
+    m_effects[id].play(repeat_count);
+    m_playing |= (1u << id);
   }
   else
   {
@@ -357,10 +491,10 @@ ForceFeedbackHandler::stop(int id)
 {
   log_debug("FFStop(effect_id:" << id << ")");
 
-  std::map<int, ForceFeedbackEffect>::iterator i = effects.find(id);
-  if (i != effects.end())
+  if (is_valid_id(id) && m_used[id])
   {
-    i->second.stop();
+    m_effects[id].stop();
+    m_playing &= ~(1u << id);
   }
   else
   {
@@ -371,40 +505,76 @@ ForceFeedbackHandler::stop(int id)
 void
 ForceFeedbackHandler::set_gain(int g)
 {
-  gain = g;
+  m_gain = g;
 }
 
 void
-ForceFeedbackHandler::update(int msec_delta)
+ForceFeedbackHandler::mix()
 {
-  weak_magnitude   = 0;
-  strong_magnitude = 0;
+  m_weak_magnitude   = 0;
+  m_strong_magnitude = 0;
 
-  if (!effects.empty())
+  for(int id = 0; id < kMaxEffects; ++id)
   {
-    for(Effects::iterator i = effects.begin(); i != effects.end(); ++i)
+    if (m_playing & (1u << id))
     {
-      i->second.update(msec_delta);
+      m_weak_magnitude   += m_effects[id].get_weak_magnitude();
+      m_strong_magnitude += m_effects[id].get_strong_magnitude();
+    }
+  }
 
-      weak_magnitude   += i->second.get_weak_magnitude();
-      strong_magnitude += i->second.get_strong_magnitude();
+  m_weak_magnitude   = std::min(m_weak_magnitude,   0x7fff);
+  m_strong_magnitude = std::min(m_strong_magnitude, 0x7fff);
+}
+
+bool
+ForceFeedbackHandler::update(int usec_delta)
+{
+  if (m_playing)
+  {
+    for(int id = 0; id < kMaxEffects; ++id)
+    {
+      if (m_playing & (1u << id))
+      {
+        m_effects[id].update(usec_delta);
+
+        if (!m_effects[id].playing)
+        {
+          m_playing &= ~(1u << id);
+        }
+      }
     }
+  }
+
+  mix();
 
-    weak_magnitude   = std::min(weak_magnitude,   0x7fff);
-    strong_magnitude = std::min(strong_magnitude, 0x7fff);
+  // only report a change when the output, including the gain, differs
+  int weak   = get_weak_magnitude();
+  int strong = get_strong_magnitude();
+
+  if (weak   != m_last_weak_magnitude ||
+      strong != m_last_strong_magnitude)
+  {
+    m_last_weak_magnitude   = weak;
+    m_last_strong_magnitude = strong;
+    return true;
+  }
+  else
+  {
+    return false;
   }
 }
 
 int
 ForceFeedbackHandler::get_weak_magnitude() const
 {
-  return weak_magnitude * gain / 0xffff;
+  return m_weak_magnitude * m_gain / 0xffff;
 }
 
 int
 ForceFeedbackHandler::get_strong_magnitude() const
 {
-  return strong_magnitude * gain / 0xffff;
+  return m_strong_magnitude * m_gain / 0xffff;
 }
 
 /* EOF */
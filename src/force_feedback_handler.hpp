@@ -20,18 +20,24 @@
 #define HEADER_FF_HANDLER_HPP
 
 #include <linux/input.h>
-#include <map>
+#include <stdint.h>
 
+/** A single uploaded effect, all values are kept in the kernel's
+    native fixed point ranges (levels in [0,0x7fff], times in msec,
+    phase in 1/0x10000 of a period) so that evaluating the effect
+    needs no floating point math */
 class ForceFeedbackEffect
 {
 public:
   ForceFeedbackEffect();
   ForceFeedbackEffect(const struct ff_effect& e);
 
+  uint16_t type;
+
   // Delay before the effect start
   int delay;
 
-  // Length of the effect
+  // Length of the effect, 0 means infinite
   int length;
 
   // Rumble motor strength
@@ -42,6 +48,12 @@ public:
   int end_strong_magnitude;
   int end_weak_magnitude;
 
+  // Periodic effect parameter, only used with FF_PERIODIC
+  uint16_t waveform;
+  int period;
+  int offset;
+  int phase;
+
   // Envelope
   struct Envelope
   {
@@ -68,29 +80,47 @@ public:
   } envelope;
 
   bool playing;
-  int  count;
+  int  repeat;
+
+  /** usec since the effect started playing */
+  int64_t count;
   int  weak_magnitude;
   int  strong_magnitude;
 
   int  get_weak_magnitude()   const { return weak_magnitude; }
   int  get_strong_magnitude() const { return strong_magnitude; }
 
-  void update(int msec_delta);
-  void play();
+  void update(int usec_delta);
+  void play(int repeat_count = 1);
   void stop();
+
+private:
+  int apply_envelope(int level, int t) const;
+  int apply_waveform(int level, int t) const;
 };
 
-/** */
+/** Mixes all playing effects down to the two rumble motors, effects
+    live in a fixed array indexed by the effect id the kernel hands
+    out, which is always smaller then kMaxEffects */
 class ForceFeedbackHandler
 {
+public:
+  enum { kMaxEffects = 16 };
+
 private:
-  int gain;
-  int max_effects;
-  typedef std::map<int, ForceFeedbackEffect> Effects;
-  Effects effects;
+  int m_gain;
+  ForceFeedbackEffect m_effects[kMaxEffects];
+  bool m_used[kMaxEffects];
+
+  /** bit N is set when m_effects[N] is playing */
+  uint32_t m_playing;
+
+  int m_weak_magnitude;
+  int m_strong_magnitude;
 
-  int weak_magnitude;
-  int strong_magnitude;
+  /** the output last reported by update() */
+  int m_last_weak_magnitude;
+  int m_last_strong_magnitude;
 
 public:
   ForceFeedbackHandler();
@@ -101,15 +131,21 @@ public:
   void upload(const struct ff_effect& effect);
   void erase(int id);
 
-  void play(int id);
+  void play(int id, int repeat_count = 1);
   void stop(int id);
 
   void set_gain(int id);
 
-  void update(int msec_delta);
+  /** Advances all playing effects by \a usec_delta, returns true
+      when the mixed output changed and a new rumble has to be send */
+  bool update(int usec_delta);
 
   int get_weak_magnitude() const;
   int get_strong_magnitude() const;
+
+private:
+  bool is_valid_id(int id) const;
+  void mix();
 };
 
 #endif
@@ -0,0 +1,152 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "input_recorder.hpp"
+
+#include <errno.h>
+#include <stdexcept>
+#include <string.h>
+
+#include "log.hpp"
+#include "raise_exception.hpp"
+#include "scheduling.hpp"
+#include "xpad_device.hpp"
+
+namespace {
+
+/** the writer thread only wakes up for full buffers or after this
+    many usec, so recording doesn't cost a context switch per report */
+const gint64 kFlushInterval = 500 * 1000;
+const size_t kFlushSize = 64 * 1024;
+
+void append_le(std::vector<uint8_t>& buf, uint64_t value, int bytes)
+{
+  for(int i = 0; i < bytes; ++i)
+  {
+    buf.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+} // namespace
+
+const char InputRecorder::kMagic[8] = { 'X', 'B', 'D', 'R', 'R', 'E', 'C', '1' };
+
+InputRecorder::InputRecorder(const std::string& filename, const XPadDevice& dev_type) :
+  m_out(0),
+  m_filename(filename),
+  m_start_time(g_get_monotonic_time()),
+  m_mutex(),
+  m_cond(),
+  m_buffer(),
+  m_quit(false),
+  m_thread(0)
+{
+  m_out = fopen(m_filename.c_str(), "wb");
+  if (!m_out)
+  {
+    raise_exception(std::runtime_error, m_filename << ": " << strerror(errno));
+  }
+
+  std::vector<uint8_t> header(kMagic, kMagic + sizeof(kMagic));
+  append_le(header, dev_type.type, 2);
+  append_le(header, dev_type.idVendor, 2);
+  append_le(header, dev_type.idProduct, 2);
+  append_le(header, 0, 2);
+  fwrite(&header[0], 1, header.size(), m_out);
+
+  m_buffer.reserve(kFlushSize * 2);
+
+  g_mutex_init(&m_mutex);
+  g_cond_init(&m_cond);
+  m_thread = g_thread_new("recorder", &InputRecorder::run_wrap, this);
+
+  log_info("recording to " << m_filename);
+}
+
+InputRecorder::~InputRecorder()
+{
+  g_mutex_lock(&m_mutex);
+  m_quit = true;
+  g_cond_signal(&m_cond);
+  g_mutex_unlock(&m_mutex);
+
+  g_thread_join(m_thread);
+
+  g_cond_clear(&m_cond);
+  g_mutex_clear(&m_mutex);
+
+  fclose(m_out);
+}
+
+void
+InputRecorder::record(const uint8_t* data, int len)
+{
+  gint64 usec = g_get_monotonic_time() - m_start_time;
+
+  g_mutex_lock(&m_mutex);
+  append_le(m_buffer, usec, 8);
+  append_le(m_buffer, len, 2);
+  m_buffer.insert(m_buffer.end(), data, data + len);
+  if (m_buffer.size() >= kFlushSize)
+  {
+    g_cond_signal(&m_cond);
+  }
+  g_mutex_unlock(&m_mutex);
+}
+
+void
+InputRecorder::run()
+{
+  g_scheduling.enter_background_thread();
+
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kFlushSize * 2);
+
+  g_mutex_lock(&m_mutex);
+  while(true)
+  {
+    if (!m_quit && m_buffer.size() < kFlushSize)
+    {
+      g_cond_wait_until(&m_cond, &m_mutex, g_get_monotonic_time() + kFlushInterval);
+    }
+
+    bool quit = m_quit;
+    buffer.swap(m_buffer);
+    g_mutex_unlock(&m_mutex);
+
+    if (!buffer.empty())
+    {
+      if (fwrite(&buffer[0], 1, buffer.size(), m_out) != buffer.size())
+      {
+        log_error(m_filename << ": write failed: " << strerror(errno));
+      }
+      fflush(m_out);
+      buffer.clear();
+    }
+
+    if (quit)
+    {
+      break;
+    }
+
+    g_mutex_lock(&m_mutex);
+  }
+}
+
+/* EOF */
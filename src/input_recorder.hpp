@@ -0,0 +1,82 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_INPUT_RECORDER_HPP
+#define HEADER_XBOXDRV_INPUT_RECORDER_HPP
+
+#include <glib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+struct XPadDevice;
+
+/**
+    Writes the raw USB reports of a controller to a file, so that
+    they can be played back with --replay.
+
+    File format, all numbers are little endian:
+
+      header:  "XBDRREC1", uint16 GamepadType, uint16 idVendor, uint16 idProduct, uint16 0
+      records: int64 usec since the start of the recording, uint16 length, length bytes
+
+    record() only appends to a memory buffer, the file is written by
+    a background thread.
+ */
+class InputRecorder
+{
+public:
+  enum { kHeaderSize = 16, kRecordHeaderSize = 10 };
+  static const char kMagic[8];
+
+private:
+  FILE* m_out;
+  std::string m_filename;
+  gint64 m_start_time;
+
+  GMutex m_mutex;
+  GCond  m_cond;
+  std::vector<uint8_t> m_buffer;
+  bool m_quit;
+
+  GThread* m_thread;
+
+public:
+  InputRecorder(const std::string& filename, const XPadDevice& dev_type);
+  ~InputRecorder();
+
+  void record(const uint8_t* data, int len);
+
+private:
+  void run();
+  static gpointer run_wrap(gpointer data)
+  {
+    static_cast<InputRecorder*>(data)->run();
+    return 0;
+  }
+
+private:
+  InputRecorder(const InputRecorder&);
+  InputRecorder& operator=(const InputRecorder&);
+};
+
+#endif
+
+/* EOF */
@@ -21,18 +21,20 @@
 #include <boost/format.hpp>
 #include <errno.h>
 #include <fcntl.h>
+#include <math.h>
 
 #include "evdev_helper.hpp"
 #include "force_feedback_handler.hpp"
 #include "raise_exception.hpp"
 
 LinuxUinput::LinuxUinput(DeviceType device_type, const std::string& name_,
-                         const struct input_id& usbid_) :
+                         const struct input_id& usbid_,
+                         UInputBackend::Type backend_type) :
   m_device_type(device_type),
   name(name_),
   usbid(usbid_),
   m_finished(false),
-  m_fd(-1),
+  m_backend(),
   m_io_channel(),
   m_source_id(),
   user_dev(),
@@ -43,7 +45,13 @@ LinuxUinput::LinuxUinput(DeviceType device_type, const std::string& name_,
   ff_bit(false),
   m_ff_handler(0),
   m_ff_callback(),
-  needs_sync(true)
+  needs_sync(false),
+  m_dirty(false),
+  m_dirty_list(0),
+  m_next_dirty(0),
+  m_rel_pending(0),
+  m_rel_moving(0),
+  m_wheel_hi_res(false)
 {
   log_debug(name << " " << usbid.vendor << ":" << usbid.product);
 
@@ -51,50 +59,22 @@ LinuxUinput::LinuxUinput(DeviceType device_type, const std::string& name_,
   std::fill_n(rel_lst, REL_CNT, false);
   std::fill_n(key_lst, KEY_CNT, false);
   std::fill_n(ff_lst,  FF_CNT,  false);
+  std::fill_n(m_rel_acc, REL_CNT, 0.0);
+  std::fill_n(m_rel_velocity, REL_CNT, 0.0);
 
   memset(&user_dev, 0, sizeof(uinput_user_dev));
 
-  // Open the input device
-  const char* uinput_filename[] = { "/dev/input/uinput", "/dev/uinput", "/dev/misc/uinput" };
-  const int uinput_filename_count = (sizeof(uinput_filename)/sizeof(const char*));
-
-  std::ostringstream str;
-  for (int i = 0; i < uinput_filename_count; ++i)
-  {
-    if ((m_fd = open(uinput_filename[i], O_RDWR | O_NDELAY)) >= 0)
-    {
-      break;
-    }
-    else
-    {
-      str << "  " << uinput_filename[i] << ": " << strerror(errno) << std::endl;
-    }
-  }
-
-  if (m_fd < 0)
-  {
-    std::ostringstream out;
-    out << "\nError: No stuitable uinput device found, tried:" << std::endl;
-    out << std::endl;
-    out << str.str();
-    out << "" << std::endl;
-    out << "Troubleshooting:" << std::endl;
-    out << "  * make sure uinput kernel module is loaded " << std::endl;
-    out << "  * make sure joydev kernel module is loaded " << std::endl;
-    out << "  * make sure you have permissions to access the uinput device" << std::endl;
-    out << "  * start the driver with ./xboxdrv -v --no-uinput to see if the driver itself works" << std::endl;
-    out << "" << std::endl;
-
-    throw std::runtime_error(out.str());
-  }
+  m_backend.reset(UInputBackend::create(backend_type));
 }
 
 LinuxUinput::~LinuxUinput()
 {
-  g_source_remove(m_source_id);
+  if (m_source_id)
+  {
+    g_source_remove(m_source_id);
+  }
 
-  ioctl(m_fd, UI_DEV_DESTROY);
-  close(m_fd);
+  delete m_ff_handler;
 }
 
 void
@@ -108,11 +88,11 @@ LinuxUinput::add_abs(uint16_t code, int min, int max, int fuzz, int flat)
 
     if (!abs_bit)
     {
-      ioctl(m_fd, UI_SET_EVBIT, EV_ABS);
+      m_backend->enable_type(EV_ABS);
       abs_bit = true;
     }
 
-    ioctl(m_fd, UI_SET_ABSBIT, code);
+    m_backend->enable_code(EV_ABS, code);
 
     user_dev.absmin[code] = min;
     user_dev.absmax[code] = max;
@@ -132,11 +112,11 @@ LinuxUinput::add_rel(uint16_t code)
 
     if (!rel_bit)
     {
-      ioctl(m_fd, UI_SET_EVBIT, EV_REL);
+      m_backend->enable_type(EV_REL);
       rel_bit = true;
     }
 
-    ioctl(m_fd, UI_SET_RELBIT, code);
+    m_backend->enable_code(EV_REL, code);
   }
 }
 
@@ -151,11 +131,11 @@ LinuxUinput::add_key(uint16_t code)
 
     if (!key_bit)
     {
-      ioctl(m_fd, UI_SET_EVBIT, EV_KEY);
+      m_backend->enable_type(EV_KEY);
       key_bit = true;
     }
 
-    ioctl(m_fd, UI_SET_KEYBIT, code);
+    m_backend->enable_code(EV_KEY, code);
   }
 }
 
@@ -168,13 +148,13 @@ LinuxUinput::add_ff(uint16_t code)
 
     if (!ff_bit)
     {
-      ioctl(m_fd, UI_SET_EVBIT, EV_FF);
+      m_backend->enable_type(EV_FF);
       ff_bit = true;
       assert(m_ff_handler == 0);
       m_ff_handler = new ForceFeedbackHandler();
     }
 
-    ioctl(m_fd, UI_SET_FFBIT, code);
+    m_backend->enable_code(EV_FF, code);
   }
 }
 
@@ -227,6 +207,21 @@ LinuxUinput::finish()
       break;
   }
 
+#ifdef REL_WHEEL_HI_RES
+  if (m_wheel_hi_res)
+  {
+    if (rel_lst[REL_WHEEL])
+    {
+      add_rel(REL_WHEEL_HI_RES);
+    }
+
+    if (rel_lst[REL_HWHEEL])
+    {
+      add_rel(REL_HWHEEL_HI_RES);
+    }
+  }
+#endif
+
   strncpy(user_dev.name, name.c_str(), UINPUT_MAX_NAME_SIZE);
   user_dev.id.version = usbid.version;
   user_dev.id.bustype = usbid.bustype;
@@ -240,32 +235,19 @@ LinuxUinput::finish()
     user_dev.ff_effects_max = m_ff_handler->get_max_effects();
   }
 
-  {
-    int write_ret = write(m_fd, &user_dev, sizeof(user_dev));
-    if (write_ret < 0)
-    {
-      throw std::runtime_error("uinput:finish: " + name + ": " + strerror(errno));
-    }
-    else
-    {
-      log_debug("write return value: " << write_ret);
-    }
-  }
-
   // FIXME: check that the config isn't empty and give a more
   // meaningful message when it is
 
   log_debug("finish");
-  if (ioctl(m_fd, UI_DEV_CREATE))
-  {
-    raise_exception(std::runtime_error, "unable to create uinput device: '" << name << "': " << strerror(errno));
-  }
+  m_backend->create(user_dev);
 
   m_finished = true;
 
+  // only the kernel device sends force feedback requests back
+  if (m_backend->get_fd() >= 0)
   {
     // start g_io_channel
-    m_io_channel = g_io_channel_unix_new(m_fd);
+    m_io_channel = g_io_channel_unix_new(m_backend->get_fd());
 
     // set encoding to binary
     GError* error = NULL;
@@ -283,11 +265,134 @@ LinuxUinput::finish()
   }
 }
 
+void
+LinuxUinput::set_wheel_hi_res(bool wheel_hi_res)
+{
+  assert(!m_finished);
+  m_wheel_hi_res = wheel_hi_res;
+}
+
+void
+LinuxUinput::mark_dirty()
+{
+  if (!m_dirty)
+  {
+    m_dirty = true;
+
+    if (m_dirty_list)
+    {
+      m_next_dirty = *m_dirty_list;
+      *m_dirty_list = this;
+    }
+  }
+}
+
 void
 LinuxUinput::send(uint16_t type, uint16_t code, int32_t value)
 {
-  needs_sync = true;
+  if (type == EV_REL)
+  {
+    send_rel(code, value);
+  }
+  else
+  {
+    needs_sync = true;
+    mark_dirty();
+
+    write_event(type, code, value);
+  }
+}
+
+void
+LinuxUinput::send_rel(uint16_t code, double value)
+{
+  assert(code < REL_CNT);
+
+  m_rel_acc[code] += value;
+  m_rel_pending |= (1u << code);
+
+#ifdef REL_WHEEL_HI_RES
+  if (m_wheel_hi_res)
+  {
+    // a wheel detent is 120 high resolution units
+    if (code == REL_WHEEL)
+    {
+      m_rel_acc[REL_WHEEL_HI_RES] += value * 120.0;
+      m_rel_pending |= (1u << REL_WHEEL_HI_RES);
+    }
+    else if (code == REL_HWHEEL)
+    {
+      m_rel_acc[REL_HWHEEL_HI_RES] += value * 120.0;
+      m_rel_pending |= (1u << REL_HWHEEL_HI_RES);
+    }
+  }
+#endif
+
+  mark_dirty();
+}
+
+void
+LinuxUinput::add_rel_velocity(uint16_t code, double delta)
+{
+  assert(code < REL_CNT);
+
+  m_rel_velocity[code] += delta;
+
+  // the velocity is a sum of changes, so snap the rounding error
+  // away when it gets back to rest
+  if (fabs(m_rel_velocity[code]) < 1e-6)
+  {
+    m_rel_velocity[code] = 0.0;
+    m_rel_moving &= ~(1u << code);
+  }
+  else
+  {
+    m_rel_moving |= (1u << code);
+  }
+}
+
+void
+LinuxUinput::update_motion(double seconds)
+{
+  if (m_rel_moving)
+  {
+    for(int code = 0; code < REL_CNT; ++code)
+    {
+      if (m_rel_moving & (1u << code))
+      {
+        send_rel(code, m_rel_velocity[code] * seconds);
+      }
+    }
+  }
+}
+
+void
+LinuxUinput::flush_rel()
+{
+  // high resolution wheel events have to come before the regular
+  // ones, which have the lower codes, so go from high to low
+  for(int code = REL_CNT-1; code >= 0; --code)
+  {
+    if (m_rel_pending & (1u << code))
+    {
+      // only whole units can be sent, the rest stays for the next frame
+      int value = static_cast<int>(m_rel_acc[code]);
+      if (value != 0)
+      {
+        m_rel_acc[code] -= value;
 
+        needs_sync = true;
+        write_event(EV_REL, code, value);
+      }
+    }
+  }
+
+  m_rel_pending = 0;
+}
+
+void
+LinuxUinput::write_event(uint16_t type, uint16_t code, int32_t value)
+{
   struct input_event ev;
   memset(&ev, 0, sizeof(ev));
 
@@ -299,35 +404,51 @@ LinuxUinput::send(uint16_t type, uint16_t code, int32_t value)
   else
     ev.value = value;
 
-  if (write(m_fd, &ev, sizeof(ev)) < 0)
-    throw std::runtime_error(std::string("uinput:send_button: ") + strerror(errno));
+  m_backend->write(ev);
+}
+
+void
+LinuxUinput::set_dirty_list(LinuxUinput** dirty_list)
+{
+  m_dirty_list = dirty_list;
 }
 
 void
 LinuxUinput::sync()
 {
+  if (m_rel_pending)
+  {
+    flush_rel();
+  }
+
   if (needs_sync)
   {
-    send(EV_SYN, SYN_REPORT, 0);
+    write_event(EV_SYN, SYN_REPORT, 0);
     needs_sync = false;
   }
+
+  m_dirty = false;
+  m_next_dirty = 0;
 }
 
 void
-LinuxUinput::update(int msec_delta)
+LinuxUinput::update(int usec_delta)
 {
   if (ff_bit)
   {
     assert(m_ff_handler);
 
-    m_ff_handler->update(msec_delta);
-
-    log_info(boost::format("%5d %5d") % m_ff_handler->get_strong_magnitude() % m_ff_handler->get_weak_magnitude());
-
-    if (m_ff_callback)
+    // only forward the rumble when it changed, no need to flood the
+    // controller with identical rumble messages every tick
+    if (m_ff_handler->update(usec_delta))
     {
-      m_ff_callback(static_cast<unsigned char>(m_ff_handler->get_strong_magnitude() / 128),
-                    static_cast<unsigned char>(m_ff_handler->get_weak_magnitude()   / 128));
+      log_debug(boost::format("%5d %5d") % m_ff_handler->get_strong_magnitude() % m_ff_handler->get_weak_magnitude());
+
+      if (m_ff_callback)
+      {
+        m_ff_callback(static_cast<unsigned char>(m_ff_handler->get_strong_magnitude() / 128),
+                      static_cast<unsigned char>(m_ff_handler->get_weak_magnitude()   / 128));
+      }
     }
   }
 }
@@ -338,7 +459,7 @@ LinuxUinput::on_read_data(GIOChannel* source, GIOCondition condition)
   struct input_event ev;
   int ret;
 
-  while((ret = read(m_fd, &ev, sizeof(ev))) == sizeof(ev))
+  while((ret = read(m_backend->get_fd(), &ev, sizeof(ev))) == sizeof(ev))
   {
     switch(ev.type)
     {
@@ -358,8 +479,9 @@ LinuxUinput::on_read_data(GIOChannel* source, GIOCondition condition)
             break;
 
           default:
+            // ev.value is the number of times the effect should repeat
             if (ev.value)
-              m_ff_handler->play(ev.code);
+              m_ff_handler->play(ev.code, ev.value);
             else
               m_ff_handler->stop(ev.code);
         }
@@ -378,11 +500,11 @@ LinuxUinput::on_read_data(GIOChannel* source, GIOCondition condition)
               // hanging process
               upload.request_id = ev.value;
 
-              ioctl(m_fd, UI_BEGIN_FF_UPLOAD, &upload);
+              ioctl(m_backend->get_fd(), UI_BEGIN_FF_UPLOAD, &upload);
               m_ff_handler->upload(upload.effect);
               upload.retval = 0;
 
-              ioctl(m_fd, UI_END_FF_UPLOAD, &upload);
+              ioctl(m_backend->get_fd(), UI_END_FF_UPLOAD, &upload);
             }
             break;
 
@@ -396,11 +518,11 @@ LinuxUinput::on_read_data(GIOChannel* source, GIOCondition condition)
               // hanging process
               erase.request_id = ev.value;
 
-              ioctl(m_fd, UI_BEGIN_FF_ERASE, &erase);
+              ioctl(m_backend->get_fd(), UI_BEGIN_FF_ERASE, &erase);
               m_ff_handler->erase(erase.effect_id);
               erase.retval = 0;
 
-              ioctl(m_fd, UI_END_FF_ERASE, &erase);
+              ioctl(m_backend->get_fd(), UI_END_FF_ERASE, &erase);
             }
             break;
 
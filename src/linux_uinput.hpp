@@ -20,9 +20,12 @@
 #define HEADER_LINUX_UINPUT_HPP
 
 #include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <linux/uinput.h>
 #include <glib.h>
 #include <stdint.h>
+
+#include "uinput_backend.hpp"
 
 class ForceFeedbackHandler;
 
@@ -38,7 +41,7 @@ private:
 
   bool m_finished;
 
-  int m_fd;
+  boost::scoped_ptr<UInputBackend> m_backend;
   GIOChannel* m_io_channel;
   guint m_source_id;
 
@@ -59,9 +62,28 @@ private:
 
   bool needs_sync;
 
+  /** intrusive list of devices that need a sync, the device links
+      itself in on its first send() after a sync() */
+  bool m_dirty;
+  LinuxUinput** m_dirty_list;
+  LinuxUinput*  m_next_dirty;
+
+  /** relative motion collected since the last sync(), including the
+      fractional rest that hasn't been sent yet */
+  double m_rel_acc[REL_CNT];
+  unsigned int m_rel_pending;
+
+  /** continuous motion in units per second, integrated by
+      update_motion() at the output rate */
+  double m_rel_velocity[REL_CNT];
+  unsigned int m_rel_moving;
+
+  bool m_wheel_hi_res;
+
 public:
   LinuxUinput(DeviceType device_type, const std::string& name,
-              const struct input_id& usbid_);
+              const struct input_id& usbid_,
+              UInputBackend::Type backend_type = UInputBackend::kKernel);
   ~LinuxUinput();
 
   /*@{*/
@@ -82,14 +104,43 @@ public:
   void finish();
   /*@}*/
 
+  /** Send out REL_WHEEL and REL_HWHEEL also as their high
+      resolution variant, must be called before finish() */
+  void set_wheel_hi_res(bool wheel_hi_res);
+
   void send(uint16_t type, uint16_t code, int32_t value);
 
+  /** Add relative motion to the axis \a code, the motion of a frame
+      is summed up and sent as a single event on sync(), fractions
+      are kept for the next frame */
+  void send_rel(uint16_t code, double value);
+
+  /** Change the continuous motion of the axis \a code by \a delta
+      units per second */
+  void add_rel_velocity(uint16_t code, double delta);
+
+  /** Move all axis with a velocity by the motion of the last \a
+      seconds */
+  void update_motion(double seconds);
+
   /** Sends out a sync event if there is a need for it. */
   void sync();
 
-  void update(int msec_delta);
+  /** Let the device add itself to \a dirty_list whenever it needs a
+      sync, the owner of the list must then sync it via the list,
+      not directly */
+  void set_dirty_list(LinuxUinput** dirty_list);
+  LinuxUinput* get_next_dirty() const { return m_next_dirty; }
+
+  void update(int usec_delta);
+
+  UInputBackend& get_backend() const { return *m_backend; }
 
 private:
+  void mark_dirty();
+  void flush_rel();
+  void write_event(uint16_t type, uint16_t code, int32_t value);
+
   gboolean on_read_data(GIOChannel* source,
                         GIOCondition condition);
   static gboolean on_read_data_wrap(GIOChannel* source,
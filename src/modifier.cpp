@@ -20,6 +20,7 @@
 
 #include <boost/tokenizer.hpp>
 
+#include "modifier/auto_calibration_modifier.hpp"
 #include "modifier/dpad_restrictor_modifier.hpp"
 #include "modifier/dpad_rotation_modifier.hpp"
 #include "modifier/four_way_restrictor_modifier.hpp"
@@ -71,6 +72,10 @@ Modifier::from_string(const std::string& name, const std::string& value)
     {
       return DpadRestrictorModifier::from_string(args);
     }
+    else if (name == "autocal" || name == "auto-calibration")
+    {
+      return AutoCalibrationModifier::from_string(args);
+    }
     else
     {
       throw std::runtime_error("unknown modifier: " + name);
@@ -23,6 +23,7 @@
 
 #include "xboxmsg.hpp"
 
+class Controller;
 class Modifier;
 class Options;
 
@@ -35,7 +36,12 @@ public:
 
 public:
   virtual ~Modifier() {}
-  virtual void update(int msec_delta, XboxGenericMsg& msg) = 0;
+  virtual void update(int64_t usec_time, int usec_delta, XboxGenericMsg& msg) = 0;
+
+  /** Called when a controller gets attached to or detached from the
+      slot the modifier belongs to */
+  virtual void connect(const Controller& controller) {}
+  virtual void disconnect() {}
 
   virtual std::string str() const = 0;
 };
@@ -0,0 +1,516 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "auto_calibration_modifier.hpp"
+
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <errno.h>
+#include <fstream>
+#include <map>
+#include <math.h>
+#include <sstream>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "controller.hpp"
+#include "helper.hpp"
+#include "ini_builder.hpp"
+#include "ini_parser.hpp"
+#include "log.hpp"
+#include "raise_exception.hpp"
+
+namespace {
+
+/** A stick counts as resting when it stays close to the estimated
+    center and doesn't move for kIdleDelay usec, only then are the
+    center and the noise floor updated. Once the noise floor is known
+    the rest radius shrinks to a multiple of it, so that a stick held
+    still slightly off-center isn't learned as the new center. */
+const float kIdleRadius    = 2048.0f;
+const float kMinIdleRadius = 512.0f;
+const int   kIdleJitter    = 384;
+const int   kIdleDelay     = 500 * 1000;
+
+/** Time constants in usec of the running averages, they are
+    independent of the report rate of the controller. The center moves
+    slowly so that a resting stick has to stay off-center for a long
+    time before it is taken for drift. */
+const float kCenterTau = 8.0f * 1000.0f * 1000.0f;
+const float kNoiseTau  = 1.0f * 1000.0f * 1000.0f;
+
+/** Until enough resting samples have been seen a conservative
+    deadzone is used, afterwards it shrinks to a multiple of the
+    noise floor */
+const int   kMinSamples      = 256;
+const float kDefaultDeadzone = 4096.0f;
+const float kMinDeadzone     = 512.0f;
+const float kMaxDeadzone     = 8192.0f;
+
+/** The observed envelope is only trusted once the stick has been
+    moved this far from the center, before that the nominal range is
+    used */
+const float kMinRange = 16384.0f;
+
+typedef std::map<std::string, std::string> CalibrationSection;
+typedef std::map<std::string, CalibrationSection> CalibrationFile;
+
+class CalibrationFileBuilder : public INIBuilder
+{
+private:
+  CalibrationFile& m_file;
+  CalibrationSection* m_section;
+
+public:
+  CalibrationFileBuilder(CalibrationFile& file) :
+    m_file(file),
+    m_section(0)
+  {}
+
+  void send_section(const std::string& section)
+  {
+    m_section = &m_file[section];
+  }
+
+  void send_pair(const std::string& name, const std::string& value)
+  {
+    if (!m_section)
+    {
+      raise_exception(std::runtime_error, "'" << name << "' outside of a section");
+    }
+    else
+    {
+      (*m_section)[name] = value;
+    }
+  }
+
+private:
+  CalibrationFileBuilder(const CalibrationFileBuilder&);
+  CalibrationFileBuilder& operator=(const CalibrationFileBuilder&);
+};
+
+/** A missing file is not an error, it just doesn't contain any
+    calibrations yet */
+void read_calibration_file(const std::string& filename, CalibrationFile& file)
+{
+  std::ifstream in(filename.c_str());
+  if (in)
+  {
+    CalibrationFileBuilder builder(file);
+    INIParser parser(in, builder, filename);
+    parser.run();
+  }
+}
+
+void write_calibration_file(const std::string& filename, const CalibrationFile& file)
+{
+  // write to a temporary file first so that a crash doesn't leave a
+  // truncated file behind
+  const std::string tmpfile = filename + ".tmp";
+
+  {
+    std::ofstream out(tmpfile.c_str());
+    if (!out)
+    {
+      raise_exception(std::runtime_error, "couldn't open: " << tmpfile);
+    }
+
+    for(CalibrationFile::const_iterator i = file.begin(); i != file.end(); ++i)
+    {
+      out << "[" << i->first << "]\n";
+      for(CalibrationSection::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+      {
+        out << j->first << " = " << j->second << "\n";
+      }
+      out << "\n";
+    }
+
+    out.close();
+    if (!out)
+    {
+      raise_exception(std::runtime_error, "couldn't write: " << tmpfile);
+    }
+  }
+
+  if (rename(tmpfile.c_str(), filename.c_str()) != 0)
+  {
+    raise_exception(std::runtime_error, "couldn't rename " << tmpfile << " to " << filename << ": " << strerror(errno));
+  }
+}
+
+/** Maps \a v, relative to \a center, to the range [-1, 1] using the
+    observed envelope when it is wide enough */
+float normalize(float v, float center, int min_value, int max_value)
+{
+  if (v >= 0.0f)
+  {
+    float range = static_cast<float>(max_value) - center;
+    if (range < kMinRange)
+    {
+      range = 32767.0f - center;
+    }
+    return v / range;
+  }
+  else
+  {
+    float range = center - static_cast<float>(min_value);
+    if (range < kMinRange)
+    {
+      range = center + 32768.0f;
+    }
+    return v / range;
+  }
+}
+
+/** Weight of a sample that covers \a usec_delta in a running average
+    with time constant \a tau */
+float smoothing(int usec_delta, float tau)
+{
+  return 1.0f - expf(-static_cast<float>(usec_delta) / tau);
+}
+
+int denormalize(float v)
+{
+  return Math::clamp(-32768, static_cast<int>((v < 0) ? v * 32768.0f : v * 32767.0f), 32767);
+}
+
+} // namespace
+
+AutoCalibrationModifier*
+AutoCalibrationModifier::from_string(const std::vector<std::string>& args)
+{
+  if (args.size() != 2 && args.size() != 3)
+  {
+    throw std::runtime_error("AutoCalibrationModifier requires two or three arguments");
+  }
+  else
+  {
+    return new AutoCalibrationModifier(string2axis(args[0]),
+                                       string2axis(args[1]),
+                                       args.size() == 3 ? args[2] : std::string());
+  }
+}
+
+AutoCalibrationModifier::AutoCalibrationModifier(XboxAxis xaxis, XboxAxis yaxis, const std::string& filename) :
+  m_xaxis(xaxis),
+  m_yaxis(yaxis),
+  m_filename(filename),
+  m_controller(),
+  m_serial(),
+  m_key(),
+  m_center_x(),
+  m_center_y(),
+  m_noise(),
+  m_min_x(),
+  m_max_x(),
+  m_min_y(),
+  m_max_y(),
+  m_samples(),
+  m_dirty(),
+  m_last_x(),
+  m_last_y(),
+  m_idle_time()
+{
+  reset();
+}
+
+AutoCalibrationModifier::~AutoCalibrationModifier()
+{
+  if (m_controller)
+  {
+    disconnect();
+  }
+}
+
+void
+AutoCalibrationModifier::reset()
+{
+  m_center_x = 0.0f;
+  m_center_y = 0.0f;
+  m_noise = 0.0f;
+  m_min_x = 0;
+  m_max_x = 0;
+  m_min_y = 0;
+  m_max_y = 0;
+  m_samples = 0;
+  m_dirty = false;
+
+  m_last_x = 0;
+  m_last_y = 0;
+  m_idle_time = 0;
+}
+
+void
+AutoCalibrationModifier::connect(const Controller& controller)
+{
+  m_controller = &controller;
+  rekey();
+}
+
+void
+AutoCalibrationModifier::disconnect()
+{
+  save_noexcept();
+
+  m_key.clear();
+  m_serial.clear();
+  m_controller = 0;
+}
+
+void
+AutoCalibrationModifier::rekey()
+{
+  save_noexcept();
+
+  reset();
+  m_key.clear();
+
+  // the serial follows the controller from port to port, controllers
+  // without one can't be told apart and aren't persisted, the bus and
+  // device number change with every replug
+  m_serial = m_controller->get_serial();
+  if (m_serial.empty())
+  {
+    if (!m_filename.empty())
+    {
+      log_info("controller " << m_controller->get_usbid() << " has no serial, calibration won't be saved");
+    }
+    return;
+  }
+
+  m_key = (boost::format("%s %s %s:%s")
+           % m_controller->get_usbid() % m_serial
+           % axis2string(m_xaxis) % axis2string(m_yaxis)).str();
+
+  try
+  {
+    load();
+  }
+  catch(const std::exception& err)
+  {
+    log_error("couldn't load calibration from '" << m_filename << "': " << err.what());
+    reset();
+  }
+}
+
+void
+AutoCalibrationModifier::load()
+{
+  if (m_filename.empty() || m_key.empty())
+  {
+    return;
+  }
+
+  CalibrationFile file;
+  read_calibration_file(m_filename, file);
+
+  CalibrationFile::const_iterator it = file.find(m_key);
+  if (it != file.end())
+  {
+    const CalibrationSection& section = it->second;
+    for(CalibrationSection::const_iterator i = section.begin(); i != section.end(); ++i)
+    {
+      if (i->first == "center-x")
+        m_center_x = boost::lexical_cast<float>(i->second);
+      else if (i->first == "center-y")
+        m_center_y = boost::lexical_cast<float>(i->second);
+      else if (i->first == "noise")
+        m_noise = boost::lexical_cast<float>(i->second);
+      else if (i->first == "min-x")
+        m_min_x = boost::lexical_cast<int>(i->second);
+      else if (i->first == "max-x")
+        m_max_x = boost::lexical_cast<int>(i->second);
+      else if (i->first == "min-y")
+        m_min_y = boost::lexical_cast<int>(i->second);
+      else if (i->first == "max-y")
+        m_max_y = boost::lexical_cast<int>(i->second);
+      else if (i->first == "samples")
+        m_samples = boost::lexical_cast<int>(i->second);
+      else
+        raise_exception(std::runtime_error, "unknown name: " << i->first);
+    }
+
+    log_info("loaded calibration for [" << m_key << "]: "
+             << "center " << m_center_x << "," << m_center_y << " noise " << m_noise);
+  }
+}
+
+void
+AutoCalibrationModifier::save_noexcept()
+{
+  try
+  {
+    save();
+  }
+  catch(const std::exception& err)
+  {
+    log_error("couldn't save calibration to '" << m_filename << "': " << err.what());
+  }
+}
+
+void
+AutoCalibrationModifier::save()
+{
+  if (m_filename.empty() || m_key.empty() || !m_dirty)
+  {
+    return;
+  }
+
+  // other controllers share the file, so only replace our section
+  CalibrationFile file;
+  read_calibration_file(m_filename, file);
+
+  CalibrationSection& section = file[m_key];
+  section["center-x"] = boost::lexical_cast<std::string>(m_center_x);
+  section["center-y"] = boost::lexical_cast<std::string>(m_center_y);
+  section["noise"]    = boost::lexical_cast<std::string>(m_noise);
+  section["min-x"]    = boost::lexical_cast<std::string>(m_min_x);
+  section["max-x"]    = boost::lexical_cast<std::string>(m_max_x);
+  section["min-y"]    = boost::lexical_cast<std::string>(m_min_y);
+  section["max-y"]    = boost::lexical_cast<std::string>(m_max_y);
+  section["samples"]  = boost::lexical_cast<std::string>(m_samples);
+
+  write_calibration_file(m_filename, file);
+  m_dirty = false;
+
+  log_info("saved calibration for [" << m_key << "] to '" << m_filename << "'");
+}
+
+float
+AutoCalibrationModifier::get_idle_radius() const
+{
+  if (m_samples < kMinSamples)
+  {
+    return kIdleRadius;
+  }
+  else
+  {
+    return Math::clamp(kMinIdleRadius, 4.0f * m_noise, kIdleRadius);
+  }
+}
+
+float
+AutoCalibrationModifier::get_deadzone() const
+{
+  if (m_samples < kMinSamples)
+  {
+    return kDefaultDeadzone;
+  }
+  else
+  {
+    return Math::clamp(kMinDeadzone, 3.0f * m_noise, kMaxDeadzone);
+  }
+}
+
+void
+AutoCalibrationModifier::learn(int x, int y, int usec_delta)
+{
+  if (x < m_min_x || x > m_max_x || y < m_min_y || y > m_max_y)
+  {
+    m_min_x = std::min(m_min_x, x);
+    m_max_x = std::max(m_max_x, x);
+    m_min_y = std::min(m_min_y, y);
+    m_max_y = std::max(m_max_y, y);
+    m_dirty = true;
+  }
+
+  const float dx = static_cast<float>(x) - m_center_x;
+  const float dy = static_cast<float>(y) - m_center_y;
+  const float dist = sqrtf(dx*dx + dy*dy);
+  const int movement = std::max(abs(x - m_last_x), abs(y - m_last_y));
+
+  m_last_x = x;
+  m_last_y = y;
+
+  if (dist < get_idle_radius() && movement < kIdleJitter)
+  {
+    m_idle_time = std::min(m_idle_time + usec_delta, kIdleDelay);
+
+    if (m_idle_time >= kIdleDelay)
+    {
+      const float center_alpha = smoothing(usec_delta, kCenterTau);
+      m_center_x += dx * center_alpha;
+      m_center_y += dy * center_alpha;
+      m_noise    += (dist - m_noise) * smoothing(usec_delta, kNoiseTau);
+
+      if (m_samples < kMinSamples)
+      {
+        m_samples += 1;
+      }
+      m_dirty = true;
+    }
+  }
+  else
+  {
+    m_idle_time = 0;
+  }
+}
+
+void
+AutoCalibrationModifier::update(int64_t usec_time, int usec_delta, XboxGenericMsg& msg)
+{
+  // a wireless controller only announces its serial after it
+  // connected and another pad can take over its slot later on
+  if (m_controller && m_controller->get_serial() != m_serial)
+  {
+    rekey();
+  }
+
+  const int x = get_axis(msg, m_xaxis);
+  const int y = get_axis(msg, m_yaxis);
+
+  learn(x, y, usec_delta);
+
+  // move the learned center to zero and stretch each half of the
+  // axis to the full range
+  float fx = normalize(static_cast<float>(x) - m_center_x, m_center_x, m_min_x, m_max_x);
+  float fy = normalize(static_cast<float>(y) - m_center_y, m_center_y, m_min_y, m_max_y);
+
+  // radial deadzone, the remaining range is scaled back up so that
+  // there is no jump at its edge
+  const float deadzone = get_deadzone() / 32768.0f;
+  const float len = sqrtf(fx*fx + fy*fy);
+  if (len <= deadzone)
+  {
+    set_axis(msg, m_xaxis, 0);
+    set_axis(msg, m_yaxis, 0);
+  }
+  else
+  {
+    const float scale = (len - deadzone) / (1.0f - deadzone) / len;
+    set_axis(msg, m_xaxis, denormalize(fx * scale));
+    set_axis(msg, m_yaxis, denormalize(fy * scale));
+  }
+}
+
+std::string
+AutoCalibrationModifier::str() const
+{
+  std::ostringstream out;
+  out << "autocal:"
+      << axis2string(m_xaxis)
+      << ":"
+      << axis2string(m_yaxis);
+  return out.str();
+}
+
+/* EOF */
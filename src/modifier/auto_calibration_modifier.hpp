@@ -0,0 +1,98 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_MODIFIER_AUTO_CALIBRATION_MODIFIER_HPP
+#define HEADER_XBOXDRV_MODIFIER_AUTO_CALIBRATION_MODIFIER_HPP
+
+#include <string>
+#include <vector>
+
+#include "modifier.hpp"
+
+/** Learns the rest position, the noise floor and the range of a
+    stick while it is in use and corrects for them, so that a
+    drifting stick centers again with only a minimal deadzone. The
+    learned values are stored per controller in \a filename and
+    picked up again when the same controller reconnects. */
+class AutoCalibrationModifier : public Modifier
+{
+public:
+  static AutoCalibrationModifier* from_string(const std::vector<std::string>& args);
+
+public:
+  AutoCalibrationModifier(XboxAxis x_axis, XboxAxis y_axis, const std::string& filename);
+  ~AutoCalibrationModifier();
+
+  void update(int64_t usec_time, int usec_delta, XboxGenericMsg& msg);
+
+  void connect(const Controller& controller);
+  void disconnect();
+
+  std::string str() const;
+
+private:
+  void reset();
+  /** Switches to the calibration of the current serial of the
+      controller, saving the previous one */
+  void rekey();
+  void learn(int x, int y, int usec_delta);
+  float get_idle_radius() const;
+  float get_deadzone() const;
+
+  void load();
+  void save();
+  void save_noexcept();
+
+private:
+  XboxAxis m_xaxis;
+  XboxAxis m_yaxis;
+  std::string m_filename;
+
+  /** the connected controller and the serial the key was built from */
+  const Controller* m_controller;
+  std::string m_serial;
+
+  /** identifies the stick in the calibration file, empty while no
+      controller is connected or when the controller has no serial */
+  std::string m_key;
+
+  // learned calibration
+  float m_center_x;
+  float m_center_y;
+  float m_noise;
+  int m_min_x;
+  int m_max_x;
+  int m_min_y;
+  int m_max_y;
+  int m_samples;
+  bool m_dirty;
+
+  // idle detection
+  int m_last_x;
+  int m_last_y;
+  int m_idle_time;
+
+private:
+  AutoCalibrationModifier(const AutoCalibrationModifier&);
+  AutoCalibrationModifier& operator=(const AutoCalibrationModifier&);
+};
+
+#endif
+
+/* EOF */
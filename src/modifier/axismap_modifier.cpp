@@ -76,7 +76,7 @@ AxismapModifier::AxismapModifier() :
 }
 
 void
-AxismapModifier::update(int msec_delta, XboxGenericMsg& msg)
+AxismapModifier::update(int64_t usec_time, int usec_delta, XboxGenericMsg& msg)
 {
   XboxGenericMsg newmsg = msg;
 
@@ -85,7 +85,7 @@ AxismapModifier::update(int msec_delta, XboxGenericMsg& msg)
   {
     for(std::vector<AxisFilterPtr>::iterator j = i->filters.begin(); j != i->filters.end(); ++j)
     {
-      (*j)->update(msec_delta);
+      (*j)->update(usec_time, usec_delta);
     }
   }
 
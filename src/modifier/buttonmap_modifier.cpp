@@ -59,7 +59,7 @@ ButtonmapModifier::ButtonmapModifier() :
 }
 
 void
-ButtonmapModifier::update(int msec_delta, XboxGenericMsg& msg)
+ButtonmapModifier::update(int64_t usec_time, int usec_delta, XboxGenericMsg& msg)
 {
   XboxGenericMsg newmsg = msg;
 
@@ -68,7 +68,7 @@ ButtonmapModifier::update(int msec_delta, XboxGenericMsg& msg)
   {
     for(std::vector<ButtonFilterPtr>::iterator j = i->filters.begin(); j != i->filters.end(); ++j)
     {
-      (*j)->update(msec_delta);
+      (*j)->update(usec_time, usec_delta);
     }
   }
 
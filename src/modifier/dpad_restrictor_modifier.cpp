@@ -58,7 +58,7 @@ DpadRestrictorModifier::DpadRestrictorModifier(Mode mode) :
 }
 
 void
-DpadRestrictorModifier::update(int msec_delta, XboxGenericMsg& msg)
+DpadRestrictorModifier::update(int64_t usec_time, int usec_delta, XboxGenericMsg& msg)
 {
   switch(m_mode)
   {
@@ -52,7 +52,7 @@ DpadRotationModifier::DpadRotationModifier(int dpad_rotation) :
 }
 
 void
-DpadRotationModifier::update(int msec_delta, XboxGenericMsg& msg)
+DpadRotationModifier::update(int64_t usec_time, int usec_delta, XboxGenericMsg& msg)
 {
   int up    = get_button(msg, XBOX_DPAD_UP);
   int down  = get_button(msg, XBOX_DPAD_DOWN);
@@ -42,7 +42,7 @@ FourWayRestrictorModifier::FourWayRestrictorModifier(XboxAxis xaxis, XboxAxis ya
 }
 
 void
-FourWayRestrictorModifier::update(int msec_delta, XboxGenericMsg& msg)
+FourWayRestrictorModifier::update(int64_t usec_time, int usec_delta, XboxGenericMsg& msg)
 {
   if (abs(get_axis(msg, m_xaxis)) > abs(get_axis(msg, m_yaxis)))
   {
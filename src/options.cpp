@@ -77,6 +77,10 @@ Options::Options() :
   detach_kernel_driver(),
   timeout(10),
   priority(kPriorityNormal),
+  deadline_runtime(200),
+  deadline_period(1000),
+  cpu_affinity(),
+  mlock(false),
   gamepad_type(GAMEPAD_UNKNOWN),
   busid(),
   devid(),
@@ -87,6 +91,13 @@ Options::Options() :
   evdev_grab(true),
   evdev_debug(false),
   evdev_keymap(),
+  record_file(),
+  replay_file(),
+  replay_fast(false),
+  synthetic_type(GAMEPAD_UNKNOWN),
+  synthetic_count(1),
+  synthetic_rate(125),
+  synthetic_random(false),
   controller_slots(),
   chatpad(false),
   chatpad_no_init(false),
@@ -100,6 +111,12 @@ Options::Options() :
   pid_file(),
   on_connect(),
   on_disconnect(),
+  on_low_battery(),
+  low_battery(25),
+  low_battery_led(-1),
+  low_battery_rumble_gain(255),
+  usb_contexts(0),
+  usb_context_by_bus(false),
   exec(),
   list_enums(0),
   config_toggle_button(XBOX_BTN_UNKNOWN),
@@ -108,6 +125,12 @@ Options::Options() :
   config_slot(0),
   extra_devices(true),
   extra_events(true),
+  wheel_hi_res(false),
+  rel_rate(100),
+  uinput_backend(UInputBackend::kKernel),
+  exec_rate(10),
+  exec_debounce(0),
+  state_shm(),
   uinput_device_names(),
   uinput_device_usbids(),
   usb_debug(false),
@@ -172,6 +195,10 @@ Options::set_priority(const std::string& value)
   {
     priority = kPriorityRealtime;
   }
+  else if (value == "deadline")
+  {
+    priority = kPriorityDeadline;
+  }
   else if (value == "normal")
   {
     priority = kPriorityNormal;
@@ -182,6 +209,49 @@ Options::set_priority(const std::string& value)
   }
 }
 
+void
+Options::set_cpu_affinity(const std::string& value)
+{
+  // a list like "2,4-5"
+  cpu_affinity.clear();
+
+  typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+  tokenizer tokens(value, boost::char_separator<char>(",", "", boost::drop_empty_tokens));
+  for(tokenizer::iterator t = tokens.begin(); t != tokens.end(); ++t)
+  {
+    std::string lhs, rhs;
+    split_string_at(*t, '-', &lhs, &rhs);
+
+    int first = boost::lexical_cast<int>(lhs);
+    int last  = rhs.empty() ? first : boost::lexical_cast<int>(rhs);
+    if (first < 0 || last < first)
+    {
+      raise_exception(std::runtime_error, "invalid cpu range: '" << *t << "'");
+    }
+
+    for(int cpu = first; cpu <= last; ++cpu)
+    {
+      cpu_affinity.push_back(cpu);
+    }
+  }
+}
+
+void
+Options::set_uinput_backend(const std::string& value)
+{
+  uinput_backend = UInputBackend::type_from_string(value);
+}
+
+void
+Options::set_synthetic(const std::string& value)
+{
+  synthetic_type = gamepadtype_from_string(value);
+  if (synthetic_type == GAMEPAD_UNKNOWN)
+  {
+    raise_exception(std::runtime_error, "unknown synthetic controller type: '" << value << "'");
+  }
+}
+
 void
 Options::set_ui_clear()
 {
@@ -27,6 +27,7 @@
 #include "controller_options.hpp"
 #include "controller_slot_options.hpp"
 #include "evdev_absmap.hpp"
+#include "uinput_backend.hpp"
 #include "uinput_options.hpp"
 #include "xpad_device.hpp"
 
@@ -57,7 +58,8 @@ public:
 
   enum Priority {
     kPriorityNormal,
-    kPriorityRealtime
+    kPriorityRealtime,
+    kPriorityDeadline
   };
 
   // General program options
@@ -74,6 +76,10 @@ public:
   bool detach_kernel_driver;
   int  timeout;
   Priority priority;
+  int  deadline_runtime;
+  int  deadline_period;
+  std::vector<int> cpu_affinity;
+  bool mlock;
 
   GamepadType gamepad_type;
 
@@ -90,6 +96,17 @@ public:
   bool evdev_debug;
   std::map<int, XboxButton> evdev_keymap;
 
+  // recording options
+  std::string record_file;
+  std::string replay_file;
+  bool replay_fast;
+
+  // synthetic controller options
+  GamepadType synthetic_type;
+  int  synthetic_count;
+  int  synthetic_rate;
+  bool synthetic_random;
+
   // controller options
   typedef std::map<int, ControllerSlotOptions> ControllerSlots;
   ControllerSlots controller_slots;
@@ -117,6 +134,12 @@ public:
   std::string pid_file;
   std::string on_connect;
   std::string on_disconnect;
+  std::string on_low_battery;
+  int  low_battery;
+  int  low_battery_led;
+  int  low_battery_rumble_gain;
+  int  usb_contexts;
+  bool usb_context_by_bus;
 
   std::vector<std::string> exec;
 
@@ -130,6 +153,14 @@ public:
 
   bool extra_devices;
   bool extra_events;
+  bool wheel_hi_res;
+  int  rel_rate;
+  UInputBackend::Type uinput_backend;
+
+  int  exec_rate;
+  int  exec_debounce;
+
+  std::string state_shm;
 
   std::map<uint32_t, std::string> uinput_device_names;
   std::map<uint32_t, struct input_id> uinput_device_usbids;
@@ -185,6 +216,9 @@ public:
   const ControllerOptions& get_controller_options() const;
 
   void set_priority(const std::string& value);
+  void set_cpu_affinity(const std::string& value);
+  void set_uinput_backend(const std::string& value);
+  void set_synthetic(const std::string& value);
 
   void set_ui_clear();
 
@@ -0,0 +1,166 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "pad_status.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+/** A pause counts as a gap when it is kGapFactor times the current
+    report interval and at least kMinGap usec long. Most pads only
+    report changes, pauses over kMaxGap usec are taken as the pad
+    lying idle, not as a failing link. */
+const int     kGapFactor = 4;
+const int64_t kMinGap    = 20 * 1000;
+const int64_t kMaxGap    = 1000 * 1000;
+
+} // namespace
+
+PadStatus::PadStatus() :
+  m_connected(false),
+  m_battery_level(-1),
+  m_low_battery(false),
+  m_reports(0),
+  m_connects(0),
+  m_disconnects(0),
+  m_report_rate(0),
+  m_window_reports(0),
+  m_window_start(0),
+  m_last_report(0),
+  m_gaps(0),
+  m_read_errors(0),
+  m_error_base(0)
+{
+}
+
+void
+PadStatus::connect(int64_t usec_time, int error_count)
+{
+  m_connected = true;
+  m_connects += 1;
+
+  // battery and rate belong to the controller, not the slot
+  m_battery_level = -1;
+  m_low_battery = false;
+  m_report_rate = 0;
+  m_window_reports = 0;
+  m_window_start = usec_time;
+  m_last_report = 0;
+  m_error_base = error_count;
+}
+
+void
+PadStatus::disconnect()
+{
+  m_connected = false;
+  m_disconnects += 1;
+  m_report_rate = 0;
+}
+
+void
+PadStatus::report(int64_t usec_time)
+{
+  m_reports += 1;
+  m_window_reports += 1;
+
+  if (m_last_report != 0 && m_report_rate > 0)
+  {
+    const int64_t interval = usec_time - m_last_report;
+    if (interval > std::max<int64_t>(kGapFactor * 1000 * 1000 / m_report_rate, kMinGap) &&
+        interval < kMaxGap)
+    {
+      m_gaps += 1;
+    }
+  }
+  m_last_report = usec_time;
+
+  int64_t window = usec_time - m_window_start;
+  if (window >= 1000 * 1000)
+  {
+    m_report_rate = static_cast<int>(m_window_reports * 1000 * 1000 / window);
+    m_window_reports = 0;
+    m_window_start = usec_time;
+  }
+}
+
+void
+PadStatus::update(int64_t usec_time, int error_count)
+{
+  if (!m_connected)
+  {
+    return;
+  }
+
+  // the window is left running, the next report closes it
+  int64_t window = usec_time - m_window_start;
+  if (window >= 1000 * 1000)
+  {
+    m_report_rate = static_cast<int>(m_window_reports * 1000 * 1000 / window);
+  }
+
+  if (error_count >= m_error_base)
+  {
+    m_read_errors += error_count - m_error_base;
+  }
+  m_error_base = error_count;
+}
+
+bool
+PadStatus::set_battery_level(int level)
+{
+  if (m_battery_level == level)
+  {
+    return false;
+  }
+  else
+  {
+    m_battery_level = level;
+    return true;
+  }
+}
+
+std::string
+PadStatus::str() const
+{
+  std::ostringstream out;
+
+  out << "connected: " << (m_connected ? "yes" : "no") << "\n"
+      << "battery: ";
+  if (m_battery_level < 0)
+  {
+    out << "-";
+  }
+  else
+  {
+    out << m_battery_level << "%" << (m_low_battery ? " (low)" : "");
+  }
+  out << "\n"
+      << "reports: " << m_reports << "\n"
+      << "report rate: " << m_report_rate << "/s\n"
+      << "read errors: " << m_read_errors << "\n"
+      << "gaps: " << m_gaps << "\n"
+      << "connects: " << m_connects << "\n"
+      << "disconnects: " << m_disconnects << "\n";
+
+  return out.str();
+}
+
+/* EOF */
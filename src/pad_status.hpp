@@ -0,0 +1,97 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_PAD_STATUS_HPP
+#define HEADER_XBOXDRV_PAD_STATUS_HPP
+
+#include <stdint.h>
+#include <string>
+
+/**
+    Battery and link statistics of the controller in a slot, kept
+    across reconnects so that pads that keep dropping out can be
+    spotted.
+ */
+class PadStatus
+{
+public:
+  enum Event {
+    kConnected,
+    kDisconnected,
+    kBatteryChanged,
+    kLowBattery
+  };
+
+private:
+  bool m_connected;
+  int  m_battery_level;
+  bool m_low_battery;
+
+  uint64_t m_reports;
+  int m_connects;
+  int m_disconnects;
+
+  /** reports per second, measured over windows of a second */
+  int m_report_rate;
+  int m_window_reports;
+  int64_t m_window_start;
+
+  /** pauses between two reports that are much longer than the
+      current report interval, kept across reconnects */
+  int64_t m_last_report;
+  int m_gaps;
+
+  /** failed USB reads, the controller counts them over its lifetime,
+      m_error_base is its count when it was last looked at */
+  int m_read_errors;
+  int m_error_base;
+
+public:
+  PadStatus();
+
+  void connect(int64_t usec_time, int error_count);
+  void disconnect();
+  void report(int64_t usec_time);
+
+  /** Brings the report rate and the read errors up to date, the rate
+      drops when no reports came in over the last second */
+  void update(int64_t usec_time, int error_count);
+
+  /** Returns true if \a level differs from the last one */
+  bool set_battery_level(int level);
+  void set_low_battery(bool low) { m_low_battery = low; }
+
+  bool is_connected() const { return m_connected; }
+  int  get_battery_level() const { return m_battery_level; }
+  bool is_low_battery() const { return m_low_battery; }
+  uint64_t get_reports() const { return m_reports; }
+  int  get_report_rate() const { return m_report_rate; }
+  int  get_gaps() const { return m_gaps; }
+  int  get_read_errors() const { return m_read_errors; }
+  /** read errors and gaps, the reports that were likely lost */
+  int  get_drops() const { return m_read_errors + m_gaps; }
+  int  get_connects() const { return m_connects; }
+  int  get_disconnects() const { return m_disconnects; }
+
+  std::string str() const;
+};
+
+#endif
+
+/* EOF */
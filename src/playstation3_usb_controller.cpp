@@ -23,6 +23,7 @@
 #include <string.h>
 
 #include "log.hpp"
+#include "unpack.hpp"
 #include "usb_helper.hpp"
 #include "xboxmsg.hpp"
 
@@ -127,8 +128,6 @@ Playstation3USBController::set_led_real(uint8_t status)
               cmd, sizeof(cmd));
 }
 
-#define bitswap(x) x = ((x & 0x00ff) << 8) | ((x & 0xff00) >> 8)
-
 bool
 Playstation3USBController::parse(uint8_t* data, int len, XboxGenericMsg* msg_out)
 {
@@ -137,10 +136,11 @@ Playstation3USBController::parse(uint8_t* data, int len, XboxGenericMsg* msg_out
     msg_out->type = XBOX_MSG_PS3USB;
     memcpy(&msg_out->ps3usb, data, sizeof(msg_out->ps3usb));
 
-    bitswap(msg_out->ps3usb.accl_x);
-    bitswap(msg_out->ps3usb.accl_y);
-    bitswap(msg_out->ps3usb.accl_z);
-    bitswap(msg_out->ps3usb.rot_z);
+    // the motion sensors are big endian
+    msg_out->ps3usb.accl_x = unpack::uint16be(data+41);
+    msg_out->ps3usb.accl_y = unpack::uint16be(data+43);
+    msg_out->ps3usb.accl_z = unpack::uint16be(data+45);
+    msg_out->ps3usb.rot_z  = unpack::uint16be(data+47);
 
     if (false)
     {
@@ -0,0 +1,238 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "replay_controller.hpp"
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <errno.h>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string.h>
+
+#include "controller_factory.hpp"
+#include "input_recorder.hpp"
+#include "log.hpp"
+#include "options.hpp"
+#include "raise_exception.hpp"
+#include "usb_controller.hpp"
+
+namespace {
+
+uint64_t read_le(const uint8_t* data, int bytes)
+{
+  uint64_t value = 0;
+  for(int i = 0; i < bytes; ++i)
+  {
+    value |= static_cast<uint64_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+} // namespace
+
+ReplayController::ReplayController(const std::string& filename, bool fast, const Options& opts) :
+  m_filename(filename),
+  m_fast(fast),
+  m_dev_type(),
+  m_controller(),
+  m_usb_controller(0),
+  m_data(),
+  m_pos(InputRecorder::kHeaderSize),
+  m_start_time(0),
+  m_time(0),
+  m_source_id(0)
+{
+  std::ifstream in(m_filename.c_str(), std::ios::binary);
+  if (!in)
+  {
+    raise_exception(std::runtime_error, m_filename << ": " << strerror(errno));
+  }
+
+  m_data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+  if (m_data.size() < InputRecorder::kHeaderSize ||
+      memcmp(&m_data[0], InputRecorder::kMagic, sizeof(InputRecorder::kMagic)) != 0)
+  {
+    raise_exception(std::runtime_error, m_filename << ": not an xboxdrv recording");
+  }
+
+  GamepadType type = static_cast<GamepadType>(read_le(&m_data[8], 2));
+  uint16_t idVendor  = static_cast<uint16_t>(read_le(&m_data[10], 2));
+  uint16_t idProduct = static_cast<uint16_t>(read_le(&m_data[12], 2));
+
+  if (!find_xpad_device(idVendor, idProduct, &m_dev_type) || m_dev_type.type != type)
+  {
+    m_dev_type.type = type;
+    m_dev_type.idVendor  = idVendor;
+    m_dev_type.idProduct = idProduct;
+    m_dev_type.name = "Recorded Controller";
+    m_dev_type.interface = 0;
+    m_dev_type.endpoint = 0;
+    m_dev_type.quirks = 0;
+  }
+
+  if (type == GAMEPAD_GENERIC_USB)
+  {
+    raise_exception(std::runtime_error, m_filename << ": replaying generic USB controllers isn't supported");
+  }
+
+  // the chatpad and headset talk to the device directly, so they
+  // can't be used without one
+  Options offline_opts = opts;
+  offline_opts.chatpad = false;
+  offline_opts.headset = false;
+
+  m_controller = ControllerFactory::create(m_dev_type, 0, offline_opts);
+  m_usb_controller = dynamic_cast<USBController*>(m_controller.get());
+  assert(m_usb_controller);
+
+  m_is_active = m_controller->is_active();
+  m_controller->set_message_cb(boost::bind(&ReplayController::submit_msg, this, _1));
+  m_controller->set_activation_cb(boost::bind(&ReplayController::on_activation, this));
+
+  // the clock starts with the first report, so the time spent
+  // setting up uinput doesn't end up in the replay
+  m_source_id = g_idle_add(&ReplayController::on_timeout_wrap, this);
+
+  log_info("replaying " << m_filename << " (" << m_dev_type.name << ")"
+           << (m_fast ? " as fast as possible" : ""));
+}
+
+ReplayController::~ReplayController()
+{
+  if (m_source_id)
+  {
+    g_source_remove(m_source_id);
+  }
+}
+
+bool
+ReplayController::peek_record(gint64* usec, size_t* offset, int* len) const
+{
+  if (m_pos + InputRecorder::kRecordHeaderSize > m_data.size())
+  {
+    return false;
+  }
+  else
+  {
+    *usec   = static_cast<gint64>(read_le(&m_data[m_pos], 8));
+    *len    = static_cast<int>(read_le(&m_data[m_pos + 8], 2));
+    *offset = m_pos + InputRecorder::kRecordHeaderSize;
+
+    if (*offset + *len > m_data.size())
+    {
+      log_warn(m_filename << ": truncated record at offset " << m_pos);
+      return false;
+    }
+    else
+    {
+      return true;
+    }
+  }
+}
+
+bool
+ReplayController::on_timeout()
+{
+  if (!m_start_time)
+  {
+    m_start_time = g_get_monotonic_time();
+  }
+
+  gint64 usec;
+  size_t offset;
+  int len;
+
+  while(peek_record(&usec, &offset, &len))
+  {
+    if (!m_fast)
+    {
+      gint64 due = m_start_time + usec - g_get_monotonic_time();
+      if (due > 0)
+      {
+        // not yet, come back when the report is due
+        m_source_id = g_timeout_add_full(G_PRIORITY_HIGH, static_cast<guint>((due + 999) / 1000),
+                                         &ReplayController::on_timeout_wrap, this, NULL);
+        return false;
+      }
+    }
+
+    m_time = m_start_time + usec;
+    m_pos = offset + len;
+    m_usb_controller->inject_report(&m_data[offset], len);
+
+    if (m_fast)
+    {
+      // one report per main loop iteration, so that timeouts and
+      // uinput get their turn in between
+      return true;
+    }
+  }
+
+  log_info("replay of " << m_filename << " finished");
+  m_source_id = 0;
+  send_disconnect();
+  return false;
+}
+
+void
+ReplayController::on_activation()
+{
+  set_active(m_controller->is_active());
+}
+
+void
+ReplayController::set_rumble_real(uint8_t left, uint8_t right)
+{
+  m_controller->set_rumble_real(left, right);
+}
+
+void
+ReplayController::set_led_real(uint8_t status)
+{
+  m_controller->set_led_real(status);
+}
+
+int64_t
+ReplayController::get_time() const
+{
+  return m_start_time ? m_time : g_get_monotonic_time();
+}
+
+std::string
+ReplayController::get_usbpath() const
+{
+  return "000:000";
+}
+
+std::string
+ReplayController::get_usbid() const
+{
+  return (boost::format("%04x:%04x") % m_dev_type.idVendor % m_dev_type.idProduct).str();
+}
+
+std::string
+ReplayController::get_name() const
+{
+  return m_dev_type.name;
+}
+
+/* EOF */
@@ -0,0 +1,101 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_REPLAY_CONTROLLER_HPP
+#define HEADER_XBOXDRV_REPLAY_CONTROLLER_HPP
+
+#include <glib.h>
+#include <string>
+#include <vector>
+
+#include "controller.hpp"
+#include "controller_ptr.hpp"
+#include "xpad_device.hpp"
+
+class Options;
+class USBController;
+
+/**
+    Plays back a file written by InputRecorder. The reports are fed
+    through the parse() of an offline controller of the recorded type,
+    so they go through the same path as reports from real hardware.
+
+    Messages are stamped with the time of the recording, so the
+    modifiers and button filters see the recorded timing whether the
+    replay runs at the original speed or as fast as possible. The
+    relative motion and repeat of UInput and running macros still
+    follow the wall clock, with --replay-fast they cover less time
+    than in the recording.
+ */
+class ReplayController : public Controller
+{
+private:
+  std::string m_filename;
+  bool m_fast;
+
+  XPadDevice m_dev_type;
+  ControllerPtr m_controller;
+  USBController* m_usb_controller;
+
+  std::vector<uint8_t> m_data;
+  size_t m_pos;
+
+  /** wall clock time at which the replay started, 0 before that */
+  gint64 m_start_time;
+
+  /** the time of the current report */
+  gint64 m_time;
+
+  guint m_source_id;
+
+public:
+  ReplayController(const std::string& filename, bool fast, const Options& opts);
+  ~ReplayController();
+
+  void set_rumble_real(uint8_t left, uint8_t right);
+  void set_led_real(uint8_t status);
+
+  int64_t get_time() const;
+
+  std::string get_usbpath() const;
+  std::string get_usbid() const;
+  std::string get_name() const;
+
+  const XPadDevice& get_dev_type() const { return m_dev_type; }
+
+private:
+  /** Read the next report, returns false at the end of the file */
+  bool peek_record(gint64* usec, size_t* offset, int* len) const;
+
+  void on_activation();
+
+  bool on_timeout();
+  static gboolean on_timeout_wrap(gpointer data)
+  {
+    return static_cast<ReplayController*>(data)->on_timeout();
+  }
+
+private:
+  ReplayController(const ReplayController&);
+  ReplayController& operator=(const ReplayController&);
+};
+
+#endif
+
+/* EOF */
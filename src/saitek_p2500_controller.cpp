@@ -21,39 +21,20 @@
 #include <sstream>
 
 #include "helper.hpp"
+#include "unpack.hpp"
 #include "usb_helper.hpp"
 
-struct SaitekP2500Msg
-{
-  int dummy :8; // data[0]
-
-  int x1 :8; // data[1]
-  int y1 :8; // data[2]
-
-  int x2 :8; // data[3]
-  int y2 :8; // data[4]
-
-  // data[5];
-  unsigned int a   :1;
-  unsigned int x   :1;
-  unsigned int b   :1;
-  unsigned int y   :1;
-
-  unsigned int lb  :1;
-  unsigned int lt  :1;
-  unsigned int rb  :1;
-  unsigned int rt  :1;
+namespace {
 
-  // data[6];
-  unsigned int thumb_l :1;
-  unsigned int thumb_r :1;
-
-  unsigned int start :1;
-  unsigned int back  :1; // not supported
-
-  unsigned int dpad :4;
+/*
+   data[0]    unused
+   data[1..4] x1, y1, x2, y2, signed
+   data[5]    a, x, b, y, lb, lt, rb, rt, from the lowest bit up
+   data[6]    thumb_l, thumb_r, start, back (not supported), dpad :4
+*/
+const int kReportSize = 7;
 
-} __attribute__((__packed__));
+} // namespace
 
 SaitekP2500Controller::SaitekP2500Controller(libusb_device* dev, bool try_detach) :
   USBController(dev),
@@ -61,7 +42,7 @@ SaitekP2500Controller::SaitekP2500Controller(libusb_device* dev, bool try_detach
   right_rumble(-1)
 {
   usb_claim_interface(0, try_detach);
-  usb_submit_read(1, sizeof(SaitekP2500Msg));
+  usb_submit_read(1, kReportSize);
 }
 
 SaitekP2500Controller::~SaitekP2500Controller()
@@ -83,38 +64,35 @@ SaitekP2500Controller::set_led_real(uint8_t status)
 bool
 SaitekP2500Controller::parse(uint8_t* data, int len, XboxGenericMsg* msg_out)
 {
-  if (len == sizeof(SaitekP2500Msg))
+  if (len == kReportSize)
   {
-    SaitekP2500Msg msg_in;
-    memcpy(&msg_in, data, sizeof(SaitekP2500Msg));
-
     memset(msg_out, 0, sizeof(*msg_out));
     msg_out->type = XBOX_MSG_XBOX360;
 
-    msg_out->xbox360.a = msg_in.a;
-    msg_out->xbox360.b = msg_in.b;
-    msg_out->xbox360.x = msg_in.x;
-    msg_out->xbox360.y = msg_in.y;
+    msg_out->xbox360.a = unpack::bit(data+5, 0);
+    msg_out->xbox360.b = unpack::bit(data+5, 2);
+    msg_out->xbox360.x = unpack::bit(data+5, 1);
+    msg_out->xbox360.y = unpack::bit(data+5, 3);
 
-    msg_out->xbox360.lb = msg_in.lb;
-    msg_out->xbox360.rb = msg_in.rb;
+    msg_out->xbox360.lb = unpack::bit(data+5, 4);
+    msg_out->xbox360.rb = unpack::bit(data+5, 6);
 
-    msg_out->xbox360.lt = msg_in.lt * 255;
-    msg_out->xbox360.rt = msg_in.rt * 255;
+    msg_out->xbox360.lt = unpack::bit(data+5, 5) * 255;
+    msg_out->xbox360.rt = unpack::bit(data+5, 7) * 255;
 
-    msg_out->xbox360.start = msg_in.start;
-    msg_out->xbox360.back  = msg_in.back;
+    msg_out->xbox360.start = unpack::bit(data+6, 2);
+    msg_out->xbox360.back  = unpack::bit(data+6, 3);
 
-    msg_out->xbox360.thumb_l = msg_in.thumb_l;
-    msg_out->xbox360.thumb_r = msg_in.thumb_r;
+    msg_out->xbox360.thumb_l = unpack::bit(data+6, 0);
+    msg_out->xbox360.thumb_r = unpack::bit(data+6, 1);
 
-    msg_out->xbox360.x1 = scale_8to16(msg_in.x1);
-    msg_out->xbox360.y1 = scale_8to16(msg_in.y1);
+    msg_out->xbox360.x1 = scale_8to16(static_cast<int8_t>(data[1]));
+    msg_out->xbox360.y1 = scale_8to16(static_cast<int8_t>(data[2]));
 
-    msg_out->xbox360.x2 = scale_8to16(msg_in.x2);
-    msg_out->xbox360.y2 = scale_8to16(msg_in.y2);
+    msg_out->xbox360.x2 = scale_8to16(static_cast<int8_t>(data[3]));
+    msg_out->xbox360.y2 = scale_8to16(static_cast<int8_t>(data[4]));
 
-    switch(msg_in.dpad)
+    switch(data[6] >> 4)
     {
       case 0:
         msg_out->xbox360.dpad_up    = 1;
@@ -0,0 +1,291 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "scheduling.hpp"
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdexcept>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "log.hpp"
+#include "options.hpp"
+#include "raise_exception.hpp"
+
+#ifndef SCHED_RESET_ON_FORK
+#  define SCHED_RESET_ON_FORK 0x40000000
+#endif
+
+#ifndef SCHED_DEADLINE
+#  define SCHED_DEADLINE 6
+#endif
+
+Scheduling g_scheduling;
+
+namespace {
+
+/** stack that is touched up front when memory is locked, the input
+    path doesn't go anywhere near that deep */
+const int kPrefaultStackSize = 256 * 1024;
+
+/** the kernel's struct sched_attr, which older libc don't have */
+struct SchedAttr
+{
+  uint32_t size;
+  uint32_t sched_policy;
+  uint64_t sched_flags;
+  int32_t  sched_nice;
+  uint32_t sched_priority;
+  uint64_t sched_runtime;
+  uint64_t sched_deadline;
+  uint64_t sched_period;
+};
+
+const uint64_t kSchedFlagResetOnFork = 0x01;
+
+void prefault_stack()
+{
+  char buffer[kPrefaultStackSize];
+  memset(buffer, 0, sizeof(buffer));
+
+  // keep the compiler from dropping the memset()
+  __asm__ __volatile__("" : : "r"(buffer) : "memory");
+}
+
+} // namespace
+
+Scheduling::Scheduling() :
+  m_realtime(false),
+  m_has_background_cpus(false),
+  m_background_cpus()
+{
+  CPU_ZERO(&m_background_cpus);
+}
+
+void
+Scheduling::enter_input_thread(const Options& opts)
+{
+  switch(opts.priority)
+  {
+    case Options::kPriorityNormal:
+      break;
+
+    case Options::kPriorityRealtime:
+      set_realtime();
+      m_realtime = true;
+      break;
+
+    case Options::kPriorityDeadline:
+      if (!set_deadline(opts.deadline_runtime, opts.deadline_period))
+      {
+        log_warn("SCHED_DEADLINE not available, falling back to realtime priority");
+        set_realtime();
+      }
+      m_realtime = true;
+      break;
+  }
+
+  if (!opts.cpu_affinity.empty())
+  {
+    set_cpu_affinity(opts);
+  }
+
+  if (opts.mlock)
+  {
+    lock_memory();
+  }
+}
+
+void
+Scheduling::enter_background_thread() const
+{
+  // new threads start with normal scheduling thanks to
+  // SCHED_RESET_ON_FORK, but they inherit the CPU affinity
+  if (m_has_background_cpus)
+  {
+    if (sched_setaffinity(0, sizeof(m_background_cpus), &m_background_cpus) != 0)
+    {
+      log_warn("sched_setaffinity() failed: " << strerror(errno));
+    }
+  }
+}
+
+void
+Scheduling::enter_usb_event_thread() const
+{
+  // like all new threads they start with normal scheduling, but the
+  // input thread waits for their completions, so they need realtime
+  // priority as well, a deadline reservation isn't needed for that
+  // as they only wake up when a transfer completes
+  if (m_realtime)
+  {
+    struct sched_param param;
+    memset(&param, 0, sizeof(struct sched_param));
+    param.sched_priority = sched_get_priority_max(SCHED_RR) - 1;
+
+    if (sched_setscheduler(0, SCHED_RR | SCHED_RESET_ON_FORK, &param) != 0)
+    {
+      log_warn("sched_setscheduler() failed for USB event thread: " << strerror(errno));
+    }
+  }
+
+  // keep off the CPUs of the input thread
+  enter_background_thread();
+}
+
+void
+Scheduling::set_realtime()
+{
+  // try to set realtime priority when root, as user there doesn't
+  // seem to be a way to increase the priority
+  log_info("enabling realtime priority scheduling");
+
+  int policy = SCHED_RR;
+
+  struct sched_param param;
+  memset(&param, 0, sizeof(struct sched_param));
+  param.sched_priority = sched_get_priority_max(policy);
+
+  // we don't try SCHED_OTHER for users as min and max priority is
+  // 0 for that, thus we can't change anything with that
+
+  // only this thread, not the ones it starts later
+  if (sched_setscheduler(0, policy | SCHED_RESET_ON_FORK, &param) != 0)
+  {
+    raise_exception(std::runtime_error, "sched_setscheduler() failed: " << strerror(errno));
+  }
+}
+
+bool
+Scheduling::set_deadline(int runtime, int period)
+{
+#ifdef SYS_sched_setattr
+  log_info("enabling SCHED_DEADLINE scheduling, runtime " << runtime << " usec, period " << period << " usec");
+
+  if (runtime <= 0 || runtime > period)
+  {
+    raise_exception(std::runtime_error, "deadline runtime must be between 1 and the period: "
+                    << runtime << " " << period);
+  }
+
+  SchedAttr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.sched_policy = SCHED_DEADLINE;
+  // a deadline thread can't start other threads otherwise
+  attr.sched_flags = kSchedFlagResetOnFork;
+  attr.sched_runtime  = static_cast<uint64_t>(runtime) * 1000;
+  attr.sched_deadline = static_cast<uint64_t>(period) * 1000;
+  attr.sched_period   = static_cast<uint64_t>(period) * 1000;
+
+  if (syscall(SYS_sched_setattr, 0, &attr, 0) != 0)
+  {
+    if (errno == EPERM || errno == EBUSY)
+    {
+      // not a missing feature, but missing rights or bandwidth
+      raise_exception(std::runtime_error, "sched_setattr() failed: " << strerror(errno));
+    }
+    else
+    {
+      log_warn("sched_setattr() failed: " << strerror(errno));
+      return false;
+    }
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+Scheduling::set_cpu_affinity(const Options& opts)
+{
+  cpu_set_t process_cpus;
+  CPU_ZERO(&process_cpus);
+  if (sched_getaffinity(0, sizeof(process_cpus), &process_cpus) != 0)
+  {
+    raise_exception(std::runtime_error, "sched_getaffinity() failed: " << strerror(errno));
+  }
+
+  cpu_set_t input_cpus;
+  CPU_ZERO(&input_cpus);
+  for(std::vector<int>::const_iterator i = opts.cpu_affinity.begin(); i != opts.cpu_affinity.end(); ++i)
+  {
+    if (*i < 0 || *i >= CPU_SETSIZE)
+    {
+      raise_exception(std::runtime_error, "invalid cpu: " << *i);
+    }
+    CPU_SET(*i, &input_cpus);
+  }
+
+  int policy = sched_getscheduler(0) & ~SCHED_RESET_ON_FORK;
+  if (policy == SCHED_DEADLINE)
+  {
+    // the kernel only allows that when the CPUs are a cpuset of their own
+    log_warn("--cpu-affinity is ignored with SCHED_DEADLINE, use a cpuset instead");
+    return;
+  }
+
+  log_info("pinning input thread to " << CPU_COUNT(&input_cpus) << " cpu(s)");
+  if (sched_setaffinity(0, sizeof(input_cpus), &input_cpus) != 0)
+  {
+    raise_exception(std::runtime_error, "sched_setaffinity() failed: " << strerror(errno));
+  }
+
+  // background threads get what is left, or everything when nothing is
+  m_background_cpus = process_cpus;
+  for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+  {
+    if (CPU_ISSET(cpu, &input_cpus))
+    {
+      CPU_CLR(cpu, &m_background_cpus);
+    }
+  }
+
+  if (CPU_COUNT(&m_background_cpus) == 0)
+  {
+    m_background_cpus = process_cpus;
+  }
+  m_has_background_cpus = true;
+}
+
+void
+Scheduling::lock_memory()
+{
+  log_info("locking memory");
+
+  // keep freed memory around and don't give large allocations their
+  // own mappings, either would mean page faults later on
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    raise_exception(std::runtime_error, "mlockall() failed: " << strerror(errno));
+  }
+
+  prefault_stack();
+}
+
+/* EOF */
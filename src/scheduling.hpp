@@ -0,0 +1,74 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_SCHEDULING_HPP
+#define HEADER_XBOXDRV_SCHEDULING_HPP
+
+#include <sched.h>
+
+class Options;
+
+/**
+    Scheduling of the threads of xboxdrv. The thread running the main
+    loop handles USB, the processing and the uinput output, so it is
+    the one that gets the realtime class, its own CPUs and locked
+    memory. Threads doing blocking background work, like bringing up
+    controllers or writing recordings, go back to normal scheduling
+    on the remaining CPUs, so they don't compete with it. The USB
+    event threads also run on the remaining CPUs, but keep realtime
+    priority, as the input thread waits for them.
+ */
+class Scheduling
+{
+private:
+  bool m_realtime;
+  bool m_has_background_cpus;
+  cpu_set_t m_background_cpus;
+
+public:
+  Scheduling();
+
+  /** Apply the settings from \a opts to the calling thread, must be
+      called after forking and before any other thread is started */
+  void enter_input_thread(const Options& opts);
+
+  /** Called by background threads before they start their work */
+  void enter_background_thread() const;
+
+  /** Called by the USB event threads of g_usb_contexts, they get
+      realtime priority just below the input thread when it has one,
+      and the CPUs of the background threads */
+  void enter_usb_event_thread() const;
+
+private:
+  void set_realtime();
+  bool set_deadline(int runtime, int period);
+  void set_cpu_affinity(const Options& opts);
+  void lock_memory();
+
+private:
+  Scheduling(const Scheduling&);
+  Scheduling& operator=(const Scheduling&);
+};
+
+extern Scheduling g_scheduling;
+
+#endif
+
+/* EOF */
@@ -0,0 +1,325 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "spawn_service.hpp"
+
+#include <algorithm>
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "log.hpp"
+#include "raise_exception.hpp"
+
+extern char** environ;
+
+SpawnService g_spawn_service;
+
+std::string
+SpawnService::encode(const std::vector<std::string>& args)
+{
+  assert(!args.empty());
+
+  // arguments separated by '\0', the helper splits them up again
+  std::string request;
+  for(std::vector<std::string>::const_iterator i = args.begin(); i != args.end(); ++i)
+  {
+    request += *i;
+    request += '\0';
+  }
+  return request;
+}
+
+SpawnService::SpawnService() :
+  m_fd(-1),
+  m_pid(-1),
+  m_rate(10),
+  m_debounce(0),
+  m_tokens(10.0),
+  m_last_refill(0),
+  m_last_spawn()
+{
+}
+
+SpawnService::~SpawnService()
+{
+  stop();
+}
+
+void
+SpawnService::start()
+{
+  if (m_fd < 0)
+  {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0)
+    {
+      raise_exception(std::runtime_error, "socketpair() failed: " << strerror(errno));
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      close(fds[0]);
+      close(fds[1]);
+      raise_exception(std::runtime_error, "fork() failed: " << strerror(errno));
+    }
+    else if (pid == 0)
+    {
+      close(fds[0]);
+      run_helper(fds[1]);
+    }
+    else
+    {
+      close(fds[1]);
+      m_fd  = fds[0];
+      m_pid = pid;
+      log_debug("spawn helper started: " << m_pid);
+    }
+  }
+}
+
+void
+SpawnService::stop()
+{
+  if (m_fd >= 0)
+  {
+    // the helper exits when its end of the socket gets closed
+    close(m_fd);
+    waitpid(m_pid, NULL, 0);
+
+    m_fd  = -1;
+    m_pid = -1;
+  }
+}
+
+void
+SpawnService::set_rate_limit(int requests_per_second)
+{
+  m_rate   = requests_per_second;
+  m_tokens = requests_per_second;
+}
+
+void
+SpawnService::set_debounce(int msec)
+{
+  m_debounce = msec;
+}
+
+void
+SpawnService::spawn(const std::string& request)
+{
+  if (m_fd < 0)
+  {
+    spawn_direct(request);
+  }
+  else if (send(m_fd, request.data(), request.size(), MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+  {
+    if (errno == EAGAIN)
+    {
+      log_warn("spawn helper is busy, dropping request: " << request.c_str());
+    }
+    else
+    {
+      // forking a new helper now would copy the daemon with all its
+      // threads, so continue without one
+      log_error("spawn helper failed, launching programs directly from now on: " << strerror(errno));
+
+      close(m_fd);
+      g_child_watch_add(m_pid, &SpawnService::on_child_exit, NULL);
+      m_fd  = -1;
+      m_pid = -1;
+
+      spawn_direct(request);
+    }
+  }
+}
+
+void
+SpawnService::spawn_direct(const std::string& request)
+{
+  std::vector<char> buf(request.begin(), request.end());
+  buf.push_back('\0');
+
+  std::vector<char*> argv;
+  for(char* p = &buf[0]; p < &buf[0] + request.size(); p += strlen(p) + 1)
+  {
+    argv.push_back(p);
+  }
+  argv.push_back(NULL);
+
+  // don't pass the signal mask of the calling thread on
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  sigset_t sigmask;
+  sigemptyset(&sigmask);
+  posix_spawnattr_setsigmask(&attr, &sigmask);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+  pid_t pid;
+  int ret = posix_spawnp(&pid, argv[0], NULL, &attr, &argv[0], environ);
+  posix_spawnattr_destroy(&attr);
+
+  if (ret != 0)
+  {
+    log_error(argv[0] << ": exec failed: " << strerror(ret));
+  }
+  else
+  {
+    g_child_watch_add(pid, &SpawnService::on_child_exit, NULL);
+  }
+}
+
+void
+SpawnService::on_child_exit(GPid pid, gint status, gpointer data)
+{
+  g_spawn_close_pid(pid);
+}
+
+bool
+SpawnService::spawn_limited(const std::string& request)
+{
+  gint64 now = g_get_monotonic_time();
+
+  if (m_debounce > 0)
+  {
+    LastSpawn::iterator it = m_last_spawn.find(request);
+    if (it != m_last_spawn.end() && now - it->second < m_debounce * 1000)
+    {
+      log_debug("debouncing: " << request.c_str());
+      return false;
+    }
+    else
+    {
+      m_last_spawn[request] = now;
+    }
+  }
+
+  if (m_rate > 0)
+  {
+    // token bucket, allowing a burst of m_rate requests
+    m_tokens = std::min(static_cast<double>(m_rate),
+                        m_tokens + static_cast<double>(now - m_last_refill) * m_rate / 1000000.0);
+    m_last_refill = now;
+
+    if (m_tokens < 1.0)
+    {
+      log_warn("exec rate limit exceeded, dropping: " << request.c_str());
+      return false;
+    }
+    else
+    {
+      m_tokens -= 1.0;
+    }
+  }
+
+  spawn(request);
+  return true;
+}
+
+void
+SpawnService::run_helper(int fd)
+{
+  // close everything that got inherited from the daemon, so that the
+  // helper and the programs it launches don't keep devices open
+  std::vector<int> fds;
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir)
+  {
+    while(struct dirent* entry = readdir(dir))
+    {
+      int i = atoi(entry->d_name);
+      if (i > STDERR_FILENO && i != fd && i != dirfd(dir))
+      {
+        fds.push_back(i);
+      }
+    }
+    closedir(dir);
+  }
+  for(std::vector<int>::iterator i = fds.begin(); i != fds.end(); ++i)
+  {
+    close(*i);
+  }
+
+  signal(SIGINT,  SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+
+  // launched programs are reaped automatically
+  signal(SIGCHLD, SIG_IGN);
+
+  // but get the default back, as well as an empty signal mask
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  sigset_t sigdefault;
+  sigemptyset(&sigdefault);
+  sigaddset(&sigdefault, SIGCHLD);
+  posix_spawnattr_setsigdefault(&attr, &sigdefault);
+  sigset_t sigmask;
+  sigemptyset(&sigmask);
+  posix_spawnattr_setsigmask(&attr, &sigmask);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+
+  std::vector<char> buf(65536);
+  std::vector<char*> argv;
+
+  while(true)
+  {
+    ssize_t len = recv(fd, &buf[0], buf.size() - 1, 0);
+    if (len == 0)
+    {
+      // daemon is gone
+      _exit(EXIT_SUCCESS);
+    }
+    else if (len < 0)
+    {
+      if (errno != EINTR)
+      {
+        _exit(EXIT_FAILURE);
+      }
+    }
+    else
+    {
+      buf[len] = '\0';
+
+      argv.clear();
+      for(char* p = &buf[0]; p < &buf[0] + len; p += strlen(p) + 1)
+      {
+        argv.push_back(p);
+      }
+      argv.push_back(NULL);
+
+      pid_t pid;
+      int ret = posix_spawnp(&pid, argv[0], NULL, &attr, &argv[0], environ);
+      if (ret != 0)
+      {
+        log_error(argv[0] << ": exec failed: " << strerror(ret));
+      }
+    }
+  }
+}
+
+/* EOF */
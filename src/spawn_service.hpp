@@ -0,0 +1,93 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_SPAWN_SERVICE_HPP
+#define HEADER_XBOXDRV_SPAWN_SERVICE_HPP
+
+#include <glib.h>
+#include <map>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/** Launches external programs from a small helper process that is
+    forked once at startup, so the daemon itself, with all its USB
+    state and file descriptors, never has to fork() again. Requests
+    are sent over a socketpair and the helper uses posix_spawn(). */
+class SpawnService
+{
+private:
+  /** our end of the socketpair, -1 when the helper isn't running */
+  int m_fd;
+  pid_t m_pid;
+
+  /** limits for spawn_limited(): requests per second and the time in
+      msec in which the same request is only launched once */
+  int m_rate;
+  int m_debounce;
+
+  double m_tokens;
+  gint64 m_last_refill;
+
+  typedef std::map<std::string, gint64> LastSpawn;
+  LastSpawn m_last_spawn;
+
+public:
+  /** Turns \a args into a request, requests can be created once and
+      sent many times */
+  static std::string encode(const std::vector<std::string>& args);
+
+public:
+  SpawnService();
+  ~SpawnService();
+
+  /** Fork the helper, has to be called as early as possible, as the
+      helper is a copy of the process at this point. Without a helper,
+      either because this wasn't called or because it died, spawn()
+      falls back to posix_spawn() from the daemon itself. */
+  void start();
+  void stop();
+
+  void set_rate_limit(int requests_per_second);
+  void set_debounce(int msec);
+
+  /** Launch a request unconditionally, for things like the connect
+      scripts */
+  void spawn(const std::string& request);
+
+  /** Launch a request triggered by user input, it is dropped when it
+      exceeds the rate limit or repeats within the debounce time,
+      returns false in that case */
+  bool spawn_limited(const std::string& request);
+
+private:
+  static void run_helper(int fd);
+  static void spawn_direct(const std::string& request);
+  static void on_child_exit(GPid pid, gint status, gpointer data);
+
+private:
+  SpawnService(const SpawnService&);
+  SpawnService& operator=(const SpawnService&);
+};
+
+extern SpawnService g_spawn_service;
+
+#endif
+
+/* EOF */
@@ -0,0 +1,164 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "state_publisher.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "log.hpp"
+#include "raise_exception.hpp"
+
+StatePublisher g_state_publisher;
+
+StatePublisher::StatePublisher() :
+  m_name(),
+  m_data(0),
+  m_size(0),
+  m_header(0),
+  m_slots(0),
+  m_slot_count(0)
+{
+}
+
+StatePublisher::~StatePublisher()
+{
+  close();
+}
+
+void
+StatePublisher::open(const std::string& name, int slot_count)
+{
+  close();
+
+  m_name = (!name.empty() && name[0] == '/') ? name : "/" + name;
+
+  int fd = shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    raise_exception(std::runtime_error, "shm_open(" << m_name << ") failed: " << strerror(errno));
+  }
+
+  // keep the slots cache line aligned
+  size_t slot_offset = (sizeof(XboxdrvStateHeader) + 63) & ~static_cast<size_t>(63);
+  m_size = slot_offset + sizeof(XboxdrvStateSlot) * slot_count;
+
+  if (ftruncate(fd, m_size) < 0)
+  {
+    int err = errno;
+    ::close(fd);
+    shm_unlink(m_name.c_str());
+    raise_exception(std::runtime_error, "ftruncate(" << m_name << ") failed: " << strerror(err));
+  }
+
+  m_data = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (m_data == MAP_FAILED)
+  {
+    int err = errno;
+    m_data = 0;
+    shm_unlink(m_name.c_str());
+    raise_exception(std::runtime_error, "mmap(" << m_name << ") failed: " << strerror(err));
+  }
+
+  // the segment is zero filled by ftruncate(), so all slots start
+  // with an even sequence number and no controller
+  m_header = static_cast<XboxdrvStateHeader*>(m_data);
+  m_slots  = reinterpret_cast<XboxdrvStateSlot*>(static_cast<char*>(m_data) + slot_offset);
+  m_slot_count = slot_count;
+
+  m_header->version     = XBOXDRV_STATE_VERSION;
+  m_header->slot_count  = slot_count;
+  m_header->slot_size   = sizeof(XboxdrvStateSlot);
+  m_header->slot_offset = slot_offset;
+
+  // the magic goes last, readers can use it to tell that the header is complete
+  __sync_synchronize();
+  memcpy(m_header->magic, "xboxdrv", 8);
+
+  log_info("publishing controller state in " << m_name << " (" << slot_count << " slots)");
+}
+
+void
+StatePublisher::close()
+{
+  if (m_data)
+  {
+    munmap(m_data, m_size);
+    shm_unlink(m_name.c_str());
+
+    m_data = 0;
+    m_size = 0;
+    m_header = 0;
+    m_slots = 0;
+    m_slot_count = 0;
+  }
+}
+
+void
+StatePublisher::publish(int slot, const XboxGenericMsg& raw, const XboxGenericMsg& mapped, int64_t usec_time)
+{
+  if (0 <= slot && slot < m_slot_count)
+  {
+    XboxdrvStateSlot& s = m_slots[slot];
+    uint32_t seq = s.seq;
+
+    s.seq = seq + 1;
+    __sync_synchronize();
+
+    s.frame += 1;
+    s.usec_time = usec_time;
+    s.raw = raw;
+    s.mapped = mapped;
+
+    __sync_synchronize();
+    s.seq = seq + 2;
+  }
+}
+
+void
+StatePublisher::set_connected(int slot, bool connected)
+{
+  if (0 <= slot && slot < m_slot_count)
+  {
+    XboxdrvStateSlot& s = m_slots[slot];
+    uint32_t seq = s.seq;
+
+    s.seq = seq + 1;
+    __sync_synchronize();
+
+    s.connected = connected;
+    if (!connected)
+    {
+      memset(&s.raw, 0, sizeof(s.raw));
+      memset(&s.mapped, 0, sizeof(s.mapped));
+    }
+
+    __sync_synchronize();
+    s.seq = seq + 2;
+  }
+}
+
+/* EOF */
@@ -0,0 +1,111 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_STATE_PUBLISHER_HPP
+#define HEADER_XBOXDRV_STATE_PUBLISHER_HPP
+
+#include <stdint.h>
+#include <string>
+
+#include "xboxmsg.hpp"
+
+/**
+    Layout of the shared memory segment created by --state-shm, a
+    header followed by slot_count slots of slot_size bytes each.
+
+    Each slot is protected by a sequence lock, a reader copies the
+    slot and retries if the sequence number was odd or changed while
+    copying:
+
+      do {
+        seq = slot->seq; barrier();
+        copy = *slot;    barrier();
+      } while ((seq & 1) || seq != slot->seq);
+ */
+struct XboxdrvStateHeader
+{
+  char     magic[8];    ///< "xboxdrv\0"
+  uint32_t version;     ///< XBOXDRV_STATE_VERSION
+  uint32_t slot_count;
+  uint32_t slot_size;   ///< sizeof(XboxdrvStateSlot)
+  uint32_t slot_offset; ///< offset of the first slot from the start of the segment
+};
+
+/** Slots are padded to a multiple of the cache line size, so that
+    writing one slot doesn't invalidate the line its neighbour sits in */
+struct XboxdrvStateSlot
+{
+  volatile uint32_t seq;
+  uint32_t connected;
+
+  /** number of messages processed for this slot */
+  uint64_t frame;
+
+  /** time of the last message in usec, from CLOCK_MONOTONIC */
+  int64_t usec_time;
+
+  /** the message as it came from the controller */
+  XboxGenericMsg raw;
+
+  /** the message after all modifiers were applied */
+  XboxGenericMsg mapped;
+} __attribute__((__aligned__(64)));
+
+enum { XBOXDRV_STATE_VERSION = 1 };
+
+/**
+    Publishes the controller state of each slot into a shared memory
+    segment, so that overlays and other tools can read it without
+    going through the driver.
+ */
+class StatePublisher
+{
+private:
+  std::string m_name;
+  void* m_data;
+  size_t m_size;
+
+  XboxdrvStateHeader* m_header;
+  XboxdrvStateSlot* m_slots;
+  int m_slot_count;
+
+public:
+  StatePublisher();
+  ~StatePublisher();
+
+  /** Create the segment \a name (as for shm_open()) with room for
+      \a slot_count slots, an already existing segment is replaced */
+  void open(const std::string& name, int slot_count);
+  void close();
+
+  bool is_open() const { return m_slots != 0; }
+
+  void publish(int slot, const XboxGenericMsg& raw, const XboxGenericMsg& mapped, int64_t usec_time);
+  void set_connected(int slot, bool connected);
+
+private:
+  StatePublisher(const StatePublisher&);
+  StatePublisher& operator=(const StatePublisher&);
+};
+
+extern StatePublisher g_state_publisher;
+
+#endif
+
+/* EOF */
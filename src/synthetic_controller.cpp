@@ -0,0 +1,345 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "synthetic_controller.hpp"
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <math.h>
+#include <stdexcept>
+#include <string.h>
+
+#include "controller_factory.hpp"
+#include "helper.hpp"
+#include "log.hpp"
+#include "options.hpp"
+#include "raise_exception.hpp"
+#include "usb_controller.hpp"
+
+namespace {
+
+/** the buttons the pattern presses one after the other */
+const XboxButton pattern_buttons[] = {
+  XBOX_BTN_A, XBOX_BTN_B, XBOX_BTN_X, XBOX_BTN_Y,
+  XBOX_BTN_LB, XBOX_BTN_RB,
+  XBOX_BTN_START, XBOX_BTN_BACK,
+  XBOX_BTN_THUMB_L, XBOX_BTN_THUMB_R,
+  XBOX_DPAD_UP, XBOX_DPAD_DOWN, XBOX_DPAD_LEFT, XBOX_DPAD_RIGHT
+};
+const int pattern_buttons_count = sizeof(pattern_buttons) / sizeof(pattern_buttons[0]);
+
+const XboxAxis pattern_axes[] = {
+  XBOX_AXIS_X1, XBOX_AXIS_Y1, XBOX_AXIS_X2, XBOX_AXIS_Y2, XBOX_AXIS_LT, XBOX_AXIS_RT
+};
+const int pattern_axes_count = sizeof(pattern_axes) / sizeof(pattern_axes[0]);
+
+/** reports that are generated at most in one go when the main loop
+    fell behind, the rest is dropped */
+const int kMaxBurst = 16;
+
+void write_int16le(uint8_t* data, int value)
+{
+  data[0] = static_cast<uint8_t>(value & 0xff);
+  data[1] = static_cast<uint8_t>((value >> 8) & 0xff);
+}
+
+#define bitswap(x) x = ((x & 0x00ff) << 8) | ((x & 0xff00) >> 8)
+
+} // namespace
+
+SyntheticController::SyntheticController(GamepadType type, int id, int rate, bool random,
+                                         const Options& opts) :
+  m_dev_type(),
+  m_id(id),
+  m_rate(rate),
+  m_random(random),
+  m_controller(),
+  m_usb_controller(0),
+  m_msg(),
+  m_rng(static_cast<uint32_t>(id + 1) * 2654435761u),
+  m_frame(0),
+  m_next_time(0),
+  m_source_id(0)
+{
+  if (m_rate < 1 || m_rate > 8000)
+  {
+    raise_exception(std::runtime_error, "synthetic controller rate must be between 1 and 8000: " << m_rate);
+  }
+
+  memset(&m_msg, 0, sizeof(m_msg));
+  switch(type)
+  {
+    case GAMEPAD_XBOX360:
+      m_msg.type = XBOX_MSG_XBOX360;
+      m_msg.xbox360.length = 0x14;
+      break;
+
+    case GAMEPAD_XBOX:
+      m_msg.type = XBOX_MSG_XBOX;
+      m_msg.xbox.length = 0x14;
+      break;
+
+    case GAMEPAD_PLAYSTATION3_USB:
+      m_msg.type = XBOX_MSG_PS3USB;
+      m_msg.ps3usb.unknown00 = 0x01;
+      break;
+
+    default:
+      raise_exception(std::runtime_error, "synthetic controllers can only be xbox360, xbox or playstation3-usb, not "
+                      << gamepadtype_to_string(type));
+  }
+
+  // borrow vendor:product from a real device of the type
+  m_dev_type.type = type;
+  m_dev_type.name = "Synthetic Controller";
+  const std::vector<XPadDevice>& devices = get_xpad_devices();
+  for(std::vector<XPadDevice>::const_iterator i = devices.begin(); i != devices.end(); ++i)
+  {
+    if (i->type == type)
+    {
+      m_dev_type.idVendor  = i->idVendor;
+      m_dev_type.idProduct = i->idProduct;
+      break;
+    }
+  }
+
+  // the chatpad and headset talk to the device directly, so they
+  // can't be used without one
+  Options offline_opts = opts;
+  offline_opts.chatpad = false;
+  offline_opts.headset = false;
+
+  m_controller = ControllerFactory::create(m_dev_type, 0, offline_opts);
+  m_usb_controller = dynamic_cast<USBController*>(m_controller.get());
+  assert(m_usb_controller);
+
+  m_is_active = m_controller->is_active();
+  m_controller->set_message_cb(boost::bind(&SyntheticController::submit_msg, this, _1));
+  m_controller->set_activation_cb(boost::bind(&SyntheticController::on_activation, this));
+
+  m_next_time = g_get_monotonic_time();
+  m_source_id = g_timeout_add_full(G_PRIORITY_HIGH, std::max(1, 1000 / m_rate),
+                                   &SyntheticController::on_timeout_wrap, this, NULL);
+
+  log_info("synthetic controller " << m_id << " (" << gamepadtype_to_string(type) << ") at "
+           << m_rate << " Hz" << (m_random ? ", random input" : ""));
+}
+
+SyntheticController::~SyntheticController()
+{
+  if (m_source_id)
+  {
+    g_source_remove(m_source_id);
+  }
+}
+
+bool
+SyntheticController::on_timeout()
+{
+  gint64 now = g_get_monotonic_time();
+
+  int count = 0;
+  while(m_next_time <= now && count < kMaxBurst)
+  {
+    if (m_random)
+    {
+      update_random();
+    }
+    else
+    {
+      update_pattern();
+    }
+
+    uint8_t data[64];
+    int len = encode(data);
+    m_usb_controller->inject_report(data, len);
+
+    m_frame += 1;
+    m_next_time += 1000000 / m_rate;
+    count += 1;
+  }
+
+  if (m_next_time <= now)
+  {
+    // too far behind, don't try to catch up
+    m_next_time = now + 1000000 / m_rate;
+  }
+
+  return true;
+}
+
+void
+SyntheticController::update_pattern()
+{
+  // sticks go in circles, the triggers are pulled in turn and the
+  // buttons are pressed one after the other for 1/4 second each
+  float t = static_cast<float>(m_frame) / static_cast<float>(m_rate);
+  float phase = 2.0f * static_cast<float>(M_PI) * t;
+
+  set_axis_float(m_msg, XBOX_AXIS_X1, sinf(phase * 0.5f));
+  set_axis_float(m_msg, XBOX_AXIS_Y1, cosf(phase * 0.5f));
+  set_axis_float(m_msg, XBOX_AXIS_X2, sinf(phase * 0.25f));
+  set_axis_float(m_msg, XBOX_AXIS_Y2, -cosf(phase * 0.25f));
+  set_axis_float(m_msg, XBOX_AXIS_LT, sinf(phase));
+  set_axis_float(m_msg, XBOX_AXIS_RT, -sinf(phase));
+
+  int current = static_cast<int>(t * 4.0f) % pattern_buttons_count;
+  for(int i = 0; i < pattern_buttons_count; ++i)
+  {
+    set_button(m_msg, pattern_buttons[i], i == current);
+  }
+}
+
+void
+SyntheticController::update_random()
+{
+  for(int i = 0; i < pattern_axes_count; ++i)
+  {
+    float value = get_axis_float(m_msg, pattern_axes[i]) + random_float() * 0.05f;
+    set_axis_float(m_msg, pattern_axes[i], Math::clamp(-1.0f, value, 1.0f));
+  }
+
+  // change a button about every 32 reports
+  uint32_t r = next_random();
+  if ((r & 31) == 0)
+  {
+    XboxButton button = pattern_buttons[(r >> 5) % pattern_buttons_count];
+    set_button(m_msg, button, !get_button(m_msg, button));
+  }
+}
+
+uint32_t
+SyntheticController::next_random()
+{
+  // xorshift32, m_rng is never 0
+  m_rng ^= m_rng << 13;
+  m_rng ^= m_rng >> 17;
+  m_rng ^= m_rng << 5;
+  return m_rng;
+}
+
+float
+SyntheticController::random_float()
+{
+  return static_cast<float>(next_random()) / 4294967295.0f * 2.0f - 1.0f;
+}
+
+int
+SyntheticController::encode(uint8_t* data) const
+{
+  switch(m_msg.type)
+  {
+    case XBOX_MSG_XBOX360:
+      {
+        // the inverse of Xbox360Controller::parse()
+        const Xbox360Msg& msg = m_msg.xbox360;
+        memset(data, 0, 20);
+
+        data[0] = 0x00;
+        data[1] = 0x14;
+
+        data[2] = static_cast<uint8_t>((msg.dpad_up    << 0) |
+                                       (msg.dpad_down  << 1) |
+                                       (msg.dpad_left  << 2) |
+                                       (msg.dpad_right << 3) |
+                                       (msg.start      << 4) |
+                                       (msg.back       << 5) |
+                                       (msg.thumb_l    << 6) |
+                                       (msg.thumb_r    << 7));
+
+        data[3] = static_cast<uint8_t>((msg.lb    << 0) |
+                                       (msg.rb    << 1) |
+                                       (msg.guide << 2) |
+                                       (msg.a     << 4) |
+                                       (msg.b     << 5) |
+                                       (msg.x     << 6) |
+                                       (msg.y     << 7));
+
+        data[4] = static_cast<uint8_t>(msg.lt);
+        data[5] = static_cast<uint8_t>(msg.rt);
+
+        write_int16le(data+6,  msg.x1);
+        write_int16le(data+8,  msg.y1);
+        write_int16le(data+10, msg.x2);
+        write_int16le(data+12, msg.y2);
+        return 20;
+      }
+
+    case XBOX_MSG_XBOX:
+      // XboxController::parse() takes the report as is
+      memcpy(data, &m_msg.xbox, sizeof(m_msg.xbox));
+      return sizeof(m_msg.xbox);
+
+    case XBOX_MSG_PS3USB:
+      {
+        // Playstation3USBController::parse() swaps the bytes of the
+        // motion sensors, so swap them back
+        Playstation3USBMsg msg = m_msg.ps3usb;
+        bitswap(msg.accl_x);
+        bitswap(msg.accl_y);
+        bitswap(msg.accl_z);
+        bitswap(msg.rot_z);
+
+        memcpy(data, &msg, sizeof(msg));
+        return sizeof(msg);
+      }
+
+    default:
+      assert(!"never reached");
+      return 0;
+  }
+}
+
+void
+SyntheticController::on_activation()
+{
+  set_active(m_controller->is_active());
+}
+
+void
+SyntheticController::set_rumble_real(uint8_t left, uint8_t right)
+{
+  m_controller->set_rumble_real(left, right);
+}
+
+void
+SyntheticController::set_led_real(uint8_t status)
+{
+  m_controller->set_led_real(status);
+}
+
+std::string
+SyntheticController::get_usbpath() const
+{
+  return (boost::format("000:%03d") % (m_id + 1)).str();
+}
+
+std::string
+SyntheticController::get_usbid() const
+{
+  return (boost::format("%04x:%04x") % m_dev_type.idVendor % m_dev_type.idProduct).str();
+}
+
+std::string
+SyntheticController::get_name() const
+{
+  return m_dev_type.name;
+}
+
+/* EOF */
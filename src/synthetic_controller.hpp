@@ -0,0 +1,100 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_SYNTHETIC_CONTROLLER_HPP
+#define HEADER_XBOXDRV_SYNTHETIC_CONTROLLER_HPP
+
+#include <glib.h>
+
+#include "controller.hpp"
+#include "controller_ptr.hpp"
+#include "xpad_device.hpp"
+
+class Options;
+class USBController;
+
+/**
+    A controller without hardware, it generates reports in the native
+    format of an Xbox360, Xbox or Playstation 3 controller at a fixed
+    rate and feeds them through the parse() of an offline controller
+    of that type, so they take the same path as reports from real
+    hardware. Meant for testing and measuring with many controllers.
+
+    The input either follows a fixed pattern of sweeping sticks and
+    triggers and cycling buttons, or is a random walk, both are
+    reproducible for a given \a id.
+ */
+class SyntheticController : public Controller
+{
+private:
+  XPadDevice m_dev_type;
+  int m_id;
+  int m_rate;
+  bool m_random;
+
+  ControllerPtr m_controller;
+  USBController* m_usb_controller;
+
+  /** the state that goes into the next report */
+  XboxGenericMsg m_msg;
+  uint32_t m_rng;
+  uint64_t m_frame;
+
+  /** time at which the next report is due */
+  gint64 m_next_time;
+  guint m_source_id;
+
+public:
+  SyntheticController(GamepadType type, int id, int rate, bool random, const Options& opts);
+  ~SyntheticController();
+
+  void set_rumble_real(uint8_t left, uint8_t right);
+  void set_led_real(uint8_t status);
+
+  std::string get_usbpath() const;
+  std::string get_usbid() const;
+  std::string get_name() const;
+
+  const XPadDevice& get_dev_type() const { return m_dev_type; }
+
+private:
+  void update_pattern();
+  void update_random();
+  uint32_t next_random();
+  float random_float();
+
+  /** Write the current state as a native report, returns its length */
+  int encode(uint8_t* data) const;
+
+  void on_activation();
+
+  bool on_timeout();
+  static gboolean on_timeout_wrap(gpointer data)
+  {
+    return static_cast<SyntheticController*>(data)->on_timeout();
+  }
+
+private:
+  SyntheticController(const SyntheticController&);
+  SyntheticController& operator=(const SyntheticController&);
+};
+
+#endif
+
+/* EOF */
@@ -18,10 +18,10 @@
 
 #include "ui_abs_event_collector.hpp"
 
-#include "uinput.hpp"
+#include "linux_uinput.hpp"
 
-UIAbsEventCollector::UIAbsEventCollector(UInput& uinput, uint32_t device_id, int type, int code) :
-  UIEventCollector(uinput, device_id, type, code),
+UIAbsEventCollector::UIAbsEventCollector(LinuxUinput& dev, uint32_t device_id, int type, int code) :
+  UIEventCollector(dev, device_id, type, code),
   m_emitters()
 {
 }
@@ -37,12 +37,7 @@ UIAbsEventCollector::create_emitter()
 void
 UIAbsEventCollector::send(int value)
 {
-  m_uinput.send(get_device_id(), get_type(), get_code(), value);
-}
-
-void
-UIAbsEventCollector::sync()
-{
+  m_dev.send(get_type(), get_code(), value);
 }
 
 /* EOF */
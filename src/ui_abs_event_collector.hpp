@@ -29,11 +29,10 @@ private:
   Emitters m_emitters;
 
 public:
-  UIAbsEventCollector(UInput& uinput, uint32_t device_id, int type, int code);
+  UIAbsEventCollector(LinuxUinput& dev, uint32_t device_id, int type, int code);
 
   UIEventEmitterPtr create_emitter();
   void send(int value);
-  void sync();
 
 private:
   UIAbsEventCollector(const UIAbsEventCollector&);
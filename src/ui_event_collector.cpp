@@ -21,13 +21,13 @@
 #include <assert.h>
 
 #include "log.hpp"
-#include "uinput.hpp"
+#include "linux_uinput.hpp"
 
-UIEventCollector::UIEventCollector(UInput& uinput,
+UIEventCollector::UIEventCollector(LinuxUinput& dev,
                                uint32_t device_id,
                                int type,
                                int code) :
-  m_uinput(uinput),
+  m_dev(dev),
   m_device_id(device_id),
   m_type(type),
   m_code(code)
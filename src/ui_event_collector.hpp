@@ -25,21 +25,23 @@
 
 #include "ui_event_emitter.hpp"
 
+class LinuxUinput;
 class UIEventCollector;
-class UInput;
 
 typedef boost::shared_ptr<UIEventCollector> UIEventCollectorPtr;
 
 class UIEventCollector
 {
 protected:
-  UInput& m_uinput;
+  /** the device is resolved when the collector is created, so
+      sending an event needs no lookup */
+  LinuxUinput& m_dev;
   uint32_t m_device_id;
   int m_type;
   int m_code;
 
 public:
-  UIEventCollector(UInput& uinput, uint32_t device_id, int type, int code);
+  UIEventCollector(LinuxUinput& dev, uint32_t device_id, int type, int code);
   virtual ~UIEventCollector();
 
   uint32_t get_device_id() const { return m_device_id; }
@@ -47,7 +49,6 @@ public:
   int      get_code() const { return m_code; }
 
   virtual UIEventEmitterPtr create_emitter() = 0;
-  virtual void sync() = 0;
 
 private:
   UIEventCollector(const UIEventCollector&);
@@ -19,10 +19,10 @@
 #include "ui_key_event_collector.hpp"
 
 #include "log.hpp"
-#include "uinput.hpp"
+#include "linux_uinput.hpp"
 
-UIKeyEventCollector::UIKeyEventCollector(UInput& uinput, uint32_t device_id, int type, int code) :
-  UIEventCollector(uinput, device_id, type, code),
+UIKeyEventCollector::UIKeyEventCollector(LinuxUinput& dev, uint32_t device_id, int type, int code) :
+  UIEventCollector(dev, device_id, type, code),
   m_emitters(),
   m_value(0)
 {
@@ -52,7 +52,7 @@ UIKeyEventCollector::send(int value)
 
     if (m_value == 1)
     {
-      m_uinput.send(get_device_id(), get_type(), get_code(), m_value);
+      m_dev.send(get_type(), get_code(), m_value);
     }
   }
   else
@@ -66,14 +66,9 @@ UIKeyEventCollector::send(int value)
 
     if (m_value == 0)
     {
-      m_uinput.send(get_device_id(), get_type(), get_code(), 0);
+      m_dev.send(get_type(), get_code(), 0);
     }
   }
 }
 
-void
-UIKeyEventCollector::sync()
-{
-}
-
 /* EOF */
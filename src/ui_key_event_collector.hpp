@@ -33,11 +33,10 @@ private:
   int m_value;
 
 public:
-  UIKeyEventCollector(UInput& uinput, uint32_t device_id, int type, int code);
+  UIKeyEventCollector(LinuxUinput& dev, uint32_t device_id, int type, int code);
 
   UIEventEmitterPtr create_emitter();
   void send(int value);
-  void sync();
 
 private:
   UIKeyEventCollector(const UIKeyEventCollector&);
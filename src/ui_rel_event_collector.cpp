@@ -18,10 +18,10 @@
 
 #include "ui_rel_event_collector.hpp"
 
-#include "uinput.hpp"
+#include "linux_uinput.hpp"
 
-UIRelEventCollector::UIRelEventCollector(UInput& uinput, uint32_t device_id, int type, int code) :
-  UIEventCollector(uinput, device_id, type, code),
+UIRelEventCollector::UIRelEventCollector(LinuxUinput& dev, uint32_t device_id, int type, int code) :
+  UIEventCollector(dev, device_id, type, code),
   m_emitters()
 {
 }
@@ -37,12 +37,13 @@ UIRelEventCollector::create_emitter()
 void
 UIRelEventCollector::send(int value)
 {
-  m_uinput.send(get_device_id(), get_type(), get_code(), value);
+  m_dev.send_rel(get_code(), value);
 }
 
 void
-UIRelEventCollector::sync()
+UIRelEventCollector::add_velocity(float delta)
 {
+  m_dev.add_rel_velocity(get_code(), delta);
 }
 
 /* EOF */
@@ -29,11 +29,11 @@ private:
   Emitters m_emitters;
 
 public:
-  UIRelEventCollector(UInput& uinput, uint32_t device_id, int type, int code);
+  UIRelEventCollector(LinuxUinput& dev, uint32_t device_id, int type, int code);
 
   UIEventEmitterPtr create_emitter();
   void send(int value);
-  void sync();
+  void add_velocity(float delta);
 
 private:
   UIRelEventCollector(const UIRelEventCollector&);
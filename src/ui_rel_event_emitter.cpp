@@ -21,7 +21,8 @@
 #include "ui_rel_event_collector.hpp"
 
 UIRelEventEmitter::UIRelEventEmitter(UIRelEventCollector& collector) :
-  m_collector(collector)
+  m_collector(collector),
+  m_velocity(0.0f)
 {
 }
 
@@ -31,4 +32,14 @@ UIRelEventEmitter::send(int value)
   m_collector.send(value);
 }
 
+void
+UIRelEventEmitter::set_velocity(float velocity)
+{
+  if (m_velocity != velocity)
+  {
+    m_collector.add_velocity(velocity - m_velocity);
+    m_velocity = velocity;
+  }
+}
+
 /* EOF */
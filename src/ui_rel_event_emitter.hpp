@@ -27,12 +27,17 @@ class UIRelEventEmitter : public UIEventEmitter
 {
 private:
   UIRelEventCollector& m_collector;
+  float m_velocity;
 
 public:
   UIRelEventEmitter(UIRelEventCollector& collector);
 
   void send(int value);
 
+  /** Move continuously by \a velocity units per second, the motion
+      is sent out at the output rate of the device */
+  void set_velocity(float velocity);
+
 private:
   UIRelEventEmitter(const UIRelEventEmitter&);
   UIRelEventEmitter& operator=(const UIRelEventEmitter&);
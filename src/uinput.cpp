@@ -19,10 +19,14 @@
 #include "uinput.hpp"
 
 #include <boost/tokenizer.hpp>
+#include <errno.h>
 #include <iostream>
 #include <math.h>
 #include <stdexcept>
 #include <stdio.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 #include "ui_abs_event_collector.hpp"
 #include "ui_key_event_collector.hpp"
@@ -107,29 +111,83 @@ UInput::UInput(bool extra_events) :
   m_uinput_devs(),
   m_device_names(),
   m_device_usbids(),
+  m_dirty_devs(0),
   m_collectors(),
   m_rel_repeat_lst(),
   m_extra_events(extra_events),
+  m_wheel_hi_res(false),
+  m_backend_type(UInputBackend::kKernel),
+  m_timer_fd(-1),
+  m_timer_channel(),
   m_timeout_id(),
-  m_timer(g_timer_new())
+  m_last_update(g_get_monotonic_time())
 {
-  // FIXME: hardcoded timeout is kind of evil
   // FIXME: would be nicer if UInput didn't depend on glib
-  m_timeout_id = g_timeout_add(10, &UInput::on_timeout_wrap, this);
+  m_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (m_timer_fd < 0)
+  {
+    raise_exception(std::runtime_error, "timerfd_create() failed: " << strerror(errno));
+  }
+
+  set_rel_rate(100);
+
+  m_timer_channel = g_io_channel_unix_new(m_timer_fd);
+  m_timeout_id = g_io_add_watch(m_timer_channel, G_IO_IN, &UInput::on_timeout_wrap, this);
 }
 
 UInput::~UInput()
 {
   g_source_remove(m_timeout_id);
-  g_timer_destroy(m_timer);
+  g_io_channel_unref(m_timer_channel);
+  close(m_timer_fd);
+}
+
+void
+UInput::set_rel_rate(int rate)
+{
+  if (rate < 60 || rate > 1000)
+  {
+    raise_exception(std::runtime_error, "rel rate must be between 60 and 1000: " << rate);
+  }
+  else
+  {
+    struct itimerspec spec;
+    spec.it_interval.tv_sec  = 0;
+    spec.it_interval.tv_nsec = 1000000000L / rate;
+    spec.it_value = spec.it_interval;
+
+    if (timerfd_settime(m_timer_fd, 0, &spec, NULL) < 0)
+    {
+      raise_exception(std::runtime_error, "timerfd_settime() failed: " << strerror(errno));
+    }
+  }
 }
 
 bool
 UInput::on_timeout()
 {
-  int msec_delta = static_cast<int>(g_timer_elapsed(m_timer, NULL) * 1000.0f);
-  g_timer_reset(m_timer);
-  update(msec_delta);
+  // drain the timer, ticks that got missed are covered by the
+  // elapsed time below
+  uint64_t expirations;
+  if (read(m_timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+  {
+    log_error("failed to read timerfd: " << strerror(errno));
+  }
+
+  gint64 now = g_get_monotonic_time();
+  int usec_delta = static_cast<int>(now - m_last_update);
+  m_last_update = now;
+
+  // continuous motion is integrated with the real elapsed time
+  for(UInputDevs::iterator i = m_uinput_devs.begin(); i != m_uinput_devs.end(); ++i)
+  {
+    i->second->update_motion(static_cast<double>(usec_delta) / 1000000.0);
+  }
+
+  update(usec_delta);
+
+  sync();
+
   return true;  // do not remove the callback
 }
 
@@ -314,7 +372,10 @@ UInput::create_uinput_device(uint32_t device_id)
     }
 
     std::string dev_name = get_device_name(device_id);
-    boost::shared_ptr<LinuxUinput> dev(new LinuxUinput(device_type, dev_name, get_device_usbid(device_id)));
+    boost::shared_ptr<LinuxUinput> dev(new LinuxUinput(device_type, dev_name, get_device_usbid(device_id),
+                                                       m_backend_type));
+    dev->set_dirty_list(&m_dirty_devs);
+    dev->set_wheel_hi_res(m_wheel_hi_res);
     m_uinput_devs.insert(std::pair<int, boost::shared_ptr<LinuxUinput> >(device_id, dev));
 
     log_debug("created uinput device: " << device_id << " - '" << dev_name << "'");
@@ -329,16 +390,16 @@ UInput::add_key(uint32_t device_id, int ev_code)
   LinuxUinput* dev = create_uinput_device(device_id);
   dev->add_key(ev_code);
 
-  return create_emitter(device_id, EV_KEY, ev_code);
+  return create_emitter(*dev, device_id, EV_KEY, ev_code);
 }
 
-UIEventEmitterPtr
+UIRelEventEmitterPtr
 UInput::add_rel(uint32_t device_id, int ev_code)
 {
   LinuxUinput* dev = create_uinput_device(device_id);
   dev->add_rel(ev_code);
 
-  return create_emitter(device_id, EV_REL, ev_code);
+  return boost::static_pointer_cast<UIRelEventEmitter>(create_emitter(*dev, device_id, EV_REL, ev_code));
 }
 
 UIEventEmitterPtr
@@ -347,7 +408,7 @@ UInput::add_abs(uint32_t device_id, int ev_code, int min, int max, int fuzz, int
   LinuxUinput* dev = create_uinput_device(device_id);
   dev->add_abs(ev_code, min, max, fuzz, flat);
 
-  return create_emitter(device_id, EV_ABS, ev_code);
+  return create_emitter(*dev, device_id, EV_ABS, ev_code);
 }
 
 void
@@ -358,7 +419,15 @@ UInput::add_ff(uint32_t device_id, uint16_t code)
 }
 
 UIEventEmitterPtr
-UInput::create_emitter(int device_id, int type, int code)
+UInput::get_abs_emitter(uint32_t device_id, int ev_code)
+{
+  LinuxUinput* dev = create_uinput_device(device_id);
+
+  return create_emitter(*dev, device_id, EV_ABS, ev_code);
+}
+
+UIEventEmitterPtr
+UInput::create_emitter(LinuxUinput& dev, int device_id, int type, int code)
 {
   // search for an already existing emitter
   for(Collectors::iterator i = m_collectors.begin(); i != m_collectors.end(); ++i)
@@ -376,21 +445,21 @@ UInput::create_emitter(int device_id, int type, int code)
   {
     case EV_ABS:
       {
-        UIEventCollectorPtr collector(new UIAbsEventCollector(*this, device_id, type, code));
+        UIEventCollectorPtr collector(new UIAbsEventCollector(dev, device_id, type, code));
         m_collectors.push_back(collector);
         return collector->create_emitter();
       }
 
     case EV_KEY:
       {
-        UIEventCollectorPtr collector(new UIKeyEventCollector(*this, device_id, type, code));
+        UIEventCollectorPtr collector(new UIKeyEventCollector(dev, device_id, type, code));
         m_collectors.push_back(collector);
         return collector->create_emitter();
       }
 
     case EV_REL:
       {
-        UIEventCollectorPtr collector(new UIRelEventCollector(*this, device_id, type, code));
+        UIEventCollectorPtr collector(new UIRelEventCollector(dev, device_id, type, code));
         m_collectors.push_back(collector);
         return collector->create_emitter();
       }
@@ -417,44 +486,41 @@ UInput::send(uint32_t device_id, int ev_type, int ev_code, int value)
 }
 
 void
-UInput::update(int msec_delta)
+UInput::update(int usec_delta)
 {
   for(std::map<UIEvent, RelRepeat>::iterator i = m_rel_repeat_lst.begin(); i != m_rel_repeat_lst.end(); ++i)
   {
-    i->second.time_count += msec_delta;
+    i->second.time_count += usec_delta;
 
-    // FIXME: shouldn't send out events multiple times, but accumulate
-    // them instead and send out only once
-    while (i->second.time_count >= i->second.repeat_interval)
+    // all repeats that fell into this tick are sent as one event, the
+    // device keeps the fractional rest
+    const int64_t repeat_interval = static_cast<int64_t>(i->second.repeat_interval) * 1000;
+    if (repeat_interval > 0 &&
+        i->second.time_count >= repeat_interval)
     {
-      // value can be float, but be can only send out int, so keep
-      // track of the rest we don't send
-      int i_value = static_cast<int>(i->second.value + truncf(i->second.rest));
-      i->second.rest -= truncf(i->second.rest);
-      i->second.rest += i->second.value - truncf(i->second.value);
-
-      get_uinput(i->second.code.get_device_id())->send(EV_REL, i->second.code.code, i_value);
-      i->second.time_count -= i->second.repeat_interval;
+      int count = static_cast<int>(i->second.time_count / repeat_interval);
+      i->second.dev->send_rel(i->second.code.code, i->second.value * count);
+      i->second.time_count -= count * repeat_interval;
     }
   }
 
   for(UInputDevs::iterator i = m_uinput_devs.begin(); i != m_uinput_devs.end(); ++i)
   {
-    i->second->update(msec_delta);
+    i->second->update(usec_delta);
   }
 }
 
 void
 UInput::sync()
 {
-  for(Collectors::iterator i = m_collectors.begin(); i != m_collectors.end(); ++i)
-  {
-    (*i)->sync();
-  }
+  LinuxUinput* dev = m_dirty_devs;
+  m_dirty_devs = 0;
 
-  for(UInputDevs::iterator i = m_uinput_devs.begin(); i != m_uinput_devs.end(); ++i)
+  while(dev)
   {
-    i->second->sync();
+    LinuxUinput* next = dev->get_next_dirty();
+    dev->sync();
+    dev = next;
   }
 }
 
@@ -475,14 +541,14 @@ UInput::send_rel_repetitive(const UIEvent& code, float value, int repeat_interva
     {
       RelRepeat rel_rep;
       rel_rep.code  = code;
+      rel_rep.dev   = get_uinput(code.get_device_id());
       rel_rep.value = value;
-      rel_rep.rest  = 0.0f;
       rel_rep.time_count = 0;
       rel_rep.repeat_interval = repeat_interval;
       m_rel_repeat_lst.insert(std::pair<UIEvent, RelRepeat>(code, rel_rep));
 
       // Send the event once
-      get_uinput(code.get_device_id())->send(EV_REL, code.code, value);
+      rel_rep.dev->send_rel(code.code, value);
     }
     else
     {
@@ -519,6 +585,32 @@ UInput::set_device_usbids(const std::map<uint32_t, struct input_id>& device_usbi
   m_device_usbids = device_usbids;
 }
 
+void
+UInput::set_wheel_hi_res(bool wheel_hi_res)
+{
+  m_wheel_hi_res = wheel_hi_res;
+}
+
+void
+UInput::set_backend(UInputBackend::Type backend_type)
+{
+  m_backend_type = backend_type;
+}
+
+UInputBackend*
+UInput::get_backend(uint32_t device_id) const
+{
+  UInputDevs::const_iterator it = m_uinput_devs.find(device_id);
+  if (it != m_uinput_devs.end())
+  {
+    return &it->second->get_backend();
+  }
+  else
+  {
+    return 0;
+  }
+}
+
 void
 UInput::set_device_names(const std::map<uint32_t, std::string>& device_names)
 {
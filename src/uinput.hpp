@@ -26,6 +26,7 @@
 #include "linux_uinput.hpp"
 #include "ui_event_emitter.hpp"
 #include "ui_event_collector.hpp"
+#include "ui_rel_event_emitter.hpp"
 
 struct Xbox360Msg;
 struct XboxMsg;
@@ -62,24 +63,33 @@ private:
   typedef std::map<uint32_t, struct input_id> DeviceUSBId;
   DeviceUSBId m_device_usbids;
 
+  /** devices that got events since the last sync() */
+  LinuxUinput* m_dirty_devs;
+
   typedef std::vector<UIEventCollectorPtr> Collectors;
   Collectors m_collectors;
 
   struct RelRepeat
   {
     UIEvent code;
+    LinuxUinput* dev;
     float value;
-    float rest;
-    int time_count;
-    int repeat_interval;
+    int64_t time_count;  // usec
+    int repeat_interval; // msec
   };
 
   std::map<UIEvent, RelRepeat> m_rel_repeat_lst;
 
   bool m_extra_events;
+  bool m_wheel_hi_res;
+  UInputBackend::Type m_backend_type;
 
+  /** timerfd that drives the output of relative motion and force
+      feedback at the configured rate */
+  int m_timer_fd;
+  GIOChannel* m_timer_channel;
   guint m_timeout_id;
-  GTimer* m_timer;
+  gint64 m_last_update;
 
 public:
   UInput(bool extra_events);
@@ -93,15 +103,33 @@ public:
 
   void set_device_names(const std::map<uint32_t, std::string>& device_names);
   void set_device_usbids(const std::map<uint32_t, struct input_id>& device_usbids);
+
+  /** send wheel events also as REL_WHEEL_HI_RES/REL_HWHEEL_HI_RES,
+      applies to devices created afterwards */
+  void set_wheel_hi_res(bool wheel_hi_res);
+
+  /** select where the events of devices created afterwards go */
+  void set_backend(UInputBackend::Type backend_type);
+
+  /** The backend of \a device_id, 0 if no such device was created */
+  UInputBackend* get_backend(uint32_t device_id) const;
+
+  /** set how often per second relative motion is sent out, between
+      60 and 1000 */
+  void set_rel_rate(int rate);
   void set_ff_callback(int device_id, const boost::function<void (uint8_t, uint8_t)>& callback);
 
   /** Device construction functions
       @{*/
-  UIEventEmitterPtr add_rel(uint32_t device_id, int ev_code);
+  UIRelEventEmitterPtr add_rel(uint32_t device_id, int ev_code);
   UIEventEmitterPtr add_abs(uint32_t device_id, int ev_code, int min, int max, int fuzz, int flat);
   UIEventEmitterPtr add_key(uint32_t device_id, int ev_code);
   void add_ff(uint32_t device_id, uint16_t code);
 
+  /** emitter for an abs axis that gets declared with add_abs()
+      elsewhere, as its range isn't known here */
+  UIEventEmitterPtr get_abs_emitter(uint32_t device_id, int ev_code);
+
   /** needs to be called to finish device creation and create the
       device in the kernel */
   void finish();
@@ -118,7 +146,7 @@ public:
   /** @} */
 
 private:
-  void update(int msec_delta);
+  void update(int usec_delta);
 
   /** create a LinuxUinput with the given device_id, if some already
       exist return a pointer to it */
@@ -131,11 +159,11 @@ private:
   struct input_id get_device_usbid(uint32_t device_id) const;
 
   bool on_timeout();
-  static gboolean on_timeout_wrap(gpointer data) {
+  static gboolean on_timeout_wrap(GIOChannel* source, GIOCondition condition, gpointer data) {
     return static_cast<UInput*>(data)->on_timeout();
   }
 
-  UIEventEmitterPtr create_emitter(int device_id, int type, int code);
+  UIEventEmitterPtr create_emitter(LinuxUinput& dev, int device_id, int type, int code);
 
 private:
   UInput(const UInput&);
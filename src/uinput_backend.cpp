@@ -0,0 +1,208 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "uinput_backend.hpp"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "log.hpp"
+#include "raise_exception.hpp"
+
+UInputBackend::Type
+UInputBackend::type_from_string(const std::string& str)
+{
+  if (str == "kernel")
+  {
+    return kKernel;
+  }
+  else if (str == "null")
+  {
+    return kNull;
+  }
+  else if (str == "memory")
+  {
+    return kMemory;
+  }
+  else
+  {
+    raise_exception(std::runtime_error, "unknown uinput backend '" << str << "', allowed are kernel, null and memory");
+  }
+}
+
+UInputBackend*
+UInputBackend::create(Type type)
+{
+  switch(type)
+  {
+    case kNull:
+      return new NullUInputBackend;
+
+    case kMemory:
+      return new MemoryUInputBackend;
+
+    case kKernel:
+    default:
+      return new KernelUInputBackend;
+  }
+}
+
+KernelUInputBackend::KernelUInputBackend() :
+  m_fd(-1),
+  m_created(false)
+{
+  // Open the input device
+  const char* uinput_filename[] = { "/dev/input/uinput", "/dev/uinput", "/dev/misc/uinput" };
+  const int uinput_filename_count = (sizeof(uinput_filename)/sizeof(const char*));
+
+  std::ostringstream str;
+  for (int i = 0; i < uinput_filename_count; ++i)
+  {
+    if ((m_fd = open(uinput_filename[i], O_RDWR | O_NDELAY)) >= 0)
+    {
+      break;
+    }
+    else
+    {
+      str << "  " << uinput_filename[i] << ": " << strerror(errno) << std::endl;
+    }
+  }
+
+  if (m_fd < 0)
+  {
+    std::ostringstream out;
+    out << "\nError: No stuitable uinput device found, tried:" << std::endl;
+    out << std::endl;
+    out << str.str();
+    out << "" << std::endl;
+    out << "Troubleshooting:" << std::endl;
+    out << "  * make sure uinput kernel module is loaded " << std::endl;
+    out << "  * make sure joydev kernel module is loaded " << std::endl;
+    out << "  * make sure you have permissions to access the uinput device" << std::endl;
+    out << "  * start the driver with ./xboxdrv -v --no-uinput to see if the driver itself works" << std::endl;
+    out << "" << std::endl;
+
+    throw std::runtime_error(out.str());
+  }
+}
+
+KernelUInputBackend::~KernelUInputBackend()
+{
+  if (m_created)
+  {
+    ioctl(m_fd, UI_DEV_DESTROY);
+  }
+  close(m_fd);
+}
+
+void
+KernelUInputBackend::enable_type(int type)
+{
+  ioctl(m_fd, UI_SET_EVBIT, type);
+}
+
+void
+KernelUInputBackend::enable_code(int type, int code)
+{
+  switch(type)
+  {
+    case EV_ABS: ioctl(m_fd, UI_SET_ABSBIT, code); break;
+    case EV_REL: ioctl(m_fd, UI_SET_RELBIT, code); break;
+    case EV_KEY: ioctl(m_fd, UI_SET_KEYBIT, code); break;
+    case EV_FF:  ioctl(m_fd, UI_SET_FFBIT,  code); break;
+    default: assert(!"unknown event type");
+  }
+}
+
+void
+KernelUInputBackend::create(const uinput_user_dev& user_dev)
+{
+  int write_ret = ::write(m_fd, &user_dev, sizeof(user_dev));
+  if (write_ret < 0)
+  {
+    raise_exception(std::runtime_error, "uinput:finish: " << user_dev.name << ": " << strerror(errno));
+  }
+  else
+  {
+    log_debug("write return value: " << write_ret);
+  }
+
+  if (ioctl(m_fd, UI_DEV_CREATE))
+  {
+    raise_exception(std::runtime_error, "unable to create uinput device: '" << user_dev.name << "': " << strerror(errno));
+  }
+
+  m_created = true;
+}
+
+void
+KernelUInputBackend::write(const struct input_event& ev)
+{
+  if (::write(m_fd, &ev, sizeof(ev)) < 0)
+  {
+    throw std::runtime_error(std::string("uinput:send_button: ") + strerror(errno));
+  }
+}
+
+NullUInputBackend::NullUInputBackend() :
+  m_event_count(0)
+{
+}
+
+MemoryUInputBackend::MemoryUInputBackend(size_t capacity) :
+  m_ring(capacity),
+  m_event_count(0)
+{
+  assert(capacity > 0);
+}
+
+void
+MemoryUInputBackend::write(const struct input_event& ev)
+{
+  m_ring[m_event_count % m_ring.size()] = ev;
+  m_event_count += 1;
+}
+
+std::vector<struct input_event>
+MemoryUInputBackend::get_events() const
+{
+  std::vector<struct input_event> events;
+
+  uint64_t begin = (m_event_count > m_ring.size()) ? m_event_count - m_ring.size() : 0;
+  for(uint64_t i = begin; i < m_event_count; ++i)
+  {
+    events.push_back(m_ring[i % m_ring.size()]);
+  }
+
+  return events;
+}
+
+void
+MemoryUInputBackend::clear()
+{
+  m_event_count = 0;
+}
+
+/* EOF */
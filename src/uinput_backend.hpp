@@ -0,0 +1,124 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_UINPUT_BACKEND_HPP
+#define HEADER_XBOXDRV_UINPUT_BACKEND_HPP
+
+#include <linux/uinput.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+    Where a LinuxUinput device sends its events. Besides the kernel
+    device there are backends that only count or store the events,
+    so the processing pipeline can be run and measured where
+    /dev/uinput isn't available.
+ */
+class UInputBackend
+{
+public:
+  enum Type { kKernel, kNull, kMemory };
+
+  static Type type_from_string(const std::string& str);
+  static UInputBackend* create(Type type);
+
+public:
+  UInputBackend() {}
+  virtual ~UInputBackend() {}
+
+  /** Declare that events of \a type will be sent, before create() */
+  virtual void enable_type(int type) =0;
+
+  /** Declare that events of \a type with \a code will be sent, before create() */
+  virtual void enable_code(int type, int code) =0;
+
+  virtual void create(const uinput_user_dev& user_dev) =0;
+
+  virtual void write(const struct input_event& ev) =0;
+
+  /** The file descriptor to read force feedback requests from, -1
+      if the backend has none */
+  virtual int get_fd() const { return -1; }
+
+private:
+  UInputBackend(const UInputBackend&);
+  UInputBackend& operator=(const UInputBackend&);
+};
+
+/** The real thing, a device created through /dev/uinput */
+class KernelUInputBackend : public UInputBackend
+{
+private:
+  int m_fd;
+  bool m_created;
+
+public:
+  KernelUInputBackend();
+  ~KernelUInputBackend();
+
+  void enable_type(int type);
+  void enable_code(int type, int code);
+  void create(const uinput_user_dev& user_dev);
+  void write(const struct input_event& ev);
+  int get_fd() const { return m_fd; }
+};
+
+/** Drops all events, only counting them */
+class NullUInputBackend : public UInputBackend
+{
+private:
+  uint64_t m_event_count;
+
+public:
+  NullUInputBackend();
+
+  void enable_type(int type) {}
+  void enable_code(int type, int code) {}
+  void create(const uinput_user_dev& user_dev) {}
+  void write(const struct input_event& ev) { m_event_count += 1; }
+
+  uint64_t get_event_count() const { return m_event_count; }
+};
+
+/** Keeps the last events in a ring buffer, for checking the output
+    of a configuration */
+class MemoryUInputBackend : public UInputBackend
+{
+private:
+  std::vector<struct input_event> m_ring;
+  uint64_t m_event_count;
+
+public:
+  MemoryUInputBackend(size_t capacity = 4096);
+
+  void enable_type(int type) {}
+  void enable_code(int type, int code) {}
+  void create(const uinput_user_dev& user_dev) {}
+  void write(const struct input_event& ev);
+
+  /** The events still in the ring, oldest first */
+  std::vector<struct input_event> get_events() const;
+  uint64_t get_event_count() const { return m_event_count; }
+  void clear();
+};
+
+#endif
+
+/* EOF */
@@ -252,10 +252,10 @@ UInputConfig::send(Playstation3USBMsg& msg)
 }
 
 void
-UInputConfig::update(int msec_delta)
+UInputConfig::update(int64_t usec_time, int usec_delta)
 {
-  m_btn_map.update(m_uinput, msec_delta);
-  m_axis_map.update(m_uinput, msec_delta);
+  m_btn_map.update(m_uinput, usec_time, usec_delta);
+  m_axis_map.update(m_uinput, usec_time, usec_delta);
 
   m_uinput.sync();
 }
@@ -45,7 +45,7 @@ public:
   UInputConfig(UInput& uinput, int slot, bool extra_devices, const UInputOptions& opts);
 
   void send(XboxGenericMsg& msg);
-  void update(int msec_delta);
+  void update(int64_t usec_time, int usec_delta);
 
   void reset_all_outputs();
 
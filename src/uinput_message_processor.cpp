@@ -19,13 +19,16 @@
 #include "uinput_message_processor.hpp"
 
 #include "log.hpp"
+#include "state_publisher.hpp"
 #include "uinput.hpp"
 
 UInputMessageProcessor::UInputMessageProcessor(UInput& uinput,
                                                ControllerSlotConfigPtr config,
+                                               int slot_id,
                                                const Options& opts) :
   m_uinput(uinput),
   m_config(config),
+  m_slot_id(slot_id),
   m_oldmsg(),
   m_config_toggle_button(opts.config_toggle_button),
   m_rumble_gain(opts.rumble_gain),
@@ -40,7 +43,7 @@ UInputMessageProcessor::~UInputMessageProcessor()
 }
 
 void
-UInputMessageProcessor::send(const XboxGenericMsg& msg_in, int msec_delta)
+UInputMessageProcessor::send(const XboxGenericMsg& msg_in, int64_t usec_time, int usec_delta)
 {
   if (!m_config->empty())
   {
@@ -77,10 +80,15 @@ UInputMessageProcessor::send(const XboxGenericMsg& msg_in, int msec_delta)
         i != m_config->get_config()->get_modifier().end();
         ++i)
     {
-      (*i)->update(msec_delta, msg);
+      (*i)->update(usec_time, usec_delta, msg);
     }
 
-    m_config->get_config()->get_uinput().update(msec_delta);
+    if (g_state_publisher.is_open())
+    {
+      g_state_publisher.publish(m_slot_id, msg_in, msg, usec_time);
+    }
+
+    m_config->get_config()->get_uinput().update(usec_time, usec_delta);
 
     // send current Xbox state to uinput
     if (memcmp(&msg, &m_oldmsg, sizeof(XboxGenericMsg)) != 0)
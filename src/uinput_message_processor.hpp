@@ -31,6 +31,7 @@ class UInputMessageProcessor : public MessageProcessor
 private:
   UInput& m_uinput;
   ControllerSlotConfigPtr m_config;
+  int m_slot_id;
 
   XboxGenericMsg m_oldmsg; /// last data send to uinput
   XboxButton m_config_toggle_button;
@@ -41,10 +42,10 @@ private:
 
 public:
   UInputMessageProcessor(UInput& uinput, ControllerSlotConfigPtr config,
-                          const Options& opts);
+                         int slot_id, const Options& opts);
   ~UInputMessageProcessor();
 
-  void send(const XboxGenericMsg& msg, int msec_delta);
+  void send(const XboxGenericMsg& msg, int64_t usec_time, int usec_delta);
   void set_rumble(uint8_t lhs, uint8_t rhs);
   void set_ff_callback(const boost::function<void (uint8_t, uint8_t)>& callback);
   void set_config(int num);
@@ -19,23 +19,26 @@
 #ifndef HEADER_XBOXDRV_ENDIAN_HPP
 #define HEADER_XBOXDRV_ENDIAN_HPP
 
+#include <endian.h>
 #include <stdint.h>
+#include <string.h>
 
+/*
+   The loaders go through memcpy(), which is safe for the unaligned
+   fields in USB reports and compiles to a single load, the byte
+   order is known at compile time, so the swap only exists on big
+   endian machines.
+*/
 namespace unpack {
 
 inline bool is_big_endian()
 {
-  union {
-    uint32_t i;
-    char c[4];
-  } bint = {0x01020304};
-
-  return bint.c[0] == 1;
+  return __BYTE_ORDER == __BIG_ENDIAN;
 }
 
 inline uint16_t swap16(uint16_t v)
 {
-  return (v<<8) | (v>>8);
+  return static_cast<uint16_t>((v<<8) | (v>>8));
 }
 
 inline uint32_t swap32(uint32_t v)
@@ -43,61 +46,95 @@ inline uint32_t swap32(uint32_t v)
   return (v<<24) | ((v<<8) & 0x00ff0000) | ((v>>8) & 0x0000ff00) | (v>>24);
 }
 
+inline uint16_t load16(const uint8_t* data)
+{
+  uint16_t v;
+  memcpy(&v, data, sizeof(v));
+  return v;
+}
+
+inline uint32_t load32(const uint8_t* data)
+{
+  uint32_t v;
+  memcpy(&v, data, sizeof(v));
+  return v;
+}
+
+#if __BYTE_ORDER == __BIG_ENDIAN
+inline uint16_t from_le16(uint16_t v) { return swap16(v); }
+inline uint32_t from_le32(uint32_t v) { return swap32(v); }
+inline uint16_t from_be16(uint16_t v) { return v; }
+inline uint32_t from_be32(uint32_t v) { return v; }
+#else
+inline uint16_t from_le16(uint16_t v) { return v; }
+inline uint32_t from_le32(uint32_t v) { return v; }
+inline uint16_t from_be16(uint16_t v) { return swap16(v); }
+inline uint32_t from_be32(uint32_t v) { return swap32(v); }
+#endif
+
 
-inline int16_t int16le(uint8_t* data)
+inline int16_t int16le(const uint8_t* data)
 {
-  if (is_big_endian()) return swap16(*reinterpret_cast<int16_t*>(data));
-  else                 return *reinterpret_cast<int16_t*>(data);
+  return static_cast<int16_t>(from_le16(load16(data)));
 }
 
-inline uint16_t uint16le(uint8_t* data)
+inline uint16_t uint16le(const uint8_t* data)
 {
-  if (is_big_endian()) return swap16(*reinterpret_cast<uint16_t*>(data));
-  else                 return *reinterpret_cast<uint16_t*>(data);
+  return from_le16(load16(data));
 }
 
 
-inline int32_t int32le(uint8_t* data)
+inline int32_t int32le(const uint8_t* data)
 {
-  if (is_big_endian()) return swap32(*reinterpret_cast<int32_t*>(data));
-  else                 return *reinterpret_cast<int32_t*>(data);
+  return static_cast<int32_t>(from_le32(load32(data)));
 }
 
-inline uint32_t uint32le(uint8_t* data)
+inline uint32_t uint32le(const uint8_t* data)
 {
-  if (is_big_endian()) return swap32(*reinterpret_cast<uint32_t*>(data));
-  else                 return *reinterpret_cast<uint32_t*>(data);
+  return from_le32(load32(data));
 }
 
 
 
-inline int16_t int16be(uint8_t* data)
+inline int16_t int16be(const uint8_t* data)
 {
-  if (!is_big_endian()) return swap16(*reinterpret_cast<int16_t*>(data));
-  else                  return *reinterpret_cast<int16_t*>(data);
+  return static_cast<int16_t>(from_be16(load16(data)));
 }
 
-inline uint16_t uint16be(uint8_t* data)
+inline uint16_t uint16be(const uint8_t* data)
 {
-  if (!is_big_endian()) return swap16(*reinterpret_cast<uint16_t*>(data));
-  else                  return *reinterpret_cast<uint16_t*>(data);
+  return from_be16(load16(data));
 }
 
 
-inline int32_t int32be(uint8_t* data)
+inline int32_t int32be(const uint8_t* data)
+{
+  return static_cast<int32_t>(from_be32(load32(data)));
+}
+
+inline uint32_t uint32be(const uint8_t* data)
 {
-  if (!is_big_endian()) return swap32(*reinterpret_cast<int32_t*>(data));
-  else                  return *reinterpret_cast<int32_t*>(data);
+  return from_be32(load32(data));
 }
 
-inline uint32_t uint32be(uint8_t* data)
+
+/** Read \a count consecutive little endian values, on little endian
+    machines this is a plain copy, which the compiler turns into a
+    few wide moves */
+inline void int16le_array(const uint8_t* data, int16_t* out, int count)
 {
-  if (!is_big_endian()) return swap32(*reinterpret_cast<uint32_t*>(data));
-  else                  return *reinterpret_cast<uint32_t*>(data);
+#if __BYTE_ORDER == __BIG_ENDIAN
+  for(int i = 0; i < count; ++i)
+  {
+    out[i] = int16le(data + 2*i);
+  }
+#else
+  memcpy(out, data, sizeof(int16_t) * count);
+#endif
 }
 
 
-inline bool bit(uint8_t* data, int bit)
+inline bool bit(const uint8_t* data, int bit)
 {
   return (*data >> bit) & 1;
 }
@@ -0,0 +1,143 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "usb_context_pool.hpp"
+
+#include <assert.h>
+#include <stdexcept>
+#include <sys/time.h>
+
+#include "log.hpp"
+#include "raise_exception.hpp"
+#include "scheduling.hpp"
+#include "usb_helper.hpp"
+
+USBContextPool g_usb_contexts;
+
+namespace {
+
+/** how long an event thread blocks before it checks for shutdown */
+const int kEventTimeoutMs = 100;
+
+} // namespace
+
+USBContextPool::USBContextPool() :
+  m_threads(),
+  m_by_bus(false),
+  m_quit(0)
+{
+}
+
+USBContextPool::~USBContextPool()
+{
+  stop();
+}
+
+void
+USBContextPool::start(int count, bool by_bus)
+{
+  assert(m_threads.empty());
+
+  m_by_bus = by_bus;
+  g_atomic_int_set(&m_quit, 0);
+
+  // the threads keep a pointer to their entry, so the vector must
+  // not reallocate once they are started
+  m_threads.reserve(count);
+  for(int i = 0; i < count; ++i)
+  {
+    EventThread thread;
+    thread.pool    = this;
+    thread.context = 0;
+    thread.thread  = 0;
+
+    int ret = libusb_init(&thread.context);
+    if (ret != LIBUSB_SUCCESS)
+    {
+      stop();
+      raise_exception(std::runtime_error, "libusb_init() failed: " << usb_strerror(ret));
+    }
+
+    m_threads.push_back(thread);
+    m_threads.back().thread = g_thread_new("usb-events", &USBContextPool::run_wrap, &m_threads.back());
+  }
+
+  log_info("handling USB events in " << count << " contexts, "
+           << (m_by_bus ? "one per bus" : "spread by device"));
+}
+
+void
+USBContextPool::stop()
+{
+  g_atomic_int_set(&m_quit, 1);
+
+  for(std::vector<EventThread>::iterator it = m_threads.begin(); it != m_threads.end(); ++it)
+  {
+    if (it->thread)
+    {
+      g_thread_join(it->thread);
+    }
+    libusb_exit(it->context);
+  }
+
+  m_threads.clear();
+}
+
+libusb_context*
+USBContextPool::get_context(int busnum, int devnum) const
+{
+  if (m_threads.empty())
+  {
+    return NULL;
+  }
+  else if (m_by_bus)
+  {
+    return m_threads[busnum % m_threads.size()].context;
+  }
+  else
+  {
+    // device addresses are unique per bus and below 128
+    return m_threads[(busnum * 128 + devnum) % m_threads.size()].context;
+  }
+}
+
+gpointer
+USBContextPool::run_wrap(gpointer data)
+{
+  EventThread* thread = static_cast<EventThread*>(data);
+
+  g_scheduling.enter_usb_event_thread();
+
+  while (!g_atomic_int_get(&thread->pool->m_quit))
+  {
+    struct timeval tv;
+    tv.tv_sec  = 0;
+    tv.tv_usec = kEventTimeoutMs * 1000;
+
+    int ret = libusb_handle_events_timeout_completed(thread->context, &tv, NULL);
+    if (ret != LIBUSB_SUCCESS && ret != LIBUSB_ERROR_INTERRUPTED)
+    {
+      log_error("libusb_handle_events_timeout_completed() failure: " << usb_strerror(ret));
+    }
+  }
+
+  return 0;
+}
+
+/* EOF */
@@ -0,0 +1,80 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOXDRV_USB_CONTEXT_POOL_HPP
+#define HEADER_XBOXDRV_USB_CONTEXT_POOL_HPP
+
+#include <glib.h>
+#include <libusb.h>
+#include <vector>
+
+/**
+    A set of libusb contexts, each with its own event thread, so that
+    USB completion handling of many controllers isn't serialized
+    through the default context in the main loop. Controllers are
+    pinned to a context by their bus:dev, either round-robin or one
+    context per bus, their reports are handed back to the main loop
+    for processing.
+
+    When the pool isn't started, get_context() returns NULL and
+    everything runs on the default context as before.
+ */
+class USBContextPool
+{
+private:
+  struct EventThread
+  {
+    USBContextPool* pool;
+    libusb_context* context;
+    GThread* thread;
+  };
+
+  std::vector<EventThread> m_threads;
+  bool m_by_bus;
+  volatile gint m_quit;
+
+public:
+  USBContextPool();
+  ~USBContextPool();
+
+  /** Create \a count contexts and their event threads, the threads
+      get their scheduling from g_scheduling */
+  void start(int count, bool by_bus);
+
+  /** Stop the event threads and free the contexts, all devices
+      opened in them must be closed by then */
+  void stop();
+
+  /** The context the device at \a busnum:\a devnum belongs to, NULL
+      for the default context */
+  libusb_context* get_context(int busnum, int devnum) const;
+
+private:
+  static gpointer run_wrap(gpointer data);
+
+private:
+  USBContextPool(const USBContextPool&);
+  USBContextPool& operator=(const USBContextPool&);
+};
+
+extern USBContextPool g_usb_contexts;
+
+#endif
+
+/* EOF */
@@ -20,58 +20,75 @@
 
 #include <boost/format.hpp>
 
+#include "input_recorder.hpp"
 #include "log.hpp"
 #include "raise_exception.hpp"
+#include "usb_context_pool.hpp"
 #include "usb_helper.hpp"
 #include "xboxmsg.hpp"
 
 USBController::USBController(libusb_device* dev) :
   m_dev(dev),
   m_handle(0),
+  m_transfers_mutex(),
   m_transfers(),
+  m_ready(0),
+  m_read_errors(0),
   m_interfaces(),
   m_usbpath(),
   m_usbid(),
-  m_name()
+  m_strings_mutex(),
+  m_manufacturer(),
+  m_product(),
+  m_serial(),
+  m_recorder(0),
+  m_context(0),
+  m_pending_mutex(),
+  m_pending(),
+  m_dispatching(),
+  m_pending_disconnect(false),
+  m_pending_source(0)
 {
-  int ret = libusb_open(dev, &m_handle);
-  if (ret != LIBUSB_SUCCESS)
+  g_mutex_init(&m_transfers_mutex);
+  g_mutex_init(&m_pending_mutex);
+  g_mutex_init(&m_strings_mutex);
+
+  if (!m_dev)
   {
-    raise_exception(std::runtime_error, "libusb_open() failed: " << usb_strerror(ret));
+    // offline controller, used for replays, reports come in through
+    // inject_report() and all USB I/O is dropped
+    m_usbpath = "000:000";
+    m_usbid   = "0000:0000";
   }
   else
   {
-    // get usbpath, usbid and name
-    m_usbpath = (boost::format("%03d:%03d")
-                 % static_cast<int>(libusb_get_bus_number(dev))
-                 % static_cast<int>(libusb_get_device_address(dev))).str();
+    m_context = g_usb_contexts.get_context(libusb_get_bus_number(dev),
+                                           libusb_get_device_address(dev));
 
-    libusb_device_descriptor desc;
-    ret = libusb_get_device_descriptor(dev, &desc);
-    if (ret == LIBUSB_SUCCESS)
+    int ret = libusb_open(dev, &m_handle);
+    if (ret != LIBUSB_SUCCESS)
     {
-      m_usbid = (boost::format("%04x:%04x")
-                 % static_cast<int>(desc.idVendor)
-                 % static_cast<int>(desc.idProduct)).str();
-
-      char buf[1024];
-      int len;
-      if (false)
-      { // FIXME: do we need the manufacturer name?
-        len = libusb_get_string_descriptor_ascii(m_handle, desc.iManufacturer,
-                                                 reinterpret_cast<unsigned char*>(buf), sizeof(buf));
-        if (len > 0)
-        {
-          m_name.append(buf, len);
-          m_name.append(" ");
-        }
-      }
-
-      len = libusb_get_string_descriptor_ascii(m_handle, desc.iProduct,
-                                               reinterpret_cast<unsigned char*>(buf), sizeof(buf));
-      if (len > 0)
+      raise_exception(std::runtime_error, "libusb_open() failed: " << usb_strerror(ret));
+    }
+    else
+    {
+      // get usbpath and usbid, the string descriptors are only read
+      // when something asks for them
+      m_usbpath = (boost::format("%03d:%03d")
+                   % static_cast<int>(libusb_get_bus_number(dev))
+                   % static_cast<int>(libusb_get_device_address(dev))).str();
+
+      libusb_device_descriptor desc;
+      ret = libusb_get_device_descriptor(dev, &desc);
+      if (ret == LIBUSB_SUCCESS)
       {
-        m_name.append(buf, len);
+        m_usbid = (boost::format("%04x:%04x")
+                   % static_cast<int>(desc.idVendor)
+                   % static_cast<int>(desc.idProduct)).str();
+
+        m_manufacturer.index = desc.iManufacturer;
+        m_product.index      = desc.iProduct;
+        m_serial.index       = desc.iSerialNumber;
       }
     }
   }
@@ -80,29 +97,91 @@ USBController::USBController(libusb_device* dev) :
 USBController::~USBController()
 {
   // cancel all transfers
+  g_mutex_lock(&m_transfers_mutex);
   for(std::set<libusb_transfer*>::iterator it = m_transfers.begin(); it != m_transfers.end(); ++it)
   {
     libusb_cancel_transfer(*it);
   }
+  g_mutex_unlock(&m_transfers_mutex);
 
   // wait for cancel to succeed
-  while (!m_transfers.empty())
+  while (true)
   {
-    int ret = libusb_handle_events(NULL);
+    g_mutex_lock(&m_transfers_mutex);
+    bool empty = m_transfers.empty();
+    g_mutex_unlock(&m_transfers_mutex);
+
+    if (empty)
+    {
+      break;
+    }
+
+    // when the context has an event thread, this only waits for it
+    // to complete the cancellations
+    int ret = libusb_handle_events(m_context);
     if (ret != 0)
     {
       log_error("libusb_handle_events() failure: " << ret);
     }
   }
 
-  // release all claimed interfaces
-  for(std::set<int>::iterator it = m_interfaces.begin(); it != m_interfaces.end(); ++it)
+  // no more reports can come in, drop those not yet processed
+  g_mutex_lock(&m_pending_mutex);
+  if (m_pending_source)
+  {
+    g_source_remove(m_pending_source);
+    m_pending_source = 0;
+  }
+  g_mutex_unlock(&m_pending_mutex);
+
+  if (m_handle)
   {
-    libusb_release_interface(m_handle, *it);
+    // release all claimed interfaces
+    for(std::set<int>::iterator it = m_interfaces.begin(); it != m_interfaces.end(); ++it)
+    {
+      libusb_release_interface(m_handle, *it);
+    }
+
+    // read and write transfers might still be going on and might need to be canceled
+    libusb_close(m_handle);
   }
 
-  // read and write transfers might still be going on and might need to be canceled
-  libusb_close(m_handle);
+  g_mutex_clear(&m_strings_mutex);
+  g_mutex_clear(&m_pending_mutex);
+  g_mutex_clear(&m_transfers_mutex);
+}
+
+void
+USBController::set_ready()
+{
+  g_atomic_int_set(&m_ready, 1);
+
+  // reports and a disconnect that came in during construction are
+  // only passed on now, see schedule_pending()
+  {
+    g_mutex_lock(&m_pending_mutex);
+    if (m_pending_disconnect || !m_pending.empty())
+    {
+      schedule_pending();
+    }
+    g_mutex_unlock(&m_pending_mutex);
+  }
+}
+
+void
+USBController::add_transfer(libusb_transfer* transfer)
+{
+  g_mutex_lock(&m_transfers_mutex);
+  m_transfers.insert(transfer);
+  g_mutex_unlock(&m_transfers_mutex);
+}
+
+void
+USBController::remove_transfer(libusb_transfer* transfer)
+{
+  g_mutex_lock(&m_transfers_mutex);
+  m_transfers.erase(transfer);
+  g_mutex_unlock(&m_transfers_mutex);
 }
 
 std::string
@@ -120,12 +199,76 @@ USBController::get_usbid() const
 std::string
 USBController::get_name() const
 {
-  return m_name;
+  const std::string manufacturer = get_manufacturer();
+  const std::string product = get_string_descriptor(m_product);
+
+  if (manufacturer.empty() || product.empty())
+  {
+    return manufacturer + product;
+  }
+  else
+  {
+    return manufacturer + " " + product;
+  }
+}
+
+int
+USBController::get_error_count() const
+{
+  return g_atomic_int_get(&m_read_errors);
+}
+
+std::string
+USBController::get_manufacturer() const
+{
+  return get_string_descriptor(m_manufacturer);
+}
+
+std::string
+USBController::get_serial() const
+{
+  return get_string_descriptor(m_serial);
+}
+
+std::string
+USBController::get_string_descriptor(StringDescriptor& str) const
+{
+  // an unresponsive device is only asked a few times, the next
+  // instance of it starts over
+  const int kMaxAttempts = 3;
+
+  g_mutex_lock(&m_strings_mutex);
+  if (!str.valid && str.index != 0 && m_handle && str.attempts < kMaxAttempts)
+  {
+    str.attempts += 1;
+
+    unsigned char buf[256];
+    int len = libusb_get_string_descriptor_ascii(m_handle, str.index, buf, sizeof(buf));
+    if (len >= 0)
+    {
+      str.value.assign(reinterpret_cast<char*>(buf), len);
+      str.valid = true;
+    }
+    else
+    {
+      log_debug("failed to read string descriptor " << static_cast<int>(str.index)
+                << " from " << m_usbpath << ": " << usb_strerror(len));
+    }
+  }
+  std::string value = str.value;
+  g_mutex_unlock(&m_strings_mutex);
+
+  return value;
 }
 
 void
 USBController::usb_submit_read(int endpoint, int len)
 {
+  if (!m_handle)
+  {
+    return;
+  }
+
   libusb_transfer* transfer = libusb_alloc_transfer(0);
 
   uint8_t* data = static_cast<uint8_t*>(malloc(sizeof(uint8_t) * len));
@@ -135,22 +278,28 @@ USBController::usb_submit_read(int endpoint, int len)
                                  data, len,
                                  &USBController::on_read_data_wrap, this,
                                  0); // timeout
+  // register the transfer before submitting it, its callback might
+  // run in the main loop before libusb_submit_transfer() returns
+  add_transfer(transfer);
+
   int ret;
   ret = libusb_submit_transfer(transfer);
   if (ret != LIBUSB_SUCCESS)
   {
+    remove_transfer(transfer);
     libusb_free_transfer(transfer);
     raise_exception(std::runtime_error, "libusb_submit_transfer(): " << usb_strerror(ret));
   }
-  else
-  {
-    m_transfers.insert(transfer);
-  }
 }
 
 void
 USBController::usb_write(int endpoint, uint8_t* data_in, int len)
 {
+  if (!m_handle)
+  {
+    return;
+  }
+
   libusb_transfer* transfer = libusb_alloc_transfer(0);
   transfer->flags |= LIBUSB_TRANSFER_FREE_BUFFER;
 
@@ -164,17 +313,18 @@ USBController::usb_write(int endpoint, uint8_t* data_in, int len)
                                  &USBController::on_write_data_wrap, this,
                                  0); // timeout
 
+  // register the transfer before submitting it, its callback might
+  // run in the main loop before libusb_submit_transfer() returns
+  add_transfer(transfer);
+
   int ret;
   ret = libusb_submit_transfer(transfer);
   if (ret != LIBUSB_SUCCESS)
   {
+    remove_transfer(transfer);
     libusb_free_transfer(transfer);
     raise_exception(std::runtime_error, "libusb_submit_transfer(): " << usb_strerror(ret));
   }
-  else
-  {
-    m_transfers.insert(transfer);
-  }
 }
 
 void
@@ -182,6 +332,11 @@ USBController::usb_control(uint8_t  bmRequestType, uint8_t  bRequest,
                            uint16_t wValue, uint16_t wIndex,
                            uint8_t* data_in, uint16_t wLength)
 {
+  if (!m_handle)
+  {
+    return;
+  }
+
   libusb_transfer* transfer = libusb_alloc_transfer(0);
   transfer->flags |= LIBUSB_TRANSFER_FREE_BUFFER;
 
@@ -193,17 +348,18 @@ USBController::usb_control(uint8_t  bmRequestType, uint8_t  bRequest,
                                &USBController::on_control_wrap, this,
                                0);
 
+  // register the transfer before submitting it, its callback might
+  // run in the main loop before libusb_submit_transfer() returns
+  add_transfer(transfer);
+
   int ret;
   ret = libusb_submit_transfer(transfer);
   if (ret != LIBUSB_SUCCESS)
   {
+    remove_transfer(transfer);
     libusb_free_transfer(transfer);
     raise_exception(std::runtime_error, "libusb_submit_transfer(): " << usb_strerror(ret));
   }
-  else
-  {
-    m_transfers.insert(transfer);
-  }
 }
 
 void
@@ -211,7 +367,7 @@ USBController::on_control(libusb_transfer* transfer)
 {
   log_debug("control transfer");
 
-  m_transfers.erase(transfer);
+  remove_transfer(transfer);
   libusb_free_transfer(transfer);
 }
 
@@ -228,17 +384,127 @@ USBController::on_write_data(libusb_transfer* transfer)
   }
   else if (transfer->status == LIBUSB_TRANSFER_NO_DEVICE)
   {
-    send_disconnect();
+    send_usb_disconnect();
   }
   else
   {
     log_error("USB write failure: " << transfer->length << ": " << usb_transfer_strerror(transfer->status));
   }
 
-  m_transfers.erase(transfer);
+  remove_transfer(transfer);
   libusb_free_transfer(transfer);
 }
 
+void
+USBController::inject_report(uint8_t* data, int len)
+{
+  dispatch_report(0, data, len);
+}
+
+void
+USBController::process_report(uint8_t* data, int len)
+{
+  if (m_recorder)
+  {
+    m_recorder->record(data, len);
+  }
+
+  XboxGenericMsg msg;
+  if (parse(data, len, &msg))
+  {
+    submit_msg(msg);
+  }
+}
+
+void
+USBController::receive_report(uint8_t endpoint, uint8_t* data, int len)
+{
+  process_report(data, len);
+}
+
+void
+USBController::dispatch_report(uint8_t endpoint, uint8_t* data, int len)
+{
+  // reports are queued when they come in on an event thread, before
+  // the controller is ready (e.g. the connection announce of a
+  // wireless controller that is already on) or while older ones are
+  // still queued, so that none get lost or reordered
+  g_mutex_lock(&m_pending_mutex);
+  const bool queue = (m_context || !g_atomic_int_get(&m_ready) || !m_pending.empty());
+  if (queue)
+  {
+    uint8_t header[3];
+    header[0] = endpoint;
+    header[1] = static_cast<uint8_t>(len & 0xff);
+    header[2] = static_cast<uint8_t>((len >> 8) & 0xff);
+
+    m_pending.insert(m_pending.end(), header, header + 3);
+    m_pending.insert(m_pending.end(), data, data + len);
+    schedule_pending();
+  }
+  g_mutex_unlock(&m_pending_mutex);
+
+  if (!queue)
+  {
+    receive_report(endpoint, data, len);
+  }
+}
+
+void
+USBController::schedule_pending()
+{
+  // called with m_pending_mutex held; nothing is handed to the main
+  // loop before the controller is ready, as until then it might get
+  // destroyed in a bring-up thread while the main loop dispatches
+  if (!m_pending_source && g_atomic_int_get(&m_ready))
+  {
+    m_pending_source = g_idle_add_full(G_PRIORITY_HIGH, &USBController::on_pending_wrap, this, NULL);
+  }
+}
+
+void
+USBController::send_usb_disconnect()
+{
+  if (!m_context && g_atomic_int_get(&m_ready))
+  {
+    send_disconnect();
+  }
+  else
+  {
+    g_mutex_lock(&m_pending_mutex);
+    m_pending_disconnect = true;
+    schedule_pending();
+    g_mutex_unlock(&m_pending_mutex);
+  }
+}
+
+bool
+USBController::on_pending()
+{
+  g_mutex_lock(&m_pending_mutex);
+  m_pending_source = 0;
+  m_pending.swap(m_dispatching);
+  bool disconnect = m_pending_disconnect;
+  m_pending_disconnect = false;
+  g_mutex_unlock(&m_pending_mutex);
+
+  size_t i = 0;
+  while (i + 3 <= m_dispatching.size())
+  {
+    int len = m_dispatching[i+1] | (m_dispatching[i+2] << 8);
+    receive_report(m_dispatching[i], &m_dispatching[i+3], len);
+    i += 3 + len;
+  }
+  m_dispatching.clear();
+
+  if (disconnect)
+  {
+    send_disconnect();
+  }
+
+  return false;
+}
+
 void
 USBController::on_read_data(libusb_transfer* transfer)
 {
@@ -246,21 +512,16 @@ USBController::on_read_data(libusb_transfer* transfer)
 
   if (transfer->status == LIBUSB_TRANSFER_COMPLETED)
   {
-    // process data
-    XboxGenericMsg msg;
-    if (parse(transfer->buffer, transfer->actual_length, &msg))
-    {
-      submit_msg(msg);
-    }
+    dispatch_report(transfer->endpoint, transfer->buffer, transfer->actual_length);
 
     int ret;
     ret = libusb_submit_transfer(transfer);
     if (ret != LIBUSB_SUCCESS) // could also check for LIBUSB_ERROR_NO_DEVICE
     {
       log_error("failed to resubmit USB transfer: " << usb_strerror(ret));
-      m_transfers.erase(transfer);
+      remove_transfer(transfer);
       libusb_free_transfer(transfer);
-      send_disconnect();
+      send_usb_disconnect();
     }
   }
   else if (transfer->status == LIBUSB_TRANSFER_CANCELLED)
@@ -269,14 +530,15 @@ USBController::on_read_data(libusb_transfer* transfer)
   }
   else if (transfer->status == LIBUSB_TRANSFER_NO_DEVICE)
   {
-    m_transfers.erase(transfer);
+    remove_transfer(transfer);
     libusb_free_transfer(transfer);
-    send_disconnect();
+    send_usb_disconnect();
   }
   else
   {
     log_error("USB read failure: " << transfer->length << ": " << usb_transfer_strerror(transfer->status));
-    m_transfers.erase(transfer);
+    g_atomic_int_inc(&m_read_errors);
+    remove_transfer(transfer);
     libusb_free_transfer(transfer);
   }
 }
@@ -284,6 +546,11 @@ USBController::on_read_data(libusb_transfer* transfer)
 void
 USBController::usb_claim_interface(int ifnum, bool try_detach)
 {
+  if (!m_handle)
+  {
+    return;
+  }
+
   // keep track of all claimed interfaces so they can be released in
   // the destructor
   assert(m_interfaces.find(ifnum) == m_interfaces.end());
@@ -302,6 +569,11 @@ USBController::usb_claim_interface(int ifnum, bool try_detach)
 int
 USBController::usb_find_ep(int direction, uint8_t if_class, uint8_t if_subclass, uint8_t if_protocol)
 {
+  if (!m_dev)
+  {
+    return 0;
+  }
+
   libusb_config_descriptor* config;
   int ret = libusb_get_config_descriptor(m_dev, 0 /* config_index */, &config);
 
@@ -19,27 +19,72 @@
 #ifndef HEADER_XBOXDRV_USB_CONTROLLER_HPP
 #define HEADER_XBOXDRV_USB_CONTROLLER_HPP
 
+#include <glib.h>
 #include <libusb.h>
 #include <string>
 #include <memory>
 #include <set>
+#include <vector>
 
 #include "controller.hpp"
 
+class InputRecorder;
+
 class USBController : public Controller
 {
 protected:
   libusb_device* m_dev;
   libusb_device_handle* m_handle;
 
+  /** the daemon constructs controllers in its bring-up threads while
+      the main loop already handles their transfers, so the set of
+      transfers is protected and input is queued until the controller
+      is fully constructed */
+  GMutex m_transfers_mutex;
   std::set<libusb_transfer*> m_transfers;
+  volatile gint m_ready;
+  volatile gint m_read_errors;
   std::set<int> m_interfaces;
 
   std::string m_usbpath;
   std::string m_usbid;
-  std::string m_name;
+
+  /** A string descriptor of the device, read when it is first asked
+      for, as each is a control transfer that some cheap devices are
+      very slow to answer */
+  struct StringDescriptor
+  {
+    uint8_t index;
+    int attempts;
+    bool valid;
+    std::string value;
+
+    StringDescriptor() : index(0), attempts(0), valid(false), value() {}
+  };
+
+  mutable GMutex m_strings_mutex;
+  mutable StringDescriptor m_manufacturer;
+  mutable StringDescriptor m_product;
+  mutable StringDescriptor m_serial;
+
+  InputRecorder* m_recorder;
+
+  /** the libusb context the device was opened in, when it isn't the
+      default one, its transfers complete in an event thread of
+      g_usb_contexts and the reports are queued in m_pending (each
+      prefixed with its endpoint and uint16 length) to be processed
+      in the main loop, the same queue holds the reports that arrive
+      before set_ready() */
+  libusb_context* m_context;
+  GMutex m_pending_mutex;
+  std::vector<uint8_t> m_pending;
+  std::vector<uint8_t> m_dispatching;
+  bool m_pending_disconnect;
+  guint m_pending_source;
 
 public:
+  /** A \a dev of 0 creates an offline controller, all USB I/O is
+      dropped and reports only come in through inject_report() */
   USBController(libusb_device* dev);
   virtual ~USBController();
 
@@ -47,8 +92,25 @@ public:
   virtual std::string get_usbid() const;
   virtual std::string get_name() const;
 
+  virtual int get_error_count() const;
+
+  std::string get_manufacturer() const;
+  virtual std::string get_serial() const;
+
   virtual bool parse(uint8_t* data, int len, XboxGenericMsg* msg_out) =0;
 
+  /** Called by ControllerFactory once the controller is fully
+      constructed, parse() isn't called before that, reports that
+      came in until then are replayed from the main loop */
+  void set_ready();
+
+  /** Feed \a data to parse() as if it had been read from the device */
+  void inject_report(uint8_t* data, int len);
+
+  /** Write all reports read from the device to \a recorder, which
+      must outlive the controller or be reset with 0 */
+  void set_recorder(InputRecorder* recorder) { m_recorder = recorder; }
+
   int  usb_find_ep(int direction, uint8_t if_class, uint8_t if_subclass, uint8_t if_protocol);
 
   void usb_claim_interface(int ifnum, bool try_detach);
@@ -60,7 +122,32 @@ public:
                    uint16_t wValue, uint16_t wIndex,
                    uint8_t* data, uint16_t len);
 
+protected:
+  /** Called with each report read from \a endpoint once the
+      controller is ready, in the main loop. The default passes it
+      on to parse() */
+  virtual void receive_report(uint8_t endpoint, uint8_t* data, int len);
+
 private:
+  /** The value of \a str, read from the device on first use, a
+      failed read is retried on the following calls a few times */
+  std::string get_string_descriptor(StringDescriptor& str) const;
+
+  void process_report(uint8_t* data, int len);
+
+  void dispatch_report(uint8_t endpoint, uint8_t* data, int len);
+  void schedule_pending();
+  void send_usb_disconnect();
+
+  bool on_pending();
+  static gboolean on_pending_wrap(gpointer data)
+  {
+    return static_cast<USBController*>(data)->on_pending();
+  }
+
+  void add_transfer(libusb_transfer* transfer);
+  void remove_transfer(libusb_transfer* transfer);
+
   void on_read_data(libusb_transfer *transfer);
   static void on_read_data_wrap(libusb_transfer *transfer)
   {
@@ -19,19 +19,32 @@
 #include "usb_gsource.hpp"
 
 #include <assert.h>
+#include <errno.h>
 #include <poll.h>
 #include <libusb.h>
+#include <stdexcept>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
 
 #include "log.hpp"
+#include "raise_exception.hpp"
 #include "usb_helper.hpp"
 
 USBGSource::USBGSource() :
   m_source_funcs(),
   m_source(),
   m_source_id(),
-  m_pollfds()
+  m_epoll_fd(-1),
+  m_epoll_pollfd()
 {
+  m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epoll_fd < 0)
+  {
+    raise_exception(std::runtime_error, "epoll_create1() failed: " << strerror(errno));
+  }
+
   // create the source functions
   m_source_funcs.prepare  = &USBGSource::on_source_prepare;
   m_source_funcs.check    = &USBGSource::on_source_check;
@@ -41,13 +54,19 @@ USBGSource::USBGSource() :
   m_source_funcs.closure_callback = NULL;
   m_source_funcs.closure_marshal  = NULL;
 
-  // create the source itself
+  // create the source itself, the epoll fd becomes readable when any
+  // of the fds in it is ready
   m_source = reinterpret_cast<GUSBSource*>(g_source_new(&m_source_funcs, sizeof(GUSBSource)));
   m_source->usb_source = this;
   g_source_set_callback(&m_source->source,
                         &USBGSource::on_source_wrap, this,
                         NULL);
 
+  m_epoll_pollfd.fd      = m_epoll_fd;
+  m_epoll_pollfd.events  = G_IO_IN;
+  m_epoll_pollfd.revents = 0;
+  g_source_add_poll(&m_source->source, &m_epoll_pollfd);
+
   // add pollfds to source
   const libusb_pollfd** fds = libusb_get_pollfds(NULL);
   for(const libusb_pollfd** i = fds; *i != NULL; ++i)
@@ -70,6 +89,8 @@ USBGSource::~USBGSource()
 
   // get rid of the GSource created in the constructor
   g_source_unref(reinterpret_cast<GSource*>(m_source));
+
+  close(m_epoll_fd);
 }
 
 void
@@ -82,37 +103,29 @@ USBGSource::attach(GMainContext* context)
 void
 USBGSource::on_usb_pollfd_added(int fd, short events)
 {
-  GPollFD* gfd = new GPollFD;
-
-  gfd->fd = fd;
-  gfd->events  = events;
-  gfd->revents = 0;
-
-  g_source_add_poll(&m_source->source, gfd);
-
-  m_pollfds.push_back(gfd);
+  epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.data.fd = fd;
+  if (events & POLLIN)  ev.events |= EPOLLIN;
+  if (events & POLLPRI) ev.events |= EPOLLPRI;
+  if (events & POLLOUT) ev.events |= EPOLLOUT;
+
+  if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+  {
+    log_error("epoll_ctl(EPOLL_CTL_ADD, " << fd << ") failed: " << strerror(errno));
+  }
 }
 
 void
 USBGSource::on_usb_pollfd_removed(int fd)
 {
-  // find the GPollFD that matched the given \a fd
-  std::list<GPollFD*>::iterator it = m_pollfds.end();
-  for(std::list<GPollFD*>::iterator i = m_pollfds.begin(); i != m_pollfds.end(); ++i)
+  // the kernel drops closed fds from the epoll set by itself, so
+  // ENOENT and EBADF only mean that it was faster
+  if (epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, NULL) < 0 &&
+      errno != ENOENT && errno != EBADF)
   {
-    if ((*i)->fd == fd)
-    {
-      it = i;
-      break;
-    }
+    log_error("epoll_ctl(EPOLL_CTL_DEL, " << fd << ") failed: " << strerror(errno));
   }
-
-  assert(it != m_pollfds.end());
-
-  // FIXME: here is a bug
-  g_source_remove_poll(&m_source->source, *it);
-  delete *it;
-  m_pollfds.erase(it);
 }
 
 gboolean
@@ -143,26 +156,7 @@ gboolean
 USBGSource::on_source_check(GSource* source)
 {
   USBGSource* usb_source = reinterpret_cast<GUSBSource*>(source)->usb_source;
-  //log_debug("Number of PollFD: " << usb_source->m_pollfds.size());
-  for(std::list<GPollFD*>::iterator i = usb_source->m_pollfds.begin(); i != usb_source->m_pollfds.end(); ++i)
-  {
-    if (false)
-    {
-      log_debug("GSource GPollFD: " << (*i)->fd);
-      log_debug("REvents: G_IO_OUT: " << ((*i)->revents & G_IO_OUT));
-      log_debug("         G_IO_IN:  " << ((*i)->revents & G_IO_IN));
-      log_debug("         G_IO_PRI: " << ((*i)->revents & G_IO_PRI));
-      log_debug("         G_IO_HUP: " << ((*i)->revents & G_IO_HUP));
-      log_debug("         G_IO_ERR: " << ((*i)->revents & G_IO_ERR));
-    }
-
-    if ((*i)->revents)
-    {
-      return TRUE;
-    }
-  }
-
-  return FALSE;
+  return usb_source->m_epoll_pollfd.revents != 0;
 }
 
 gboolean
@@ -174,7 +168,19 @@ USBGSource::on_source_dispatch(GSource* source, GSourceFunc callback, gpointer u
 gboolean
 USBGSource::on_source()
 {
-  libusb_handle_events(NULL);
+  // the epoll fd said something is ready, so handle it without
+  // blocking, libusb_handle_events() would wait up to a minute when
+  // another thread beat us to the events
+  struct timeval tv;
+  tv.tv_sec  = 0;
+  tv.tv_usec = 0;
+
+  int ret = libusb_handle_events_timeout_completed(NULL, &tv, NULL);
+  if (ret != LIBUSB_SUCCESS && ret != LIBUSB_ERROR_INTERRUPTED)
+  {
+    log_error("libusb_handle_events_timeout_completed() failed: " << usb_strerror(ret));
+  }
+
   return TRUE;
 }
 
@@ -20,7 +20,6 @@
 #define HEADER_XBOXDRV_USB_GSOURCE_HPP
 
 #include <glib.h>
-#include <list>
 
 class USBGSource;
 
@@ -30,13 +29,24 @@ struct GUSBSource
   USBGSource* usb_source;
 };
 
+/**
+    Integrates libusb into the GLib main loop. The pollfds of libusb
+    are collected in an epoll instance and only its fd is handed to
+    GLib, so the cost of a main loop iteration doesn't grow with the
+    number of open devices.
+ */
 class USBGSource
 {
 private:
   GSourceFuncs m_source_funcs;
   GUSBSource* m_source;
   gint m_source_id;
-  std::list<GPollFD*> m_pollfds;
+
+  /** controllers are opened from the daemon's bring-up threads, so
+      libusb can add and remove pollfds from outside the main loop,
+      epoll_ctl() is safe to call from any thread */
+  int m_epoll_fd;
+  GPollFD m_epoll_pollfd;
 
 public:
   USBGSource();
@@ -86,12 +86,12 @@ const char* usb_transfer_strerror(libusb_transfer_status err)
   }
 }
 
-libusb_device* usb_find_device_by_path(uint8_t busnum, uint8_t devnum)
+libusb_device* usb_find_device_by_path(uint8_t busnum, uint8_t devnum, libusb_context* ctx)
 {
   libusb_device* ret_device = 0;
 
   libusb_device** list;
-  ssize_t num_devices = libusb_get_device_list(NULL, &list);
+  ssize_t num_devices = libusb_get_device_list(ctx, &list);
   for(ssize_t dev_it = 0; dev_it < num_devices; ++dev_it)
   {
     libusb_device* dev = list[dev_it];
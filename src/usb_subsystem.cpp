@@ -195,24 +195,21 @@ USBSubsystem::find_xbox360_controller(int id, libusb_device** xbox_device, XPadD
     }
     else
     {
-      for(int i = 0; i < xpad_devices_count; ++i)
+      XPadDevice dev_type;
+      if (find_xpad_device(desc.idVendor, desc.idProduct, &dev_type))
       {
-        if (desc.idVendor  == xpad_devices[i].idVendor &&
-            desc.idProduct == xpad_devices[i].idProduct)
+        if (id_count == id)
+        {
+          *xbox_device = dev;
+          *type        = dev_type;
+          // increment ref count, user must free the device
+          libusb_ref_device(*xbox_device);
+          libusb_free_device_list(list, 1 /* unref_devices */);
+          return true;
+        }
+        else
         {
-          if (id_count == id)
-          {
-            *xbox_device = dev;
-            *type        = xpad_devices[i];
-            // increment ref count, user must free the device
-            libusb_ref_device(*xbox_device);
-            libusb_free_device_list(list, 1 /* unref_devices */);
-            return true;
-          }
-          else
-          {
-            id_count += 1;
-          }
+          id_count += 1;
         }
       }
     }
@@ -23,51 +23,89 @@
 
 #include "helper.hpp"
 #include "raise_exception.hpp"
-#include "unpack.hpp"
 #include "usb_helper.hpp"
+#include "xbox360_wireless_receiver.hpp"
 #include "xboxmsg.hpp"
 
-Xbox360WirelessController::Xbox360WirelessController(libusb_device* dev, int controller_id,
-                                                     bool try_detach) :
-  USBController(dev),
-  m_endpoint(),
-  m_interface(),
+Xbox360WirelessController::Xbox360WirelessController(const boost::shared_ptr<Xbox360WirelessReceiver>& receiver,
+                                                     int controller_id) :
+  USBController(0),
+  m_receiver(receiver),
+  m_controller_id(controller_id),
   m_battery_status(),
   m_serial()
 {
   // FIXME: A little bit of a hack
   m_is_active = false;
 
-  assert(controller_id >= 0 && controller_id < 4);
+  assert(controller_id >= 0 && controller_id < Xbox360WirelessReceiver::kMaxPads);
 
-  // FIXME: Is hardcoding those ok?
-  m_endpoint  = controller_id*2 + 1;
-  m_interface = controller_id*2;
-
-  usb_claim_interface(m_interface, try_detach);
-  usb_submit_read(m_endpoint, 32);
+  if (m_receiver)
+  {
+    m_receiver->attach_pad(m_controller_id, this);
+  }
 }
 
 Xbox360WirelessController::~Xbox360WirelessController()
 {
+  if (m_receiver)
+  {
+    m_receiver->detach_pad(m_controller_id);
+  }
+}
+
+std::string
+Xbox360WirelessController::get_usbpath() const
+{
+  return m_receiver ? m_receiver->get_usbpath() : USBController::get_usbpath();
+}
+
+std::string
+Xbox360WirelessController::get_usbid() const
+{
+  return m_receiver ? m_receiver->get_usbid() : USBController::get_usbid();
+}
+
+std::string
+Xbox360WirelessController::get_name() const
+{
+  return m_receiver ? m_receiver->get_name() : USBController::get_name();
+}
+
+std::string
+Xbox360WirelessController::get_serial() const
+{
+  return m_serial;
+}
+
+int
+Xbox360WirelessController::get_error_count() const
+{
+  return m_receiver ? m_receiver->get_error_count() : 0;
+}
+
+uint8_t
+Xbox360WirelessController::get_battery_status() const
+{
+  return static_cast<uint8_t>(m_battery_status);
 }
 
 void
 Xbox360WirelessController::set_rumble_real(uint8_t left, uint8_t right)
 {
-  //                                       +-- typo? might be 0x0c, i.e. length
-  //                                       v
-  uint8_t rumblecmd[] = { 0x00, 0x01, 0x0f, 0xc0, 0x00, left, right, 0x00, 0x00, 0x00, 0x00, 0x00 };
-  usb_write(m_endpoint, rumblecmd, sizeof(rumblecmd));
+  if (m_receiver)
+  {
+    m_receiver->set_rumble(m_controller_id, left, right);
+  }
 }
 
 void
 Xbox360WirelessController::set_led_real(uint8_t status)
 {
-  //                                +--- Why not just status?
-  //                                v
-  uint8_t ledcmd[] = { 0x00, 0x00, 0x08, static_cast<uint8_t>(0x40 + (status % 0x0e)), 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-  usb_write(m_endpoint, ledcmd, sizeof(ledcmd));
+  if (m_receiver)
+  {
+    m_receiver->set_led(m_controller_id, status);
+  }
 }
 
 bool
@@ -85,6 +123,9 @@ Xbox360WirelessController::parse(uint8_t* data, int len, XboxGenericMsg* msg_out
       {
         log_info("connection status: nothing");
 
+        // the next controller in this slot announces its own serial
+        m_serial.clear();
+
         // reset the controller into neutral position on disconnect
         memset(msg_out, 0, sizeof(*msg_out));
         set_active(false);
@@ -128,48 +169,12 @@ Xbox360WirelessController::parse(uint8_t* data, int len, XboxGenericMsg* msg_out
         m_battery_status = data[17];
         log_info("Serial: " << m_serial);
         log_info("Battery Status: " << m_battery_status);
+        set_battery_level(m_battery_status * 100 / 255);
       }
       else if (data[0] == 0x00 && data[1] == 0x01 && data[2] == 0x00 && data[3] == 0xf0 && data[4] == 0x00 && data[5] == 0x13)
       { // Event message
         msg_out->type = XBOX_MSG_XBOX360;
-        Xbox360Msg& msg = msg_out->xbox360;
-
-        uint8_t* ptr = data+4;
-
-        msg.type   = ptr[0];
-        msg.length = ptr[1];
-
-        msg.dpad_up    = unpack::bit(ptr+2, 0);
-        msg.dpad_down  = unpack::bit(ptr+2, 1);
-        msg.dpad_left  = unpack::bit(ptr+2, 2);
-        msg.dpad_right = unpack::bit(ptr+2, 3);
-
-        msg.start   = unpack::bit(ptr+2, 4);
-        msg.back    = unpack::bit(ptr+2, 5);
-        msg.thumb_l = unpack::bit(ptr+2, 6);
-        msg.thumb_r = unpack::bit(ptr+2, 7);
-
-        msg.lb     = unpack::bit(ptr+3, 0);
-        msg.rb     = unpack::bit(ptr+3, 1);
-        msg.guide  = unpack::bit(ptr+3, 2);
-        msg.dummy1 = unpack::bit(ptr+3, 3);
-
-        msg.a = unpack::bit(ptr+3, 4);
-        msg.b = unpack::bit(ptr+3, 5);
-        msg.x = unpack::bit(ptr+3, 6);
-        msg.y = unpack::bit(ptr+3, 7);
-
-        msg.lt = ptr[4];
-        msg.rt = ptr[5];
-
-        msg.x1 = unpack::int16le(ptr+6);
-        msg.y1 = unpack::int16le(ptr+8);
-
-        msg.x2 = unpack::int16le(ptr+10);
-        msg.y2 = unpack::int16le(ptr+12);
-
-        msg.dummy2 = unpack::int32le(ptr+14);
-        msg.dummy3 = unpack::int16le(ptr+18);
+        unpack_xbox360_msg(data+4, &msg_out->xbox360);
 
         return true;
       }
@@ -177,6 +182,7 @@ Xbox360WirelessController::parse(uint8_t* data, int len, XboxGenericMsg* msg_out
       { // Battery status
         m_battery_status = data[4];
         log_info("battery status: " << m_battery_status);
+        set_battery_level(m_battery_status * 100 / 255);
       }
       else if (data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x00 && data[3] == 0xf0)
       {
@@ -19,30 +19,48 @@
 #ifndef HEADER_XBOX360_WIRELESS_CONTROLLER_HPP
 #define HEADER_XBOX360_WIRELESS_CONTROLLER_HPP
 
+#include <boost/shared_ptr.hpp>
 #include <libusb.h>
 #include <string>
 
 #include "usb_controller.hpp"
 
+class Xbox360WirelessReceiver;
 struct XboxGenericMsg;
 struct XPadDevice;
 
 class Xbox360WirelessController : public USBController
 {
 private:
-  int  m_endpoint;
-  int  m_interface;
+  boost::shared_ptr<Xbox360WirelessReceiver> m_receiver;
+  int  m_controller_id;
   int  m_battery_status;
   std::string m_serial;
 
 public:
-  Xbox360WirelessController(libusb_device* dev, int controller_id, bool try_detach);
+  /** The controller \a controller_id of \a receiver, an offline
+      controller when \a receiver is empty */
+  Xbox360WirelessController(const boost::shared_ptr<Xbox360WirelessReceiver>& receiver,
+                            int controller_id);
   virtual ~Xbox360WirelessController();
 
+  /** The receiver the controller is connected through, empty for an
+      offline controller */
+  const boost::shared_ptr<Xbox360WirelessReceiver>& get_receiver() const { return m_receiver; }
+
+  std::string get_usbpath() const;
+  std::string get_usbid() const;
+  std::string get_name() const;
+  /** The serial from the controllers announce message, empty until
+      that arrived and again once the controller disconnected */
+  std::string get_serial() const;
+  int get_error_count() const;
+
   bool parse(uint8_t* data, int len, XboxGenericMsg* msg_out);
 
   void set_rumble_real(uint8_t left, uint8_t right);
   void set_led_real(uint8_t status);
+  /** The raw battery status, from 0 (empty) to 255 (full) */
   uint8_t get_battery_status() const;
 
 private:
@@ -0,0 +1,138 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "xbox360_wireless_receiver.hpp"
+
+#include <assert.h>
+
+#include "log.hpp"
+#include "xbox360_wireless_controller.hpp"
+
+namespace {
+
+// FIXME: Is hardcoding those ok?
+int pad_endpoint(int id)  { return id*2 + 1; }
+int pad_interface(int id) { return id*2; }
+
+} // namespace
+
+Xbox360WirelessReceiver::Xbox360WirelessReceiver(libusb_device* dev, bool try_detach) :
+  USBController(dev),
+  m_try_detach(try_detach),
+  m_pads_mutex()
+{
+  g_mutex_init(&m_pads_mutex);
+
+  for(int i = 0; i < kMaxPads; ++i)
+  {
+    m_pads[i] = 0;
+  }
+}
+
+Xbox360WirelessReceiver::~Xbox360WirelessReceiver()
+{
+  g_mutex_clear(&m_pads_mutex);
+}
+
+void
+Xbox360WirelessReceiver::attach_pad(int id, Xbox360WirelessController* pad)
+{
+  assert(id >= 0 && id < kMaxPads);
+
+  g_mutex_lock(&m_pads_mutex);
+  assert(!m_pads[id]);
+  m_pads[id] = pad;
+  g_mutex_unlock(&m_pads_mutex);
+
+  try
+  {
+    usb_claim_interface(pad_interface(id), m_try_detach);
+    usb_submit_read(pad_endpoint(id), 32);
+  }
+  catch(...)
+  {
+    detach_pad(id);
+    throw;
+  }
+}
+
+void
+Xbox360WirelessReceiver::detach_pad(int id)
+{
+  // the read of the pad keeps going until the receiver itself is
+  // destroyed, its reports are dropped from now on
+  g_mutex_lock(&m_pads_mutex);
+  m_pads[id] = 0;
+  g_mutex_unlock(&m_pads_mutex);
+}
+
+void
+Xbox360WirelessReceiver::set_rumble(int id, uint8_t left, uint8_t right)
+{
+  //                                       +-- typo? might be 0x0c, i.e. length
+  //                                       v
+  uint8_t rumblecmd[] = { 0x00, 0x01, 0x0f, 0xc0, 0x00, left, right, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  usb_write(pad_endpoint(id), rumblecmd, sizeof(rumblecmd));
+}
+
+void
+Xbox360WirelessReceiver::set_led(int id, uint8_t status)
+{
+  //                                +--- Why not just status?
+  //                                v
+  uint8_t ledcmd[] = { 0x00, 0x00, 0x08, static_cast<uint8_t>(0x40 + (status % 0x0e)), 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  usb_write(pad_endpoint(id), ledcmd, sizeof(ledcmd));
+}
+
+void
+Xbox360WirelessReceiver::send_disconnect()
+{
+  USBController::send_disconnect();
+
+  g_mutex_lock(&m_pads_mutex);
+  for(int i = 0; i < kMaxPads; ++i)
+  {
+    if (m_pads[i])
+    {
+      m_pads[i]->send_disconnect();
+    }
+  }
+  g_mutex_unlock(&m_pads_mutex);
+}
+
+void
+Xbox360WirelessReceiver::receive_report(uint8_t endpoint, uint8_t* data, int len)
+{
+  int id = ((endpoint & 0x7f) - 1) / 2;
+  if (id < 0 || id >= kMaxPads)
+  {
+    log_debug("report from unexpected endpoint: " << static_cast<int>(endpoint));
+  }
+  else
+  {
+    g_mutex_lock(&m_pads_mutex);
+    if (m_pads[id])
+    {
+      m_pads[id]->inject_report(data, len);
+    }
+    g_mutex_unlock(&m_pads_mutex);
+  }
+}
+
+/* EOF */
@@ -0,0 +1,86 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef HEADER_XBOX360_WIRELESS_RECEIVER_HPP
+#define HEADER_XBOX360_WIRELESS_RECEIVER_HPP
+
+#include <glib.h>
+#include <libusb.h>
+
+#include "usb_controller.hpp"
+
+class Xbox360WirelessController;
+
+/**
+    The wireless receiver that up to four Xbox360 controllers are
+    synced with. It opens the USB device once for all of them, reads
+    the endpoint of each attached pad and passes the reports,
+    including the connection and battery messages, on to that pad.
+    The LED and rumble commands of the pads are written through it
+    as well.
+
+    The receiver is shared by its pads and goes away with the last
+    of them, it isn't a controller of its own. Like the pads it has
+    to be made ready once all of them are constructed, see
+    ControllerFactory.
+ */
+class Xbox360WirelessReceiver : public USBController
+{
+public:
+  enum { kMaxPads = 4 };
+
+private:
+  bool m_try_detach;
+
+  /** pads are attached from the bring-up threads and detached
+      wherever they are destroyed, while reports are dispatched in
+      the main loop */
+  GMutex m_pads_mutex;
+  Xbox360WirelessController* m_pads[kMaxPads];
+
+public:
+  Xbox360WirelessReceiver(libusb_device* dev, bool try_detach);
+  virtual ~Xbox360WirelessReceiver();
+
+  /** Claim the interface of pad \a id and start reading it, the
+      reports go to \a pad until it is detached */
+  void attach_pad(int id, Xbox360WirelessController* pad);
+  void detach_pad(int id);
+
+  void set_rumble(int id, uint8_t left, uint8_t right);
+  void set_led(int id, uint8_t status);
+
+  /** Passes the disconnect of the receiver on to all attached pads */
+  virtual void send_disconnect();
+
+  bool parse(uint8_t* data, int len, XboxGenericMsg* msg_out) { return false; }
+  void set_rumble_real(uint8_t left, uint8_t right) {}
+  void set_led_real(uint8_t status) {}
+
+protected:
+  void receive_report(uint8_t endpoint, uint8_t* data, int len);
+
+private:
+  Xbox360WirelessReceiver(const Xbox360WirelessReceiver&);
+  Xbox360WirelessReceiver& operator=(const Xbox360WirelessReceiver&);
+};
+
+#endif
+
+/* EOF */
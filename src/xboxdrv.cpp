@@ -20,10 +20,8 @@
 
 #include <boost/algorithm/string/join.hpp>
 #include <boost/format.hpp>
-#include <boost/scoped_array.hpp>
 #include <errno.h>
 #include <iostream>
-#include <sched.h>
 #include <signal.h>
 #include <stdio.h>
 #include <sys/types.h>
@@ -37,6 +35,8 @@
 #include "evdev_helper.hpp"
 #include "helper.hpp"
 #include "raise_exception.hpp"
+#include "scheduling.hpp"
+#include "spawn_service.hpp"
 #include "uinput_message_processor.hpp"
 #include "usb_gsource.hpp"
 #include "usb_helper.hpp"
@@ -72,38 +72,34 @@ Xboxdrv::run_list_controller()
     // FIXME: we silently ignore failures
     if (libusb_get_device_descriptor(dev, &desc) == LIBUSB_SUCCESS)
     {
-      for(int i = 0; i < xpad_devices_count; ++i)
+      XPadDevice dev_type;
+      if (find_xpad_device(desc.idVendor, desc.idProduct, &dev_type))
       {
-        if (desc.idVendor  == xpad_devices[i].idVendor &&
-            desc.idProduct == xpad_devices[i].idProduct)
+        if (dev_type.type == GAMEPAD_XBOX360_WIRELESS)
         {
-          if (xpad_devices[i].type == GAMEPAD_XBOX360_WIRELESS)
+          for(int wid = 0; wid < 4; ++wid)
           {
-            for(int wid = 0; wid < 4; ++wid)
-            {
-              std::cout << boost::format(" %2d |  %2d |   0x%04x |    0x%04x | %s (Port: %s)")
-                % id
-                % wid
-                % int(xpad_devices[i].idVendor)
-                % int(xpad_devices[i].idProduct)
-                % xpad_devices[i].name
-                % wid
-                        << std::endl;
-            }
-          }
-          else
-          {
-            std::cout << boost::format(" %2d |  %2d |   0x%04x |    0x%04x | %s")
+            std::cout << boost::format(" %2d |  %2d |   0x%04x |    0x%04x | %s (Port: %s)")
               % id
-              % 0
-              % int(xpad_devices[i].idVendor)
-              % int(xpad_devices[i].idProduct)
-              % xpad_devices[i].name
+              % wid
+              % int(dev_type.idVendor)
+              % int(dev_type.idProduct)
+              % dev_type.name
+              % wid
                       << std::endl;
           }
-          id += 1;
-          break;
         }
+        else
+        {
+          std::cout << boost::format(" %2d |  %2d |   0x%04x |    0x%04x | %s")
+            % id
+            % 0
+            % int(dev_type.idVendor)
+            % int(dev_type.idProduct)
+            % dev_type.name
+                    << std::endl;
+        }
+        id += 1;
       }
     }
   }
@@ -117,47 +113,29 @@ Xboxdrv::run_list_controller()
 void
 Xboxdrv::run_list_supported_devices()
 {
-  for(int i = 0; i < xpad_devices_count; ++i)
+  const std::vector<XPadDevice>& devices = get_xpad_devices();
+  for(std::vector<XPadDevice>::const_iterator i = devices.begin(); i != devices.end(); ++i)
   {
     std::cout << boost::format("%s 0x%04x 0x%04x %s\n")
-      % gamepadtype_to_string(xpad_devices[i].type)
-      % int(xpad_devices[i].idVendor)
-      % int(xpad_devices[i].idProduct)
-      % xpad_devices[i].name;
+      % gamepadtype_to_string(i->type)
+      % int(i->idVendor)
+      % int(i->idProduct)
+      % i->name;
   }
 }
 
-bool xpad_device_sorter(const XPadDevice& lhs, const XPadDevice& rhs)
-{
-  if (lhs.idVendor < rhs.idVendor)
-  {
-    return true;
-  }
-  else if (lhs.idVendor == rhs.idVendor)
-  {
-    return lhs.idProduct < rhs.idProduct;
-  }
-  else
-  {
-    return false;
-  }
-}
-
 void
 Xboxdrv::run_list_supported_devices_xpad()
 {
-  boost::scoped_array<XPadDevice> sorted_devices(new XPadDevice[xpad_devices_count]);
-  memcpy(sorted_devices.get(), xpad_devices, sizeof(XPadDevice) * xpad_devices_count);
-
-  std::sort(sorted_devices.get(), sorted_devices.get() + xpad_devices_count, xpad_device_sorter);
-
-  for(int i = 0; i < xpad_devices_count; ++i)
+  // the device index is already sorted by vendor:product
+  const std::vector<XPadDevice>& devices = get_xpad_devices();
+  for(std::vector<XPadDevice>::const_iterator i = devices.begin(); i != devices.end(); ++i)
   {
     std::cout << boost::format("{ 0x%04x, 0x%04x, \"%s\", %s },\n")
-      % int(sorted_devices[i].idVendor)
-      % int(sorted_devices[i].idProduct)
-      % sorted_devices[i].name
-      % gamepadtype_to_macro_string(sorted_devices[i].type);
+      % int(i->idVendor)
+      % int(i->idProduct)
+      % i->name
+      % gamepadtype_to_macro_string(i->type);
   }
 }
 
@@ -166,12 +144,13 @@ Xboxdrv::run_help_devices()
 {
   std::cout << " idVendor | idProduct | Name" << std::endl;
   std::cout << "----------+-----------+---------------------------------" << std::endl;
-  for(int i = 0; i < xpad_devices_count; ++i)
+  const std::vector<XPadDevice>& devices = get_xpad_devices();
+  for(std::vector<XPadDevice>::const_iterator i = devices.begin(); i != devices.end(); ++i)
   {
     std::cout << boost::format("   0x%04x |    0x%04x | %s")
-      % int(xpad_devices[i].idVendor)
-      % int(xpad_devices[i].idProduct)
-      % xpad_devices[i].name
+      % int(i->idVendor)
+      % int(i->idProduct)
+      % i->name
               << std::endl;
   }
 }
@@ -189,6 +168,16 @@ Xboxdrv::print_copyright() const
   wrap.newline();
 }
 
+void
+Xboxdrv::start_spawn_service(const Options& opts)
+{
+  // started before anything opens devices, so the helper process
+  // stays small
+  g_spawn_service.set_rate_limit(opts.exec_rate);
+  g_spawn_service.set_debounce(opts.exec_debounce);
+  g_spawn_service.start();
+}
+
 void
 Xboxdrv::run_main(const Options& opts)
 {
@@ -197,6 +186,9 @@ Xboxdrv::run_main(const Options& opts)
     print_copyright();
   }
 
+  start_spawn_service(opts);
+  g_scheduling.enter_input_thread(opts);
+
   USBSubsystem usb_subsystem;
   XboxdrvMain xboxdrv_main(opts);
   xboxdrv_main.run();
@@ -217,6 +209,9 @@ Xboxdrv::run_daemon(const Options& opts)
 
   if (!opts.detach)
   {
+    start_spawn_service(opts);
+    g_scheduling.enter_input_thread(opts);
+
     USBSubsystem usb_subsystem;
     XboxdrvDaemon daemon(opts);
     daemon.run();
@@ -249,6 +244,9 @@ Xboxdrv::run_daemon(const Options& opts)
         }
         else
         {
+          start_spawn_service(opts);
+          g_scheduling.enter_input_thread(opts);
+
           USBSubsystem usb_subsystem;
           XboxdrvDaemon daemon(opts);
           daemon.run();
@@ -332,32 +330,6 @@ Xboxdrv::~Xboxdrv()
 {
 }
 
-void
-Xboxdrv::set_scheduling(const Options& opts)
-{
-  if (opts.priority == Options::kPriorityRealtime)
-  {
-    // try to set realtime priority when root, as user there doesn't
-    // seem to be a way to increase the priority
-    log_info("enabling realtime priority scheduling");
-
-    int policy = SCHED_RR;
-
-    struct sched_param param;
-    memset(&param, 0, sizeof(struct sched_param));
-    param.sched_priority = sched_get_priority_max(policy);
-
-    // we don't try SCHED_OTHER for users as min and max priority is
-    // 0 for that, thus we can't change anything with that
-
-    int ret;
-    if ((ret = sched_setscheduler(getpid(), policy, &param)) != 0)
-    {
-      raise_exception(std::runtime_error, "sched_setschedparam() failed: " << strerror(errno));
-    }
-  }
-}
-
 int
 Xboxdrv::main(int argc, char** argv)
 {
@@ -368,8 +340,6 @@ Xboxdrv::main(int argc, char** argv)
     CommandLineParser cmd_parser;
     cmd_parser.parse_args(argc, argv, &opts);
 
-    set_scheduling(opts);
-
     switch(opts.mode)
     {
       case Options::PRINT_HELP_DEVICES:
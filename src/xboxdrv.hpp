@@ -30,6 +30,7 @@ class Controller;
 class Xboxdrv
 {
 private:
+  void start_spawn_service(const Options& opts);
   void run_main(const Options& opts);
   void run_daemon(const Options& opts);
   void run_list_supported_devices();
@@ -45,9 +46,6 @@ public:
   ~Xboxdrv();
 
   int main(int argc, char** argv);
-
-private:
-  void set_scheduling(const Options& opts);
 };
 
 #endif
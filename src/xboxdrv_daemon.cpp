@@ -29,11 +29,17 @@
 
 #include "helper.hpp"
 #include "raise_exception.hpp"
+#include "scheduling.hpp"
 #include "select.hpp"
+#include "spawn_service.hpp"
+#include "state_publisher.hpp"
+#include "synthetic_controller.hpp"
 #include "uinput.hpp"
+#include "usb_context_pool.hpp"
 #include "usb_helper.hpp"
 #include "usb_gsource.hpp"
 #include "controller_factory.hpp"
+#include "controller_match_index.hpp"
 #include "controller_slot.hpp"
 #include "controller.hpp"
 #include "udev_subsystem.hpp"
@@ -42,66 +48,44 @@
 
 XboxdrvDaemon* XboxdrvDaemon::s_current = 0;
 
-namespace {
-
-bool get_usb_id(udev_device* device, uint16_t* vendor_id, uint16_t* product_id)
+/** A device waiting to be opened by the bring-up pool, the worker
+    fills in either controllers or error */
+struct XboxdrvDaemon::BringUpJob
 {
-  const char* vendor_id_str  = udev_device_get_property_value(device, "ID_VENDOR_ID");
-  if (!vendor_id_str)
-  {
-    return false;
-  }
-  else
-  {
-    *vendor_id = hexstr2int(vendor_id_str);
-  }
-
-  const char* product_id_str = udev_device_get_property_value(device, "ID_MODEL_ID");
-  if (!product_id_str)
-  {
-    return false;
-  }
-  else
-  {
-    *product_id = hexstr2int(product_id_str);
-  }
-
-  return true;
-}
-
-bool get_usb_path(udev_device* device, int* bus, int* dev)
+  BringUpJob(XboxdrvDaemon* daemon_, const ControllerMatchInfo& info_, const XPadDevice& dev_type_) :
+    daemon(daemon_),
+    info(info_),
+    dev_type(dev_type_),
+    controllers(),
+    error()
+  {}
+
+  XboxdrvDaemon* daemon;
+  ControllerMatchInfo info;
+  XPadDevice dev_type;
+  std::vector<ControllerPtr> controllers;
+  std::string error;
+
+private:
+  BringUpJob(const BringUpJob&);
+  BringUpJob& operator=(const BringUpJob&);
+};
+
+gboolean
+XboxdrvDaemon::on_bringup_done_wrap(gpointer data)
 {
-  // busnum:devnum are decimal, not hex
-  const char* busnum_str = udev_device_get_property_value(device, "BUSNUM");
-  if (!busnum_str)
-  {
-    return false;
-  }
-  else
-  {
-    *bus = boost::lexical_cast<int>(busnum_str);
-  }
-
-  const char* devnum_str = udev_device_get_property_value(device, "DEVNUM");
-  if (!devnum_str)
-  {
-    return false;
-  }
-  else
-  {
-    *dev = boost::lexical_cast<int>(devnum_str);
-  }
-
-  return true;
+  BringUpJob* job = static_cast<BringUpJob*>(data);
+  job->daemon->on_bringup_done(job);
+  return false;
 }
-
-} // namespace
 
 XboxdrvDaemon::XboxdrvDaemon(const Options& opts) :
   m_opts(opts),
   m_gmain(),
   m_controller_slots(),
   m_inactive_controllers(),
+  m_match_index(new ControllerMatchIndex),
+  m_bringup_pool(),
   m_uinput()
 {
   assert(!s_current);
@@ -113,6 +97,17 @@ XboxdrvDaemon::XboxdrvDaemon(const Options& opts) :
 
   m_gmain = g_main_loop_new(NULL, false);
 
+  GError* error = NULL;
+  m_bringup_pool = g_thread_pool_new(&XboxdrvDaemon::on_bringup_job_wrap, this,
+                                     kBringUpThreads, false, &error);
+  if (!m_bringup_pool)
+  {
+    std::ostringstream out;
+    out << "failed to create controller bring-up pool: " << error->message;
+    g_error_free(error);
+    throw std::runtime_error(out.str());
+  }
+
   signal(SIGINT,  &XboxdrvDaemon::on_sigint);
   signal(SIGTERM, &XboxdrvDaemon::on_sigint);
 }
@@ -125,6 +120,19 @@ XboxdrvDaemon::~XboxdrvDaemon()
   assert(s_current);
   s_current = 0;
 
+  if (m_bringup_pool)
+  {
+    g_thread_pool_free(m_bringup_pool, false, true);
+  }
+
+  // the controllers have to close their devices before the USB
+  // contexts they were opened in go away
+  m_inactive_controllers.clear();
+  m_controller_slots.clear();
+  g_usb_contexts.stop();
+
+  g_state_publisher.close();
+
   g_main_loop_unref(m_gmain);
 }
 
@@ -137,6 +145,16 @@ XboxdrvDaemon::run()
 
     init_uinput();
 
+    if (m_opts.usb_contexts > 0)
+    {
+      g_usb_contexts.start(m_opts.usb_contexts, m_opts.usb_context_by_bus);
+    }
+
+    if (m_opts.synthetic_type != GAMEPAD_UNKNOWN)
+    {
+      add_synthetic_controllers();
+    }
+
     UdevSubsystem udev_subsystem;
     udev_subsystem.set_device_callback(boost::bind(&XboxdrvDaemon::process_match, this, _1));
 
@@ -181,6 +199,16 @@ XboxdrvDaemon::run()
     g_main_loop_run(m_gmain);
     log_debug("main loop exited");
 
+    // wait for controllers that are still being brought up and
+    // discard them, on_bringup_done() ignores them as the main loop
+    // is no longer running
+    g_thread_pool_free(m_bringup_pool, false, true);
+    m_bringup_pool = 0;
+    while(g_main_context_pending(NULL))
+    {
+      g_main_context_iteration(NULL, false);
+    }
+
     // get rid of active ControllerThreads before the subsystems shutdown
     m_inactive_controllers.clear();
     m_controller_slots.clear();
@@ -197,26 +225,24 @@ XboxdrvDaemon::process_match(struct udev_device* device)
   // FIXME: bad place?!
   // FIXME: cleanup_threads();
 
-  uint16_t vendor;
-  uint16_t product;
+  // extract the device attributes once for all the checks below
+  ControllerMatchInfo info(device);
 
-  if (!get_usb_id(device, &vendor, &product))
+  if (!info.has_usbid)
   {
     log_warn("couldn't get vendor:product, ignoring device");
   }
   else
   {
     XPadDevice dev_type;
-    if (!find_xpad_device(vendor, product, &dev_type))
+    if (!find_xpad_device(info.vendor, info.product, &dev_type))
     {
-      log_debug("ignoring " << boost::format("%04x:%04x") % vendor % product <<
+      log_debug("ignoring " << boost::format("%04x:%04x") % info.vendor % info.product <<
                 " not a valid Xboxdrv device");
     }
     else
     {
-      int bus;
-      int dev;
-      if (!get_usb_path(device, &bus, &dev))
+      if (!info.has_usbpath)
       {
         log_warn("couldn't get bus:dev");
       }
@@ -224,7 +250,7 @@ XboxdrvDaemon::process_match(struct udev_device* device)
       {
         try
         {
-          launch_controller_thread(device, dev_type, bus, dev);
+          launch_controller_thread(info, dev_type);
         }
         catch(const std::exception& err)
         {
@@ -252,6 +278,9 @@ XboxdrvDaemon::init_uinput()
 
     m_uinput.reset(new UInput(m_opts.extra_events));
     m_uinput->set_device_names(m_opts.uinput_device_names);
+    m_uinput->set_wheel_hi_res(m_opts.wheel_hi_res);
+    m_uinput->set_rel_rate(m_opts.rel_rate);
+    m_uinput->set_backend(m_opts.uinput_backend);
 
     // create controller slots
     int slot_count = 0;
@@ -274,9 +303,45 @@ XboxdrvDaemon::init_uinput()
 
     log_info("created " << m_controller_slots.size() << " controller slots");
 
+    // compile the match rules of all slots into a single index
+    m_match_index->clear();
+    for(ControllerSlots::const_iterator i = m_controller_slots.begin(); i != m_controller_slots.end(); ++i)
+    {
+      m_match_index->add_slot((*i)->get_id(), (*i)->get_rules());
+    }
+
     // After all the ControllerConfig registered their events, finish up
     // the device creation
     m_uinput->finish();
+
+    if (!m_opts.state_shm.empty())
+    {
+      g_state_publisher.open(m_opts.state_shm, m_controller_slots.size());
+    }
+  }
+}
+
+void
+XboxdrvDaemon::add_synthetic_controllers()
+{
+  log_info("creating " << m_opts.synthetic_count << " synthetic controllers");
+
+  for(int id = 0; id < m_opts.synthetic_count; ++id)
+  {
+    ControllerPtr controller = ControllerFactory::create_synthetic(id, m_opts);
+    const XPadDevice& dev_type = dynamic_cast<SyntheticController&>(*controller).get_dev_type();
+
+    // there is no udev device, so fill in what the match rules look
+    // at by hand, the bus:dev is the one from get_usbpath()
+    ControllerMatchInfo info(0);
+    info.has_usbid = true;
+    info.vendor  = dev_type.idVendor;
+    info.product = dev_type.idProduct;
+    info.has_usbpath = true;
+    info.busnum = 0;
+    info.devnum = id + 1;
+
+    add_controllers(info, dev_type, std::vector<ControllerPtr>(1, controller));
   }
 }
 
@@ -299,31 +364,25 @@ XboxdrvDaemon::create_pid_file()
 }
 
 ControllerSlotPtr
-XboxdrvDaemon::find_free_slot(udev_device* dev)
+XboxdrvDaemon::find_free_slot(const ControllerMatchInfo& info)
 {
   // first pass, look for slots where the rules match the given vendor:product, bus:dev
-  for(ControllerSlots::iterator i = m_controller_slots.begin(); i != m_controller_slots.end(); ++i)
+  std::vector<int> slots = m_match_index->find(info);
+  for(std::vector<int>::const_iterator i = slots.begin(); i != slots.end(); ++i)
   {
-    if (!(*i)->is_connected())
+    if (!m_controller_slots[*i]->is_connected())
     {
-      // found a free slot, check if the rules match
-      for(std::vector<ControllerMatchRulePtr>::const_iterator rule = (*i)->get_rules().begin();
-          rule != (*i)->get_rules().end(); ++rule)
-      {
-        if ((*rule)->match(dev))
-        {
-          return *i;
-        }
-      }
+      return m_controller_slots[*i];
     }
   }
 
   // second pass, look for slots that don't have any rules and thus match everything
-  for(ControllerSlots::iterator i = m_controller_slots.begin(); i != m_controller_slots.end(); ++i)
+  const std::vector<int>& match_all = m_match_index->get_match_all();
+  for(std::vector<int>::const_iterator i = match_all.begin(); i != match_all.end(); ++i)
   {
-    if (!(*i)->is_connected() && (*i)->get_rules().empty())
+    if (!m_controller_slots[*i]->is_connected())
     {
-      return *i;
+      return m_controller_slots[*i];
     }
   }
 
@@ -332,56 +391,127 @@ XboxdrvDaemon::find_free_slot(udev_device* dev)
 }
 
 void
-XboxdrvDaemon::launch_controller_thread(udev_device* udev_dev,
-                                        const XPadDevice& dev_type,
-                                        uint8_t busnum, uint8_t devnum)
+XboxdrvDaemon::launch_controller_thread(const ControllerMatchInfo& info,
+                                        const XPadDevice& dev_type)
 {
-  // FIXME: results must be libusb_unref_device()'ed
-  libusb_device* dev = usb_find_device_by_path(busnum, devnum);
+  // Opening the device, reading its descriptors and claiming the
+  // interfaces blocks on USB control transfers, so it is done on the
+  // bring-up pool, the main loop only gets the finished controllers
+  BringUpJob* job = new BringUpJob(this, info, dev_type);
+  udev_device_ref(job->info.device);
+
+  GError* error = NULL;
+  if (!g_thread_pool_push(m_bringup_pool, job, &error))
+  {
+    std::string msg = error ? error->message : "unknown error";
+    if (error)
+    {
+      g_error_free(error);
+    }
 
-  if (!dev)
+    udev_device_unref(job->info.device);
+    delete job;
+
+    raise_exception(std::runtime_error, "failed to queue controller bring-up: " << msg);
+  }
+}
+
+void
+XboxdrvDaemon::on_bringup_job(BringUpJob* job)
+{
+  // runs in a worker thread, must not touch anything but the job
+  g_scheduling.enter_background_thread();
+
+  try
+  {
+    // FIXME: results must be libusb_unref_device()'ed
+    libusb_device* dev = usb_find_device_by_path(job->info.busnum, job->info.devnum,
+                                                 g_usb_contexts.get_context(job->info.busnum,
+                                                                            job->info.devnum));
+
+    if (!dev)
+    {
+      job->error = "USB device disappeared before it could be opened";
+    }
+    else
+    {
+      job->controllers = ControllerFactory::create_multiple(job->dev_type, dev, m_opts);
+    }
+  }
+  catch(const std::exception& err)
   {
-    log_error("USB device disappeared before it could be opened");
+    job->error = err.what();
+  }
+
+  g_idle_add(&XboxdrvDaemon::on_bringup_done_wrap, job);
+}
+
+void
+XboxdrvDaemon::on_bringup_done(BringUpJob* job)
+{
+  if (!job->error.empty())
+  {
+    log_error("failed to launch ControllerThread: " << job->error);
+  }
+  else if (!g_main_loop_is_running(m_gmain))
+  {
+    log_debug("shutting down, discarding controllers for " << job->info.busnum << ":" << job->info.devnum);
   }
   else
   {
-    std::vector<ControllerPtr> controllers = ControllerFactory::create_multiple(dev_type, dev, m_opts);
-    for(std::vector<ControllerPtr>::iterator i = controllers.begin();
-        i != controllers.end();
-        ++i)
+    add_controllers(job->info, job->dev_type, job->controllers);
+  }
+
+  udev_device_unref(job->info.device);
+  delete job;
+}
+
+void
+XboxdrvDaemon::add_controllers(const ControllerMatchInfo& info,
+                               const XPadDevice& dev_type,
+                               const std::vector<ControllerPtr>& controllers)
+{
+  for(std::vector<ControllerPtr>::const_iterator i = controllers.begin();
+      i != controllers.end();
+      ++i)
+  {
+    const ControllerPtr& controller = *i;
+
+    if (controller->is_disconnected())
     {
-      ControllerPtr& controller = *i;
+      log_info("controller disconnected during bring-up: " << controller->get_usbpath());
+      continue;
+    }
 
-      controller->set_disconnect_cb(boost::bind(&g_idle_add, &XboxdrvDaemon::on_controller_disconnect_wrap, this));
-      controller->set_activation_cb(boost::bind(&g_idle_add, &XboxdrvDaemon::on_controller_activate_wrap, this));
+    controller->set_disconnect_cb(boost::bind(&g_idle_add, &XboxdrvDaemon::on_controller_disconnect_wrap, this));
+    controller->set_activation_cb(boost::bind(&g_idle_add, &XboxdrvDaemon::on_controller_activate_wrap, this));
 
-      // FIXME: Little dirty hack
-      controller->set_udev_device(udev_dev);
+    // FIXME: Little dirty hack
+    controller->set_udev_device(info.device);
 
-      if (controller->is_active())
+    if (controller->is_active())
+    {
+      // controller is active, so launch a thread if we have a free slot
+      ControllerSlotPtr slot = find_free_slot(info);
+      if (!slot)
       {
-        // controller is active, so launch a thread if we have a free slot
-        ControllerSlotPtr slot = find_free_slot(udev_dev);
-        if (!slot)
-        {
-          log_error("no free controller slot found, controller will be ignored: "
-                    << boost::format("%03d:%03d %04x:%04x '%s'")
-                    % static_cast<int>(busnum)
-                    % static_cast<int>(devnum)
-                    % dev_type.idVendor
-                    % dev_type.idProduct
-                    % dev_type.name);
-        }
-        else
-        {
-          connect(slot, controller);
-        }
+        log_error("no free controller slot found, controller will be ignored: "
+                  << boost::format("%03d:%03d %04x:%04x '%s'")
+                  % info.busnum
+                  % info.devnum
+                  % dev_type.idVendor
+                  % dev_type.idProduct
+                  % dev_type.name);
       }
-      else // if (!controller->is_active())
+      else
       {
-        m_inactive_controllers.push_back(controller);
+        connect(slot, controller);
       }
     }
+    else // if (!controller->is_active())
+    {
+      m_inactive_controllers.push_back(controller);
+    }
   }
 }
 
@@ -458,7 +588,7 @@ XboxdrvDaemon::on_connect(ControllerSlotPtr slot)
     args.push_back(controller->get_usbpath());
     args.push_back(controller->get_usbid());
     args.push_back(controller->get_name());
-    spawn_exe(args);
+    g_spawn_service.spawn(SpawnService::encode(args));
   }
 }
 
@@ -482,7 +612,7 @@ XboxdrvDaemon::on_disconnect(ControllerSlotPtr slot)
     args.push_back(controller->get_usbpath());
     args.push_back(controller->get_usbid());
     args.push_back(controller->get_name());
-    spawn_exe(args);
+    g_spawn_service.spawn(SpawnService::encode(args));
   }
 }
 
@@ -534,7 +664,7 @@ XboxdrvDaemon::on_controller_activate()
     {
       if ((*i)->is_active())
       {
-        ControllerSlotPtr slot = find_free_slot((*i)->get_udev_device());
+        ControllerSlotPtr slot = find_free_slot(ControllerMatchInfo((*i)->get_udev_device()));
         if (!slot)
         {
           log_info("couldn't find a free slot for activated controller");
@@ -561,22 +691,29 @@ XboxdrvDaemon::status()
 {
   std::ostringstream out;
 
-  out << boost::format("SLOT  CFG  NCFG    USBID    USBPATH  NAME\n");
+  out << boost::format("SLOT  CFG  NCFG   BAT  RATE  DROP    USBID    USBPATH  NAME\n");
   for(ControllerSlots::iterator i = m_controller_slots.begin(); i != m_controller_slots.end(); ++i)
   {
     if ((*i)->get_controller())
     {
-      out << boost::format("%4d  %3d  %4d  %5s  %7s  %s\n")
+      (*i)->update_status();
+      const PadStatus& status = (*i)->get_status();
+      int battery = status.get_battery_level();
+
+      out << boost::format("%4d  %3d  %4d  %4s  %4d  %4d  %5s  %7s  %s\n")
         % (i - m_controller_slots.begin())
         % (*i)->get_config()->get_current_config()
         % (*i)->get_config()->config_count()
+        % (battery < 0 ? std::string("-") : (boost::format("%d%%") % battery).str())
+        % status.get_report_rate()
+        % status.get_drops()
         % (*i)->get_controller()->get_usbid()
         % (*i)->get_controller()->get_usbpath()
         % (*i)->get_controller()->get_name();
     }
     else
     {
-      out << boost::format("%4d  %3d  %4d      -         -\n")
+      out << boost::format("%4d  %3d  %4d     -     -     -      -         -\n")
         % (i - m_controller_slots.begin())
         % (*i)->get_config()->get_current_config()
         % (*i)->get_config()->config_count();
@@ -585,7 +722,7 @@ XboxdrvDaemon::status()
 
   for(Controllers::iterator i = m_inactive_controllers.begin(); i != m_inactive_controllers.end(); ++i)
   {
-    out << boost::format("   -             %5s  %7s  %s\n")
+    out << boost::format("   -                               %5s  %7s  %s\n")
       % (*i)->get_usbid()
       % (*i)->get_usbpath()
       % (*i)->get_name();
@@ -29,9 +29,11 @@ extern "C" {
 #include "controller_slot_ptr.hpp"
 #include "controller_ptr.hpp"
 
+class ControllerMatchIndex;
 class Options;
 class UInput;
 class USBGSource;
+struct ControllerMatchInfo;
 struct XPadDevice;
 
 class XboxdrvDaemon
@@ -49,6 +51,14 @@ private:
   typedef std::vector<ControllerPtr> Controllers;
   Controllers m_inactive_controllers;
 
+  boost::scoped_ptr<ControllerMatchIndex> m_match_index;
+
+  /** controllers are opened and initialized in these threads, as
+      that blocks on USB control transfers */
+  enum { kBringUpThreads = 8 };
+  GThreadPool* m_bringup_pool;
+  struct BringUpJob;
+
   std::auto_ptr<UInput> m_uinput;
 
 private:
@@ -67,14 +77,19 @@ public:
 private:
   void create_pid_file();
   void init_uinput();
+  void add_synthetic_controllers();
 
-  ControllerSlotPtr find_free_slot(udev_device* dev);
+  ControllerSlotPtr find_free_slot(const ControllerMatchInfo& info);
 
   void process_match(struct udev_device* device);
   void print_info(struct udev_device* device);
-  void launch_controller_thread(udev_device* dev,
-                                const XPadDevice& dev_type,
-                                uint8_t busnum, uint8_t devnum);
+  void launch_controller_thread(const ControllerMatchInfo& info,
+                                const XPadDevice& dev_type);
+  void on_bringup_job(BringUpJob* job);
+  void on_bringup_done(BringUpJob* job);
+  void add_controllers(const ControllerMatchInfo& info,
+                       const XPadDevice& dev_type,
+                       const std::vector<ControllerPtr>& controllers);
   int get_free_slot_count() const;
 
   void connect(ControllerSlotPtr slot, ControllerPtr controller);
@@ -97,6 +112,12 @@ private:
     return false;
   }
 
+  static void on_bringup_job_wrap(gpointer data, gpointer user_data) {
+    static_cast<XboxdrvDaemon*>(user_data)->on_bringup_job(static_cast<BringUpJob*>(data));
+  }
+
+  static gboolean on_bringup_done_wrap(gpointer data);
+
 private:
   XboxdrvDaemon(const XboxdrvDaemon&);
   XboxdrvDaemon& operator=(const XboxdrvDaemon&);
@@ -35,6 +35,15 @@ xboxdrv_controller_error_quark()
 /* will create xboxdrv_g_controller_get_type and set xboxdrv_g_controller_parent_class */
 G_DEFINE_TYPE(XboxdrvGController, xboxdrv_g_controller, G_TYPE_OBJECT)
 
+enum {
+  BATTERY_CHANGED_SIGNAL,
+  LOW_BATTERY_SIGNAL,
+  CONNECTION_CHANGED_SIGNAL,
+  LAST_SIGNAL
+};
+
+static guint xboxdrv_g_controller_signals[LAST_SIGNAL];
+
 static GObject*
 xboxdrv_g_controller_constructor(GType                  gtype,
                                  guint                  n_properties,
@@ -50,6 +59,18 @@ xboxdrv_g_controller_class_init(XboxdrvGControllerClass* klass)
 {
   GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
   gobject_class->constructor = xboxdrv_g_controller_constructor;
+
+  // exported over D-Bus as the signals of the same name in
+  // xboxdrv_controller.xml
+  xboxdrv_g_controller_signals[BATTERY_CHANGED_SIGNAL] =
+    g_signal_new("battery-changed", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+                 g_cclosure_marshal_VOID__INT, G_TYPE_NONE, 1, G_TYPE_INT);
+  xboxdrv_g_controller_signals[LOW_BATTERY_SIGNAL] =
+    g_signal_new("low-battery", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+                 g_cclosure_marshal_VOID__INT, G_TYPE_NONE, 1, G_TYPE_INT);
+  xboxdrv_g_controller_signals[CONNECTION_CHANGED_SIGNAL] =
+    g_signal_new("connection-changed", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+                 g_cclosure_marshal_VOID__BOOLEAN, G_TYPE_NONE, 1, G_TYPE_BOOLEAN);
 }
 
 static void
@@ -136,4 +157,47 @@ xboxdrv_g_controller_set_config(XboxdrvGController* self, int config_num, GError
   }
 }
 
+gboolean
+xboxdrv_g_controller_get_status(XboxdrvGController* self, gchar** ret, GError** error)
+{
+  log_info("D-Bus: xboxdrv_g_controller_get_status(" << self << ")");
+
+  if (self->controller)
+  {
+    *ret = g_strdup(self->controller->get_status_str().c_str());
+    return TRUE;
+  }
+  else
+  {
+    g_set_error(error, XBOXDRV_CONTROLLER_ERROR, XBOXDRV_CONTROLLER_ERROR_FAILED,
+                "could't access controller");
+    return FALSE;
+  }
+}
+
+void
+xboxdrv_g_controller_send_status(XboxdrvGController* self, PadStatus::Event event)
+{
+  const PadStatus& status = self->controller->get_status();
+
+  switch(event)
+  {
+    case PadStatus::kConnected:
+    case PadStatus::kDisconnected:
+      g_signal_emit(self, xboxdrv_g_controller_signals[CONNECTION_CHANGED_SIGNAL], 0,
+                    static_cast<gboolean>(status.is_connected()));
+      break;
+
+    case PadStatus::kBatteryChanged:
+      g_signal_emit(self, xboxdrv_g_controller_signals[BATTERY_CHANGED_SIGNAL], 0,
+                    status.get_battery_level());
+      break;
+
+    case PadStatus::kLowBattery:
+      g_signal_emit(self, xboxdrv_g_controller_signals[LOW_BATTERY_SIGNAL], 0,
+                    status.get_battery_level());
+      break;
+  }
+}
+
 /* EOF */
@@ -21,6 +21,8 @@
 
 #include <glib-object.h>
 
+#include "pad_status.hpp"
+
 #pragma GCC diagnostic ignored "-Wold-style-cast"
 
 class ControllerSlot;
@@ -53,6 +55,10 @@ XboxdrvGController* xboxdrv_g_controller_new(ControllerSlot* controller);
 gboolean xboxdrv_g_controller_set_config(XboxdrvGController* self, int config_num, GError** error);
 gboolean xboxdrv_g_controller_set_led(XboxdrvGController* self, int status, GError** error);
 gboolean xboxdrv_g_controller_set_rumble(XboxdrvGController* self, int strong, int weak, GError** error);
+gboolean xboxdrv_g_controller_get_status(XboxdrvGController* self, gchar** ret, GError** error);
+
+/** Emits the D-Bus signal for \a event of the slot */
+void xboxdrv_g_controller_send_status(XboxdrvGController* self, PadStatus::Event event);
 
 #endif
 
@@ -28,12 +28,17 @@
 
 #include "controller_factory.hpp"
 #include "evdev_controller.hpp"
+#include "input_recorder.hpp"
 #include "message_processor.hpp"
 #include "uinput_message_processor.hpp"
 #include "dummy_message_processor.hpp"
 #include "options.hpp"
 #include "raise_exception.hpp"
+#include "replay_controller.hpp"
+#include "synthetic_controller.hpp"
+#include "state_publisher.hpp"
 #include "uinput.hpp"
+#include "usb_controller.hpp"
 #include "usb_helper.hpp"
 #include "usb_gsource.hpp"
 #include "usb_subsystem.hpp"
@@ -51,6 +56,7 @@ XboxdrvMain::XboxdrvMain(const Options& opts) :
   m_evdev_number(),
   m_use_libusb(false),
   m_dev_type(),
+  m_recorder(),
   m_controller()
 {
   assert(!s_current);
@@ -69,13 +75,34 @@ XboxdrvMain::~XboxdrvMain()
 
   s_current = 0;
 
+  g_state_publisher.close();
+
   g_main_loop_unref(m_gmain);
 }
 
 ControllerPtr
 XboxdrvMain::create_controller()
 {
-  if (!m_opts.evdev_device.empty())
+  if (!m_opts.record_file.empty() &&
+      (!m_opts.replay_file.empty() || !m_opts.evdev_device.empty() ||
+       m_opts.synthetic_type != GAMEPAD_UNKNOWN))
+  {
+    raise_exception(std::runtime_error, "--record only works with USB controllers");
+  }
+
+  if (!m_opts.replay_file.empty())
+  { // recorded USB reports
+    ReplayController* replay = new ReplayController(m_opts.replay_file, m_opts.replay_fast, m_opts);
+    m_dev_type = replay->get_dev_type();
+    return ControllerPtr(replay);
+  }
+  else if (m_opts.synthetic_type != GAMEPAD_UNKNOWN)
+  { // generated input, no hardware needed
+    ControllerPtr controller = ControllerFactory::create_synthetic(0, m_opts);
+    m_dev_type = dynamic_cast<SyntheticController&>(*controller).get_dev_type();
+    return controller;
+  }
+  else if (!m_opts.evdev_device.empty())
   { // normal PC joystick via evdev
     return ControllerPtr(new EvdevController(m_opts.evdev_device,
                                              m_opts.evdev_absmap,
@@ -108,7 +135,15 @@ XboxdrvMain::create_controller()
         print_info(dev, m_dev_type, m_opts);
       }
 
-      return ControllerFactory::create(m_dev_type, dev, m_opts);
+      ControllerPtr controller = ControllerFactory::create(m_dev_type, dev, m_opts);
+
+      if (!m_opts.record_file.empty())
+      {
+        m_recorder.reset(new InputRecorder(m_opts.record_file, m_dev_type));
+        dynamic_cast<USBController&>(*controller).set_recorder(m_recorder.get());
+      }
+
+      return controller;
     }
   }
 }
@@ -169,6 +204,9 @@ XboxdrvMain::run()
       m_uinput.reset(new UInput(m_opts.extra_events));
       m_uinput->set_device_names(m_opts.uinput_device_names);
       m_uinput->set_device_usbids(m_opts.uinput_device_usbids);
+      m_uinput->set_wheel_hi_res(m_opts.wheel_hi_res);
+      m_uinput->set_rel_rate(m_opts.rel_rate);
+      m_uinput->set_backend(m_opts.uinput_backend);
 
       log_debug("creating ControllerSlotConfig");
       ControllerSlotConfigPtr config_set = ControllerSlotConfig::create(*m_uinput,
@@ -180,7 +218,14 @@ XboxdrvMain::run()
       log_debug("finish UInput creation");
       m_uinput->finish();
 
-      message_proc.reset(new UInputMessageProcessor(*m_uinput, config_set, m_opts));
+      config_set->connect(*m_controller);
+      message_proc.reset(new UInputMessageProcessor(*m_uinput, config_set, 0, m_opts));
+
+      if (!m_opts.state_shm.empty())
+      {
+        g_state_publisher.open(m_opts.state_shm, 1);
+        g_state_publisher.set_connected(0, true);
+      }
     }
 
     if (!m_opts.quiet)
@@ -27,6 +27,7 @@
 #include "xpad_device.hpp"
 #include "controller_ptr.hpp"
 
+class InputRecorder;
 class MessageProcessor;
 class Options;
 class UInput;
@@ -53,6 +54,7 @@ private:
 
   XPadDevice m_dev_type;
 
+  boost::scoped_ptr<InputRecorder> m_recorder;
   ControllerPtr m_controller;
 
 public:
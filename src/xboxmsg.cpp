@@ -19,9 +19,15 @@
 #include "xboxmsg.hpp"
 
 #include <boost/format.hpp>
+#include <boost/static_assert.hpp>
 
 #include "helper.hpp"
 #include "raise_exception.hpp"
+#include "unpack.hpp"
+
+// the message structs mirror the reports byte for byte
+BOOST_STATIC_ASSERT(sizeof(Xbox360Msg) == 20);
+BOOST_STATIC_ASSERT(sizeof(XboxMsg) == 20);
 
 int16_t u8_to_s16(uint8_t value)
 {
@@ -103,6 +109,29 @@ std::string gamepadtype_to_macro_string(const GamepadType& type)
   }
 }
 
+GamepadType gamepadtype_from_string(const std::string& str)
+{
+  for(int i = GAMEPAD_XBOX; i <= GAMEPAD_GENERIC_USB; ++i)
+  {
+    if (str == gamepadtype_to_string(static_cast<GamepadType>(i)))
+    {
+      return static_cast<GamepadType>(i);
+    }
+  }
+
+  return GAMEPAD_UNKNOWN;
+}
+
+std::vector<std::string> gamepadtype_names()
+{
+  std::vector<std::string> names;
+  for(int i = GAMEPAD_XBOX; i <= GAMEPAD_GENERIC_USB; ++i)
+  {
+    names.push_back(gamepadtype_to_string(static_cast<GamepadType>(i)));
+  }
+  return names;
+}
+
 std::ostream& operator<<(std::ostream& out, const GamepadType& type)
 {
   switch (type)
@@ -1466,4 +1495,51 @@ int get_axis_max(XboxAxis axis)
   }
 }
 
+
+void unpack_xbox360_msg(const uint8_t* data, Xbox360Msg* msg)
+{
+#if __BYTE_ORDER == __BIG_ENDIAN
+  // bitfields are laid out from the top bit on big endian, so the
+  // fields have to be taken apart one by one
+  msg->type   = data[0];
+  msg->length = data[1];
+
+  msg->dpad_up    = unpack::bit(data+2, 0);
+  msg->dpad_down  = unpack::bit(data+2, 1);
+  msg->dpad_left  = unpack::bit(data+2, 2);
+  msg->dpad_right = unpack::bit(data+2, 3);
+
+  msg->start   = unpack::bit(data+2, 4);
+  msg->back    = unpack::bit(data+2, 5);
+  msg->thumb_l = unpack::bit(data+2, 6);
+  msg->thumb_r = unpack::bit(data+2, 7);
+
+  msg->lb     = unpack::bit(data+3, 0);
+  msg->rb     = unpack::bit(data+3, 1);
+  msg->guide  = unpack::bit(data+3, 2);
+  msg->dummy1 = unpack::bit(data+3, 3);
+
+  msg->a = unpack::bit(data+3, 4);
+  msg->b = unpack::bit(data+3, 5);
+  msg->x = unpack::bit(data+3, 6);
+  msg->y = unpack::bit(data+3, 7);
+
+  msg->lt = data[4];
+  msg->rt = data[5];
+
+  int16_t axes[4];
+  unpack::int16le_array(data+6, axes, 4);
+  msg->x1 = axes[0];
+  msg->y1 = axes[1];
+  msg->x2 = axes[2];
+  msg->y2 = axes[3];
+
+  msg->dummy2 = unpack::int32le(data+14);
+  msg->dummy3 = unpack::int16le(data+18);
+#else
+  // on little endian the struct is the report
+  memcpy(msg, data, sizeof(*msg));
+#endif
+}
+
 /* EOF */
@@ -20,6 +20,9 @@
 #define HEADER_XBOXMSG_HPP
 
 #include <iosfwd>
+#include <stdint.h>
+#include <string>
+#include <vector>
 
 enum GamepadType {
   GAMEPAD_UNKNOWN,
@@ -300,6 +303,17 @@ int get_axis_max(XboxAxis axis);
 
 std::string gamepadtype_to_string(const GamepadType& type);
 std::string gamepadtype_to_macro_string(const GamepadType& type);
+
+/** Inverse of gamepadtype_to_string(), returns GAMEPAD_UNKNOWN when
+    \a str doesn't name a type */
+GamepadType gamepadtype_from_string(const std::string& str);
+
+/** The names of all types that gamepadtype_from_string() accepts */
+std::vector<std::string> gamepadtype_names();
+
+/** Decode the 20 byte input report of a wired or wireless Xbox360
+    controller into \a msg */
+void unpack_xbox360_msg(const uint8_t* data, Xbox360Msg* msg);
 
 #endif
 
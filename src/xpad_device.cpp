@@ -17,130 +17,345 @@
 */
 
 #include "xpad_device.hpp"
+
+#include <algorithm>
+#include <boost/lexical_cast.hpp>
+#include <boost/tokenizer.hpp>
+#include <fstream>
+#include <list>
+#include <stdexcept>
+
+#include "helper.hpp"
+#include "ini_builder.hpp"
+#include "ini_parser.hpp"
+#include "log.hpp"
+#include "raise_exception.hpp"
 
 // FIXME: We shouldn't check device-ids, but device class or so, to
 // automatically catch all third party stuff
 XPadDevice xpad_devices[] = {
   // Evil?! Anymore info we could use to identify the devices?
-  // { GAMEPAD_XBOX,             0x0000, 0x0000, "Generic X-Box pad" },
-  // { GAMEPAD_XBOX,             0xffff, 0xffff, "Chinese-made Xbox Controller" },
+  // { GAMEPAD_XBOX,             0x0000, 0x0000, "Generic X-Box pad", 0, 0, XPAD_QUIRK_NONE },
+  // { GAMEPAD_XBOX,             0xffff, 0xffff, "Chinese-made Xbox Controller", 0, 0, XPAD_QUIRK_NONE },
 
   // These should work
-  { GAMEPAD_XBOX,             0x045e, 0x0202, "Microsoft X-Box pad v1 (US)" },
-  { GAMEPAD_XBOX,             0x045e, 0x0285, "Microsoft X-Box pad (Japan)" },
-  { GAMEPAD_XBOX,             0x045e, 0x0285, "Microsoft Xbox Controller S" },
-  { GAMEPAD_XBOX,             0x045e, 0x0287, "Microsoft Xbox Controller S" },
-  { GAMEPAD_XBOX,             0x045e, 0x0289, "Microsoft Corp. Xbox Controller S" },
-  // { GAMEPAD_XBOX,          0x045e, 0x0288, "Microsoft Corp. Xbox Controller S Hub" },  memory card slot
-  { GAMEPAD_XBOX,             0x046d, 0xca84, "Logitech Xbox Cordless Controller" },
-  { GAMEPAD_XBOX,             0x046d, 0xca88, "Logitech Compact Controller for Xbox" },
-  { GAMEPAD_XBOX,             0x05fd, 0x1007, "Mad Catz Controller (unverified)" },
-  { GAMEPAD_XBOX,             0x05fd, 0x107a, "InterAct 'PowerPad Pro' X-Box pad (Germany)" },
-  { GAMEPAD_XBOX,             0x0738, 0x4516, "Mad Catz Control Pad" },
-  { GAMEPAD_XBOX,             0x0738, 0x4522, "Mad Catz LumiCON" },
-  { GAMEPAD_XBOX,             0x0738, 0x4526, "Mad Catz Control Pad Pro" },
-  { GAMEPAD_XBOX,             0x0738, 0x4536, "Mad Catz MicroCON" },
-  { GAMEPAD_XBOX,             0x0738, 0x4556, "Mad Catz Lynx Wireless Controller" },
-  { GAMEPAD_XBOX,             0x0c12, 0x8802, "Zeroplus Xbox Controller" },
-  { GAMEPAD_XBOX,             0x0c12, 0x8810, "Zeroplus Xbox Controller" },
-  { GAMEPAD_XBOX,             0x0c12, 0x9902, "HAMA VibraX - *FAULTY HARDWARE*" },
-  { GAMEPAD_XBOX,             0x0e4c, 0x1097, "Radica Gamester Controller" },
-  { GAMEPAD_XBOX,             0x0e4c, 0x2390, "Radica Games Jtech Controller" },
-  { GAMEPAD_XBOX,             0x0e6f, 0x0003, "Logic3 Freebird wireless Controller" },
-  { GAMEPAD_XBOX,             0x0e6f, 0x0005, "Eclipse wireless Controller" },
-  { GAMEPAD_XBOX,             0x0e6f, 0x0006, "Edge wireless Controller" },
-  { GAMEPAD_XBOX,             0x0e8f, 0x0201, "SmartJoy Frag Xpad/PS2 adaptor" },
-  { GAMEPAD_XBOX,             0x0f30, 0x0202, "Joytech Advanced Controller" },
-  { GAMEPAD_XBOX,             0x0f30, 0x8888, "BigBen XBMiniPad Controller" },
-  { GAMEPAD_XBOX,             0x102c, 0xff0c, "Joytech Wireless Advanced Controller" },
-  { GAMEPAD_XBOX,             0x044f, 0x0f07, "Thrustmaster, Inc. Controller" },
-  { GAMEPAD_XBOX,             0x0e8f, 0x3008, "Generic xbox control (dealextreme)" },
-  { GAMEPAD_XBOX360,          0x045e, 0x028e, "Microsoft Xbox 360 Controller" },
-  //{ GAMEPAD_XBOX360_PLAY_N_CHARGE, 0x045e, 0x028f, "Microsoft Xbox 360 Play&Charge Kit" },
-  { GAMEPAD_XBOX360,          0x0738, 0x4716, "Mad Catz Xbox 360 Controller" },
-  { GAMEPAD_XBOX360,          0x0738, 0x4726, "Mad Catz Xbox 360 Controller" },
-  { GAMEPAD_XBOX360,          0x0738, 0x4728, "Mad Catz Street Fighter IV FightPad" },
-  { GAMEPAD_XBOX360,          0x0738, 0x4740, "Mad Catz Beat Pad" },
-  { GAMEPAD_XBOX360,          0x0738, 0xb726, "Mad Catz Xbox controller - MW2" },
-  { GAMEPAD_XBOX360,          0x0738, 0xf738, "Super SFIV FightStick TE S" },
-  { GAMEPAD_XBOX360,          0x0738, 0x4718, "Mad Catz Street Fighter IV FightStick SE" },
-  { GAMEPAD_XBOX360,          0x0738, 0x4738, "Mad Catz Street Fighter IV FightStick TE" },
-  { GAMEPAD_XBOX360,          0x0738, 0xbeef, "Mad Catz Xbox 360 Controller" },
-  { GAMEPAD_XBOX360,          0x0f0d, 0x000a, "Hori Co. DOA4 FightStick" },
-  { GAMEPAD_XBOX360,          0x0f0d, 0x000d, "Hori Fighting Stick Ex2" },
-  { GAMEPAD_XBOX360,          0x0f0d, 0x0016, "Hori Real Arcade Pro Ex" },
-  { GAMEPAD_XBOX360,          0x24c6, 0x5501, "Hori Real Arcade Pro VX-SA" },
-  { GAMEPAD_XBOX360,          0x24c6, 0x5303, "Xbox Airflo wired controller" },
-  { GAMEPAD_XBOX360,          0x24c6, 0x550d, "Hori GEM Xbox controller" },
-  { GAMEPAD_XBOX360,          0x162e, 0xbeef, "Joytech Neo-Se Take2" },
-  { GAMEPAD_XBOX360,          0x044f, 0xb326, "Thrustmaster Gamepad GP XID" },
-  { GAMEPAD_XBOX360,          0x046d, 0xc21d, "Logitech F310" },
-  { GAMEPAD_XBOX360,          0x046d, 0xc21e, "Logitech F510" },
-  { GAMEPAD_XBOX360,          0x046d, 0xc21f, "Logitech F710" },
-  { GAMEPAD_XBOX360,          0x046d, 0xc242, "Logitech ChillStream" },
-  { GAMEPAD_XBOX360,          0x0738, 0xcb03, "Saitek P3200 Rumble Pad - PC/Xbox 360" },
-  { GAMEPAD_XBOX360,          0x0738, 0xcb02, "Saitek Cyborg Rumble Pad - PC/Xbox 360" },
-  { GAMEPAD_XBOX360,          0x0e6f, 0x0201, "Pelican TSZ360 Pad" },
-  { GAMEPAD_XBOX360,          0x0e6f, 0x0113, "Afterglow AX.1 Gamepad for Xbox 360" },
-  { GAMEPAD_XBOX360,          0x0e6f, 0x0213, "Afterglow Gamepad for Xbox 360" },
-  { GAMEPAD_XBOX360,          0x0e6f, 0x0401, "Logic3 Controller" },
-  { GAMEPAD_XBOX360,          0x0e6f, 0x0301, "Logic3 Controller" },
-  { GAMEPAD_XBOX360,          0x12ab, 0x0301, "PDP AFTERGLOW AX.1" },
-  { GAMEPAD_XBOX360_GUITAR,   0x1430, 0x4748, "RedOctane Guitar Hero X-plorer" },
-  { GAMEPAD_XBOX360_GUITAR,   0x1bad, 0x0002, "Harmonix Guitar for Xbox 360" },
-  { GAMEPAD_XBOX360_GUITAR,   0x1bad, 0x0003, "Harmonix Drum Kit for Xbox 360" },
-  { GAMEPAD_XBOX360,          0x1bad, 0xf016, "Mad Catz Xbox 360 Controller" },
-  { GAMEPAD_XBOX360,          0x1bad, 0xf023, "MLG Pro Circuit Controller (Xbox)" },
-  { GAMEPAD_XBOX360,          0x1bad, 0xf028, "Street Fighter IV FightPad" },
-  { GAMEPAD_XBOX360,          0x1bad, 0xf038, "Street Fighter IV FightStick TE" },
-  { GAMEPAD_XBOX360,          0x1bad, 0xf900, "Harmonix Xbox 360 Controller" },
-  { GAMEPAD_XBOX360,          0x1bad, 0xf901, "Gamestop Xbox 360 Controller" },
-  { GAMEPAD_XBOX360,          0x1bad, 0xf903, "Tron Xbox 360 controller" },
-  { GAMEPAD_XBOX360,          0x15e4, 0x3f00, "Power A Mini Pro Elite" },
-  { GAMEPAD_XBOX360,          0x15e4, 0x3f10, "Batarang Xbox 360 controller" },
-  { GAMEPAD_XBOX360_WIRELESS, 0x045e, 0x0291, "Microsoft Xbox 360 Wireless Controller" }, // RF Module from the Xbox360
-  { GAMEPAD_XBOX360_WIRELESS, 0x045e, 0x0719, "Microsoft Xbox 360 Wireless Controller (PC)" }, // official Wireless Receiver
-  { GAMEPAD_XBOX360,          0x24c6, 0x5000, "Razer Atrox Arcade Stick" },
-  { GAMEPAD_XBOX360,          0x1689, 0xfd00, "Razer Onza" },
-  { GAMEPAD_XBOX360,          0x1689, 0xfd01, "Razer Onza Tournament Edition" },
-  { GAMEPAD_XBOX360,          0x1532, 0x0037, "Razer Sabertooth" },
-  { GAMEPAD_XBOX360,          0x12ab, 0x0004, "DDR Universe 2 Mat" },
-  { GAMEPAD_XBOX360,          0x15e4, 0x3f0a, "Xbox Airflo wired controller" },
-  { GAMEPAD_XBOX360,          0x24c6, 0x5300, "Power A Mini Pro Elite Glow" },
-  { GAMEPAD_XBOX360,          0x24c6, 0x5500, "Hori XBOX 360 EX 2 with Turbo" },
-  { GAMEPAD_XBOX360,          0x24c6, 0x5506, "Hori SOULCALIBUR V Stick" },
-  { GAMEPAD_XBOX360,          0x24c6, 0x5b02, "Thrustmaster, Inc. GPX Controller" },
-  { GAMEPAD_XBOX360,          0x0e6f, 0x021f, "Rock Candy Gamepad for Xbox 360" },
-
-  { GAMEPAD_XBOX_MAT,         0x0738, 0x4540, "Mad Catz Beat Pad" },
-  { GAMEPAD_XBOX_MAT,         0x0738, 0x6040, "Mad Catz Beat Pad Pro" },
-  { GAMEPAD_XBOX_MAT,         0x0c12, 0x8809, "RedOctane Xbox Dance Pad" },
-  { GAMEPAD_XBOX_MAT,         0x12ab, 0x8809, "Xbox DDR dancepad" },
-  // { GAMEPAD_XBOX_MAT,         0x1430, 0x8888, "TX6500+ Dance Pad (first generation)" }, // just a HID device, not Xbox1
-
-  { GAMEPAD_FIRESTORM,        0x044f, 0xb304, "ThrustMaster, Inc. Firestorm Dual Power" },
-  { GAMEPAD_FIRESTORM_VSB,    0x044f, 0xb312, "ThrustMaster, Inc. Firestorm Dual Power (vs b)" },
-
-  { GAMEPAD_SAITEK_P2500,     0x06a3, 0xff0c, "Saitek P2500" },
-  { GAMEPAD_SAITEK_P3600,     0x06a3, 0xf51a, "Saitek P3600 (Cyborg Rumble)" },
-
-  { GAMEPAD_PLAYSTATION3_USB, 0x054c, 0x0268, "PLAYSTATION(R)3 Controller" }
+  { GAMEPAD_XBOX,             0x045e, 0x0202, "Microsoft X-Box pad v1 (US)", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x045e, 0x0285, "Microsoft X-Box pad (Japan)", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x045e, 0x0285, "Microsoft Xbox Controller S", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x045e, 0x0287, "Microsoft Xbox Controller S", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x045e, 0x0289, "Microsoft Corp. Xbox Controller S", 0, 0, XPAD_QUIRK_NONE },
+  // { GAMEPAD_XBOX,          0x045e, 0x0288, "Microsoft Corp. Xbox Controller S Hub", 0, 0, XPAD_QUIRK_NONE },  memory card slot
+  { GAMEPAD_XBOX,             0x046d, 0xca84, "Logitech Xbox Cordless Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x046d, 0xca88, "Logitech Compact Controller for Xbox", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x05fd, 0x1007, "Mad Catz Controller (unverified)", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x05fd, 0x107a, "InterAct 'PowerPad Pro' X-Box pad (Germany)", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0738, 0x4516, "Mad Catz Control Pad", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0738, 0x4522, "Mad Catz LumiCON", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0738, 0x4526, "Mad Catz Control Pad Pro", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0738, 0x4536, "Mad Catz MicroCON", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0738, 0x4556, "Mad Catz Lynx Wireless Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0c12, 0x8802, "Zeroplus Xbox Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0c12, 0x8810, "Zeroplus Xbox Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0c12, 0x9902, "HAMA VibraX - *FAULTY HARDWARE*", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0e4c, 0x1097, "Radica Gamester Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0e4c, 0x2390, "Radica Games Jtech Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0e6f, 0x0003, "Logic3 Freebird wireless Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0e6f, 0x0005, "Eclipse wireless Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0e6f, 0x0006, "Edge wireless Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0e8f, 0x0201, "SmartJoy Frag Xpad/PS2 adaptor", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0f30, 0x0202, "Joytech Advanced Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0f30, 0x8888, "BigBen XBMiniPad Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x102c, 0xff0c, "Joytech Wireless Advanced Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x044f, 0x0f07, "Thrustmaster, Inc. Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX,             0x0e8f, 0x3008, "Generic xbox control (dealextreme)", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x045e, 0x028e, "Microsoft Xbox 360 Controller", 0, 0, XPAD_QUIRK_NONE },
+  //{ GAMEPAD_XBOX360_PLAY_N_CHARGE, 0x045e, 0x028f, "Microsoft Xbox 360 Play&Charge Kit", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0x4716, "Mad Catz Xbox 360 Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0x4726, "Mad Catz Xbox 360 Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0x4728, "Mad Catz Street Fighter IV FightPad", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0x4740, "Mad Catz Beat Pad", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0xb726, "Mad Catz Xbox controller - MW2", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0xf738, "Super SFIV FightStick TE S", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0x4718, "Mad Catz Street Fighter IV FightStick SE", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0x4738, "Mad Catz Street Fighter IV FightStick TE", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0xbeef, "Mad Catz Xbox 360 Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0f0d, 0x000a, "Hori Co. DOA4 FightStick", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0f0d, 0x000d, "Hori Fighting Stick Ex2", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0f0d, 0x0016, "Hori Real Arcade Pro Ex", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x24c6, 0x5501, "Hori Real Arcade Pro VX-SA", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x24c6, 0x5303, "Xbox Airflo wired controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x24c6, 0x550d, "Hori GEM Xbox controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x162e, 0xbeef, "Joytech Neo-Se Take2", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x044f, 0xb326, "Thrustmaster Gamepad GP XID", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x046d, 0xc21d, "Logitech F310", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x046d, 0xc21e, "Logitech F510", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x046d, 0xc21f, "Logitech F710", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x046d, 0xc242, "Logitech ChillStream", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0xcb03, "Saitek P3200 Rumble Pad - PC/Xbox 360", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0738, 0xcb02, "Saitek Cyborg Rumble Pad - PC/Xbox 360", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0e6f, 0x0201, "Pelican TSZ360 Pad", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0e6f, 0x0113, "Afterglow AX.1 Gamepad for Xbox 360", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0e6f, 0x0213, "Afterglow Gamepad for Xbox 360", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0e6f, 0x0401, "Logic3 Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0e6f, 0x0301, "Logic3 Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x12ab, 0x0301, "PDP AFTERGLOW AX.1", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360_GUITAR,   0x1430, 0x4748, "RedOctane Guitar Hero X-plorer", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360_GUITAR,   0x1bad, 0x0002, "Harmonix Guitar for Xbox 360", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360_GUITAR,   0x1bad, 0x0003, "Harmonix Drum Kit for Xbox 360", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1bad, 0xf016, "Mad Catz Xbox 360 Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1bad, 0xf023, "MLG Pro Circuit Controller (Xbox)", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1bad, 0xf028, "Street Fighter IV FightPad", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1bad, 0xf038, "Street Fighter IV FightStick TE", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1bad, 0xf900, "Harmonix Xbox 360 Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1bad, 0xf901, "Gamestop Xbox 360 Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1bad, 0xf903, "Tron Xbox 360 controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x15e4, 0x3f00, "Power A Mini Pro Elite", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x15e4, 0x3f10, "Batarang Xbox 360 controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360_WIRELESS, 0x045e, 0x0291, "Microsoft Xbox 360 Wireless Controller", 0, 0, XPAD_QUIRK_NONE }, // RF Module from the Xbox360
+  { GAMEPAD_XBOX360_WIRELESS, 0x045e, 0x0719, "Microsoft Xbox 360 Wireless Controller (PC)", 0, 0, XPAD_QUIRK_NONE }, // official Wireless Receiver
+  { GAMEPAD_XBOX360,          0x24c6, 0x5000, "Razer Atrox Arcade Stick", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1689, 0xfd00, "Razer Onza", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1689, 0xfd01, "Razer Onza Tournament Edition", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x1532, 0x0037, "Razer Sabertooth", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x12ab, 0x0004, "DDR Universe 2 Mat", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x15e4, 0x3f0a, "Xbox Airflo wired controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x24c6, 0x5300, "Power A Mini Pro Elite Glow", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x24c6, 0x5500, "Hori XBOX 360 EX 2 with Turbo", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x24c6, 0x5506, "Hori SOULCALIBUR V Stick", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x24c6, 0x5b02, "Thrustmaster, Inc. GPX Controller", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX360,          0x0e6f, 0x021f, "Rock Candy Gamepad for Xbox 360", 0, 0, XPAD_QUIRK_NONE },
+
+  { GAMEPAD_XBOX_MAT,         0x0738, 0x4540, "Mad Catz Beat Pad", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX_MAT,         0x0738, 0x6040, "Mad Catz Beat Pad Pro", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX_MAT,         0x0c12, 0x8809, "RedOctane Xbox Dance Pad", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_XBOX_MAT,         0x12ab, 0x8809, "Xbox DDR dancepad", 0, 0, XPAD_QUIRK_NONE },
+  // { GAMEPAD_XBOX_MAT,         0x1430, 0x8888, "TX6500+ Dance Pad (first generation)", 0, 0, XPAD_QUIRK_NONE }, // just a HID device, not Xbox1
+
+  { GAMEPAD_FIRESTORM,        0x044f, 0xb304, "ThrustMaster, Inc. Firestorm Dual Power", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_FIRESTORM_VSB,    0x044f, 0xb312, "ThrustMaster, Inc. Firestorm Dual Power (vs b)", 0, 0, XPAD_QUIRK_NONE },
+
+  { GAMEPAD_SAITEK_P2500,     0x06a3, 0xff0c, "Saitek P2500", 0, 0, XPAD_QUIRK_NONE },
+  { GAMEPAD_SAITEK_P3600,     0x06a3, 0xf51a, "Saitek P3600 (Cyborg Rumble)", 0, 0, XPAD_QUIRK_NONE },
+
+  { GAMEPAD_PLAYSTATION3_USB, 0x054c, 0x0268, "PLAYSTATION(R)3 Controller", 0, 0, XPAD_QUIRK_NONE }
 };
 
 const int xpad_devices_count = sizeof(xpad_devices)/sizeof(XPadDevice);
 
-bool find_xpad_device(uint16_t idVendor, uint16_t idProduct, XPadDevice* dev_type)
+namespace {
+
+bool xpad_device_less(const XPadDevice& lhs, const XPadDevice& rhs)
+{
+  if (lhs.idVendor < rhs.idVendor)
+  {
+    return true;
+  }
+  else if (lhs.idVendor == rhs.idVendor)
+  {
+    return lhs.idProduct < rhs.idProduct;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+/** The device index, built from xpad_devices[] on first use, a
+    stable sort is used so that with duplicate vendor:product
+    entries the first one in xpad_devices[] still wins */
+std::vector<XPadDevice>& get_xpad_device_index()
+{
+  static std::vector<XPadDevice> index;
+  static bool initialized = false;
+
+  if (!initialized)
+  {
+    index.assign(xpad_devices, xpad_devices + xpad_devices_count);
+    std::stable_sort(index.begin(), index.end(), xpad_device_less);
+    initialized = true;
+  }
+
+  return index;
+}
+
+/** Storage for the names of devices added at runtime, std::list
+    never moves its elements, so the c_str() pointers stay valid */
+std::list<std::string>& get_xpad_device_names()
 {
-  for(int i = 0; i < xpad_devices_count; ++i)
+  static std::list<std::string> names;
+  return names;
+}
+
+unsigned int str2xpad_quirks(const std::string& str)
+{
+  unsigned int quirks = XPAD_QUIRK_NONE;
+
+  typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+  tokenizer tokens(str, boost::char_separator<char>(", "));
+  for(tokenizer::iterator t = tokens.begin(); t != tokens.end(); ++t)
   {
-    if (idVendor  == xpad_devices[i].idVendor &&
-        idProduct == xpad_devices[i].idProduct)
+    if (*t == "detach-kernel-driver")
+    {
+      quirks |= XPAD_QUIRK_DETACH_KERNEL_DRIVER;
+    }
+    else
     {
-      *dev_type = xpad_devices[i];
-      return true;
+      raise_exception(std::runtime_error, "unknown quirk: " << *t);
     }
   }
-  return false;
+
+  return quirks;
+}
+
+class XPadDeviceFileBuilder : public INIBuilder
+{
+private:
+  bool m_valid;
+  XPadDevice m_dev;
+  std::string m_name;
+
+public:
+  XPadDeviceFileBuilder() :
+    m_valid(false),
+    m_dev(),
+    m_name()
+  {}
+
+  void send_section(const std::string& section)
+  {
+    flush();
+
+    std::string vendor;
+    std::string product;
+    split_string_at(section, ':', &vendor, &product);
+    if (vendor.empty() || product.empty())
+    {
+      raise_exception(std::runtime_error, "section must be VENDOR:PRODUCT: " << section);
+    }
+
+    m_dev = XPadDevice();
+    m_dev.type      = GAMEPAD_UNKNOWN;
+    m_dev.idVendor  = static_cast<uint16_t>(hexstr2int(vendor));
+    m_dev.idProduct = static_cast<uint16_t>(hexstr2int(product));
+    m_name = section;
+    m_valid = true;
+  }
+
+  void send_pair(const std::string& name, const std::string& value)
+  {
+    if (!m_valid)
+    {
+      raise_exception(std::runtime_error, "'" << name << "' outside of a VENDOR:PRODUCT section");
+    }
+    else if (name == "type")
+    {
+      m_dev.type = gamepadtype_from_string(value);
+      if (m_dev.type == GAMEPAD_UNKNOWN)
+      {
+        raise_exception(std::runtime_error, "unknown type: " << value);
+      }
+    }
+    else if (name == "name")
+    {
+      m_name = value;
+    }
+    else if (name == "if" || name == "interface")
+    {
+      m_dev.interface = boost::lexical_cast<int>(value);
+    }
+    else if (name == "ep" || name == "endpoint")
+    {
+      m_dev.endpoint = boost::lexical_cast<int>(value);
+    }
+    else if (name == "quirks")
+    {
+      m_dev.quirks = str2xpad_quirks(value);
+    }
+    else
+    {
+      raise_exception(std::runtime_error, "unknown name: " << name);
+    }
+  }
+
+  void flush()
+  {
+    if (m_valid)
+    {
+      if (m_dev.type == GAMEPAD_UNKNOWN)
+      {
+        raise_exception(std::runtime_error, "no type given for " << m_name);
+      }
+
+      get_xpad_device_names().push_back(m_name);
+      m_dev.name = get_xpad_device_names().back().c_str();
+      add_xpad_device(m_dev);
+      m_valid = false;
+    }
+  }
+};
+
+} // namespace
+
+bool find_xpad_device(uint16_t idVendor, uint16_t idProduct, XPadDevice* dev_type)
+{
+  const std::vector<XPadDevice>& index = get_xpad_device_index();
+
+  XPadDevice key = XPadDevice();
+  key.idVendor  = idVendor;
+  key.idProduct = idProduct;
+
+  std::vector<XPadDevice>::const_iterator it = std::lower_bound(index.begin(), index.end(), key, xpad_device_less);
+  if (it != index.end() &&
+      it->idVendor  == idVendor &&
+      it->idProduct == idProduct)
+  {
+    *dev_type = *it;
+    return true;
+  }
+  else
+  {
+    return false;
+  }
 }
 
+void add_xpad_device(const XPadDevice& dev)
+{
+  std::vector<XPadDevice>& index = get_xpad_device_index();
+
+  std::vector<XPadDevice>::iterator it = std::lower_bound(index.begin(), index.end(), dev, xpad_device_less);
+  if (it != index.end() &&
+      it->idVendor  == dev.idVendor &&
+      it->idProduct == dev.idProduct)
+  {
+    *it = dev;
+  }
+  else
+  {
+    index.insert(it, dev);
+  }
+}
+
+void read_xpad_device_file(const std::string& filename)
+{
+  log_info("reading device file '" << filename << "'");
+
+  std::ifstream in(filename.c_str());
+  if (!in)
+  {
+    raise_exception(std::runtime_error, "couldn't open: " << filename);
+  }
+  else
+  {
+    XPadDeviceFileBuilder builder;
+    INIParser parser(in, builder, filename);
+    parser.run();
+    builder.flush();
+  }
+}
+
+const std::vector<XPadDevice>& get_xpad_devices()
+{
+  return get_xpad_device_index();
+}
+
 /* EOF */
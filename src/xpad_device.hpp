@@ -20,21 +20,59 @@
 #define HEADER_XPAD_DEVICES_HPP
 
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 #include "xboxmsg.hpp"
 
+enum XPadQuirk {
+  XPAD_QUIRK_NONE                 = 0,
+  /** always detach the kernel driver, regardless of --detach-kernel-driver */
+  XPAD_QUIRK_DETACH_KERNEL_DRIVER = (1<<0)
+};
+
 struct XPadDevice
 {
   GamepadType type;
   uint16_t    idVendor;
   uint16_t    idProduct;
   const char* name;
+
+  /** interface and endpoint used by GAMEPAD_GENERIC_USB, an endpoint
+      of 0 means that they are not set and --generic-usb-spec is used */
+  int interface;
+  int endpoint;
+
+  /** bitmask of XPadQuirk */
+  unsigned int quirks;
 };
 
 /** Search for an xpad device matching the \a idVendor, \a idProduct
-    values, the first \a skip matches will be ignored */
+    values, this is a binary search on an index sorted by
+    vendor:product, so it is cheap enough to run on every hotplug
+    event */
 bool find_xpad_device(uint16_t idVendor, uint16_t idProduct, XPadDevice* dev_type);
 
+/** Add a device to the index, an already existing entry with the
+    same vendor:product is replaced */
+void add_xpad_device(const XPadDevice& dev);
+
+/** Read additional devices from an INI style file, each section is a
+    vendor:product pair:
+
+    [045e:028e]
+    type = xbox360
+    name = Microsoft Xbox 360 Controller
+    interface = 0
+    endpoint = 1
+    quirks = detach-kernel-driver
+*/
+void read_xpad_device_file(const std::string& filename);
+
+/** All known devices, including those added at runtime, sorted by
+    vendor:product */
+const std::vector<XPadDevice>& get_xpad_devices();
+
 extern XPadDevice xpad_devices[];
 extern const int xpad_devices_count;
 
@@ -0,0 +1,55 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <string.h>
+
+#include "force_feedback_handler.hpp"
+
+int main(int argc, char** argv)
+{
+  ForceFeedbackHandler handler;
+
+  struct ff_effect effect;
+  memset(&effect, 0, sizeof(effect));
+  effect.type = FF_PERIODIC;
+  effect.id   = 0;
+  effect.replay.length = 500;
+  effect.u.periodic.waveform  = FF_SINE;
+  effect.u.periodic.period    = 100;
+  effect.u.periodic.magnitude = 0x7fff;
+  effect.u.periodic.envelope.attack_length = 100;
+  effect.u.periodic.envelope.fade_length   = 100;
+
+  handler.upload(effect);
+  handler.play(0, 2);
+
+  for(int msec = 0; msec < 1100; msec += 10)
+  {
+    if (handler.update(10000))
+    {
+      std::cout << msec << ": "
+                << handler.get_strong_magnitude() << " "
+                << handler.get_weak_magnitude() << std::endl;
+    }
+  }
+
+  return 0;
+}
+
+/* EOF */
@@ -0,0 +1,101 @@
+/*
+**  Xbox360 USB Gamepad Userspace Driver
+**  Copyright (C) 2011 Ingo Ruhnke <grumbel@gmail.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <string.h>
+#include <vector>
+
+#include "command_line_options.hpp"
+#include "controller_config.hpp"
+#include "controller_slot_config.hpp"
+#include "evdev_helper.hpp"
+#include "options.hpp"
+#include "uinput.hpp"
+#include "uinput_backend.hpp"
+#include "uinput_config.hpp"
+#include "xboxmsg.hpp"
+
+int main(int argc, char** argv)
+{
+  // the default mapping with the events going to the memory backend,
+  // further command line options can be appended
+  std::vector<const char*> args;
+  args.push_back("xboxdrv");
+  args.push_back("--silent");
+  args.push_back("--uinput-backend");
+  args.push_back("memory");
+  for(int i = 1; i < argc; ++i)
+  {
+    args.push_back(argv[i]);
+  }
+
+  Options opts;
+  CommandLineParser parser;
+  parser.parse_args(static_cast<int>(args.size()), const_cast<char**>(&args[0]), &opts);
+
+  UInput uinput(opts.extra_events);
+  uinput.set_backend(opts.uinput_backend);
+  ControllerSlotConfigPtr config = ControllerSlotConfig::create(uinput, 0, opts.extra_devices,
+                                                                opts.get_controller_slot());
+  uinput.finish();
+
+  XboxGenericMsg msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.type = XBOX_MSG_XBOX360;
+  msg.xbox360.a  = 1;
+  msg.xbox360.x1 = 32767;
+  msg.xbox360.lt = 255;
+
+  config->get_config()->get_uinput().send(msg);
+  uinput.sync();
+
+  MemoryUInputBackend* backend =
+    dynamic_cast<MemoryUInputBackend*>(uinput.get_backend(UInput::create_device_id(0, DEVICEID_JOYSTICK)));
+  if (!backend)
+  {
+    std::cout << "error: no memory backend for the joystick" << std::endl;
+    return 1;
+  }
+
+  std::vector<struct input_event> events = backend->get_events();
+  for(std::vector<struct input_event>::const_iterator ev = events.begin(); ev != events.end(); ++ev)
+  {
+    switch(ev->type)
+    {
+      case EV_KEY:
+        std::cout << "key " << key2str(ev->code) << " " << ev->value << std::endl;
+        break;
+
+      case EV_ABS:
+        std::cout << "abs " << abs2str(ev->code) << " " << ev->value << std::endl;
+        break;
+
+      case EV_SYN:
+        std::cout << "syn" << std::endl;
+        break;
+
+      default:
+        std::cout << "type " << ev->type << " code " << ev->code << " " << ev->value << std::endl;
+        break;
+    }
+  }
+
+  return 0;
+}
+
+/* EOF */
@@ -31,6 +31,14 @@ int main(int argc, char** argv)
   std::cout << "uint32be: " << unpack::uint32be(data) << std::endl;
   std::cout << "uint32le: " << unpack::uint32le(data) << std::endl;
 
+  // unaligned
+  uint8_t report[] = { 0x00, 0xff, 0x7f, 0x00, 0x80 };
+  int16_t axes[2];
+  unpack::int16le_array(report+1, axes, 2);
+  std::cout << std::dec;
+  std::cout << "int16le: " << unpack::int16le(report+1) << " " << unpack::int16le(report+3) << std::endl;
+  std::cout << "int16le_array: " << axes[0] << " " << axes[1] << std::endl;
+
   return 0;
 }
 